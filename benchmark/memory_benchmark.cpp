@@ -0,0 +1,587 @@
+/*
+
+  NOTE: Allocator benchmarks. Every run prints one JSON object per line so results can be diffed/graphed between commits:
+
+    {"workload": ..., "allocator": ..., "threads": ..., "ops": ..., "ns_per_op": ..., "max_ns": ..., "p99_ns": ...,
+     "minor_faults": ..., "major_faults": ..., "rss_bytes": ..., "os_calls": ...}
+
+  os_calls counts the calls our arenas made into the OS memory api (MemoryOsStats), malloc doesn't go through it so it reports 0.
+  max_ns/p99_ns are only filled in by workloads that time every op. Pass --quick to run every workload with 1/10th of the ops.
+
+ */
+
+#include "math/types.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+static u64 BenchScale = 10;
+
+//
+// NOTE: Counters
+//
+
+struct bench_counters
+{
+    u64 TimeNs;
+    u64 MinorFaults;
+    u64 MajorFaults;
+    u64 RssBytes;
+    u64 OsCalls;
+};
+
+inline u64 BenchGetTimeNs()
+{
+    u64 Result = u64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    return Result;
+}
+
+inline bench_counters BenchSample()
+{
+    bench_counters Result = {};
+    Result.TimeNs = BenchGetTimeNs();
+    Result.OsCalls = (MemoryOsStats.NumReserves + MemoryOsStats.NumCommits + MemoryOsStats.NumDecommits +
+                      MemoryOsStats.NumReleases + MemoryOsStats.NumPurges);
+
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS MemoryCounters = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), &MemoryCounters, sizeof(MemoryCounters));
+    Result.MinorFaults = MemoryCounters.PageFaultCount;
+    Result.RssBytes = MemoryCounters.WorkingSetSize;
+#else
+    rusage Usage = {};
+    getrusage(RUSAGE_SELF, &Usage);
+    Result.MinorFaults = u64(Usage.ru_minflt);
+    Result.MajorFaults = u64(Usage.ru_majflt);
+
+    // NOTE: Current RSS (ru_maxrss is the peak) from statm, second field is resident pages
+    FILE* StatFile = fopen("/proc/self/statm", "r");
+    if (StatFile)
+    {
+        unsigned long long NumPages = 0, NumResident = 0;
+        if (fscanf(StatFile, "%llu %llu", &NumPages, &NumResident) == 2)
+        {
+            Result.RssBytes = u64(NumResident) * MemoryGetPageSize();
+        }
+        fclose(StatFile);
+    }
+#endif
+
+    return Result;
+}
+
+struct bench_run
+{
+    const char* Workload;
+    const char* Allocator;
+    u32 NumThreads;
+    bench_counters Start;
+    u64 MaxNs;
+    u64 P99Ns;
+};
+
+inline bench_run BenchBegin(const char* Workload, const char* Allocator, u32 NumThreads = 1)
+{
+    bench_run Result = {};
+    Result.Workload = Workload;
+    Result.Allocator = Allocator;
+    Result.NumThreads = NumThreads;
+    Result.Start = BenchSample();
+
+    return Result;
+}
+
+inline void BenchEnd(bench_run* Run, u64 NumOps)
+{
+    bench_counters End = BenchSample();
+    f64 NsPerOp = f64(End.TimeNs - Run->Start.TimeNs) / f64(Max(NumOps, u64(1)));
+
+    printf("{\"workload\": \"%s\", \"allocator\": \"%s\", \"threads\": %u, \"ops\": %llu, \"ns_per_op\": %.3f, \"max_ns\": %llu, "
+           "\"p99_ns\": %llu, \"minor_faults\": %llu, \"major_faults\": %llu, \"rss_bytes\": %llu, \"os_calls\": %llu}\n",
+           Run->Workload, Run->Allocator, Run->NumThreads, (unsigned long long)NumOps, NsPerOp,
+           (unsigned long long)Run->MaxNs, (unsigned long long)Run->P99Ns,
+           (unsigned long long)(End.MinorFaults - Run->Start.MinorFaults), (unsigned long long)(End.MajorFaults - Run->Start.MajorFaults),
+           (unsigned long long)End.RssBytes, (unsigned long long)(End.OsCalls - Run->Start.OsCalls));
+    fflush(stdout);
+}
+
+inline void BenchSetLatencies(bench_run* Run, std::vector<u64>* Latencies)
+{
+    if (!Latencies->empty())
+    {
+        std::sort(Latencies->begin(), Latencies->end());
+        Run->MaxNs = Latencies->back();
+        Run->P99Ns = (*Latencies)[(Latencies->size() * 99) / 100];
+    }
+}
+
+//
+// NOTE: Malloc arena, lets the workloads treat malloc like our arenas
+//
+
+struct malloc_arena
+{
+    std::vector<void*> Allocations;
+};
+
+inline void* BenchMalloc(mm Size, mm Alignment)
+{
+#if defined(_WIN32)
+    void* Result = _aligned_malloc(Size, Max(Alignment, mm(16)));
+#else
+    void* Result = 0;
+    if (Alignment <= 16)
+    {
+        Result = malloc(Size);
+    }
+    else if (posix_memalign(&Result, Alignment, Size) != 0)
+    {
+        Result = 0;
+    }
+#endif
+    return Result;
+}
+
+inline void BenchFree(void* Mem)
+{
+#if defined(_WIN32)
+    _aligned_free(Mem);
+#else
+    free(Mem);
+#endif
+}
+
+inline void* PushSizeAligned(malloc_arena* Arena, mm Size, mm Alignment)
+{
+    void* Result = BenchMalloc(Size, Alignment);
+    Arena->Allocations.push_back(Result);
+    return Result;
+}
+
+inline void ArenaClear(malloc_arena* Arena)
+{
+    for (void* Allocation : Arena->Allocations)
+    {
+        BenchFree(Allocation);
+    }
+    Arena->Allocations.clear();
+}
+
+inline void ArenaClear(linear_arena* Arena)
+{
+    LinearArenaClear(Arena);
+}
+
+//
+// NOTE: Random numbers (xorshift, so every allocator sees the same sequence)
+//
+
+inline u64 BenchRandom(u64* State)
+{
+    u64 X = *State;
+    X ^= X << 13;
+    X ^= X >> 7;
+    X ^= X << 17;
+    *State = X;
+    return X;
+}
+
+//
+// NOTE: Workloads
+//
+
+template<typename arena>
+inline void BenchBumpBurst(const char* Allocator, arena* Arena)
+{
+    // NOTE: Lots of small pushes followed by a clear, like building a frame or a request
+    u64 NumRounds = 10 * BenchScale;
+    u64 NumPushes = 10000;
+
+    bench_run Run = BenchBegin("bump_burst", Allocator);
+    for (u64 Round = 0; Round < NumRounds; ++Round)
+    {
+        for (u64 PushId = 0; PushId < NumPushes; ++PushId)
+        {
+            u8* Mem = (u8*)PushSizeAligned(Arena, 64, 8);
+            Mem[0] = u8(PushId);
+        }
+        ArenaClear(Arena);
+    }
+    BenchEnd(&Run, NumRounds * NumPushes);
+}
+
+template<typename arena, typename temp>
+inline void BenchTempCycle(const char* Allocator, arena* Arena)
+{
+    // NOTE: Push/pop temp mem around a handful of allocations, the next cycle reuses the same memory
+    u64 NumCycles = 10000 * BenchScale;
+    u64 NumPushes = 32;
+
+    bench_run Run = BenchBegin("temp_cycle", Allocator);
+    for (u64 Cycle = 0; Cycle < NumCycles; ++Cycle)
+    {
+        temp TempMem = BeginTempMem(Arena);
+        for (u64 PushId = 0; PushId < NumPushes; ++PushId)
+        {
+            // NOTE: Every 64th cycle pushes past a block so arenas that give blocks back on EndTempMem show it
+            mm Size = (Cycle % 64 == 0 && PushId == 0) ? KiloBytes(256) : 128;
+            u8* Mem = (u8*)PushSizeAligned(Arena, Size, 16);
+            Mem[0] = u8(PushId);
+        }
+        EndTempMem(TempMem);
+    }
+    BenchEnd(&Run, NumCycles * NumPushes);
+}
+
+inline void BenchTempCycleMalloc()
+{
+    u64 NumCycles = 10000 * BenchScale;
+    u64 NumPushes = 32;
+    void* Allocations[32];
+
+    bench_run Run = BenchBegin("temp_cycle", "malloc");
+    for (u64 Cycle = 0; Cycle < NumCycles; ++Cycle)
+    {
+        for (u64 PushId = 0; PushId < NumPushes; ++PushId)
+        {
+            mm Size = (Cycle % 64 == 0 && PushId == 0) ? KiloBytes(256) : 128;
+            u8* Mem = (u8*)BenchMalloc(Size, 16);
+            Mem[0] = u8(PushId);
+            Allocations[PushId] = Mem;
+        }
+        for (u64 PushId = 0; PushId < NumPushes; ++PushId)
+        {
+            BenchFree(Allocations[PushId]);
+        }
+    }
+    BenchEnd(&Run, NumCycles * NumPushes);
+}
+
+template<typename arena>
+inline void BenchSubArenas(const char* Allocator, arena* Arenas, u32 NumArenas)
+{
+    // NOTE: Many arenas for different systems pushing in round robin, then everything gets cleared
+    u64 NumRounds = BenchScale;
+    u64 NumPushes = 100000;
+
+    bench_run Run = BenchBegin("sub_arenas", Allocator);
+    for (u64 Round = 0; Round < NumRounds; ++Round)
+    {
+        for (u64 PushId = 0; PushId < NumPushes; ++PushId)
+        {
+            u8* Mem = (u8*)PushSizeAligned(Arenas + (PushId % NumArenas), 48, 8);
+            Mem[0] = u8(PushId);
+        }
+        for (u32 ArenaId = 0; ArenaId < NumArenas; ++ArenaId)
+        {
+            ArenaClear(Arenas + ArenaId);
+        }
+    }
+    BenchEnd(&Run, NumRounds * NumPushes);
+}
+
+template<typename arena>
+inline void BenchMixedSizes(const char* Allocator, arena* Arena, mm MaxSize)
+{
+    // NOTE: Random sizes and power of 2 alignments up to 64
+    u64 NumRounds = 10 * BenchScale;
+    u64 NumPushes = 5000;
+    u64 RandomState = 0x9E3779B97F4A7C15ull;
+
+    bench_run Run = BenchBegin("mixed_sizes", Allocator);
+    for (u64 Round = 0; Round < NumRounds; ++Round)
+    {
+        for (u64 PushId = 0; PushId < NumPushes; ++PushId)
+        {
+            u64 Random = BenchRandom(&RandomState);
+            mm Size = 1 + mm(Random % MaxSize);
+            mm Alignment = mm(1) << ((Random >> 32) % 7);
+            u8* Mem = (u8*)PushSizeAligned(Arena, Size, Alignment);
+            Mem[0] = u8(PushId);
+        }
+        ArenaClear(Arena);
+    }
+    BenchEnd(&Run, NumRounds * NumPushes);
+}
+
+template<typename arena>
+inline void BenchFreeLatency(const char* Allocator, arena* Arena)
+{
+    // NOTE: Individual alloc/free with a live set that churns, every op is timed for the tail latency
+    u64 NumOps = 20000 * BenchScale;
+    u64 RandomState = 0x2545F4914F6CDD1Dull;
+    std::vector<void*> Live;
+    std::vector<u64> Latencies;
+    Live.reserve(4096);
+    Latencies.reserve(NumOps);
+
+    bench_run Run = BenchBegin("free_latency", Allocator);
+    for (u64 OpId = 0; OpId < NumOps; ++OpId)
+    {
+        u64 Random = BenchRandom(&RandomState);
+        u64 StartNs = BenchGetTimeNs();
+        if (Live.size() < 4096 && (Live.empty() || (Random & 1)))
+        {
+            mm Size = 8 + mm((Random >> 8) % 2048);
+            Live.push_back(PushSizeAligned(Arena, Size, 8));
+        }
+        else
+        {
+            mm Index = mm((Random >> 8) % Live.size());
+            FreeSize(Arena, Live[Index]);
+            Live[Index] = Live.back();
+            Live.pop_back();
+        }
+        Latencies.push_back(BenchGetTimeNs() - StartNs);
+    }
+    BenchSetLatencies(&Run, &Latencies);
+    BenchEnd(&Run, NumOps);
+
+    for (void* Mem : Live)
+    {
+        FreeSize(Arena, Mem);
+    }
+}
+
+struct malloc_free_arena
+{
+};
+
+inline void* PushSizeAligned(malloc_free_arena*, mm Size, mm Alignment)
+{
+    void* Result = BenchMalloc(Size, Alignment);
+    return Result;
+}
+
+inline void FreeSize(malloc_free_arena*, void* Mem)
+{
+    BenchFree(Mem);
+}
+
+inline void BenchZeroCopy()
+{
+    // NOTE: Our ZeroMem/Copy kernels against the CRT, ns_per_op is per call
+    mm Sizes[] = { 64, KiloBytes(4), KiloBytes(256), MegaBytes(64) };
+    u8* Src = (u8*)MemoryAllocate(MegaBytes(64) + 64);
+    u8* Dest = (u8*)MemoryAllocate(MegaBytes(64) + 64);
+    ZeroMem(Src, MegaBytes(64) + 64);
+    ZeroMem(Dest, MegaBytes(64) + 64);
+
+    for (u32 SizeId = 0; SizeId < ArrayCount(Sizes); ++SizeId)
+    {
+        mm Size = Sizes[SizeId];
+        u64 NumOps = Max(u64(1), (u64(MegaBytes(64)) * BenchScale) / u64(Size));
+        NumOps = Min(NumOps, u64(1000000) * BenchScale);
+        char Name[64];
+
+        snprintf(Name, sizeof(Name), "zero_%llu", (unsigned long long)Size);
+        bench_run Run = BenchBegin(Name, "ZeroMem");
+        for (u64 OpId = 0; OpId < NumOps; ++OpId)
+        {
+            ZeroMem(Dest + 1, Size);
+        }
+        BenchEnd(&Run, NumOps);
+
+        Run = BenchBegin(Name, "memset");
+        for (u64 OpId = 0; OpId < NumOps; ++OpId)
+        {
+            memset(Dest + 1, 0, Size);
+        }
+        BenchEnd(&Run, NumOps);
+
+        snprintf(Name, sizeof(Name), "copy_%llu", (unsigned long long)Size);
+        Run = BenchBegin(Name, "Copy");
+        for (u64 OpId = 0; OpId < NumOps; ++OpId)
+        {
+            Copy(Src + 3, Dest + 1, Size);
+        }
+        BenchEnd(&Run, NumOps);
+
+        Run = BenchBegin(Name, "memcpy");
+        for (u64 OpId = 0; OpId < NumOps; ++OpId)
+        {
+            memcpy(Dest + 1, Src + 3, Size);
+        }
+        BenchEnd(&Run, NumOps);
+    }
+
+    MemoryFree(Src, MegaBytes(64) + 64);
+    MemoryFree(Dest, MegaBytes(64) + 64);
+}
+
+//
+// NOTE: Multi threaded workloads
+//
+
+template<typename thread_func>
+inline void BenchRunThreads(const char* Workload, const char* Allocator, u32 NumThreads, u64 NumOpsPerThread, thread_func ThreadFunc)
+{
+    std::vector<std::thread> Threads;
+    bench_run Run = BenchBegin(Workload, Allocator, NumThreads);
+    for (u32 ThreadId = 0; ThreadId < NumThreads; ++ThreadId)
+    {
+        Threads.emplace_back(ThreadFunc, ThreadId);
+    }
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+    BenchEnd(&Run, NumOpsPerThread * NumThreads);
+}
+
+inline void BenchMultiThreaded()
+{
+    // NOTE: Every thread fills a block arena from one shared platform arena and clears it, the ops are block sized pushes
+    u64 NumRounds = 200 * BenchScale;
+    u64 NumPushes = 64;
+    u64 NumOpsPerThread = NumRounds * NumPushes;
+    u32 MaxThreads = Max(32u, u32(std::thread::hardware_concurrency()));
+
+    for (u32 NumThreads = 1; NumThreads <= MaxThreads; NumThreads *= 2)
+    {
+        platform_block_arena PlatformArena = PlatformBlockArenaCreate(MegaBytes(4), 256, 0, PlatformBlockArenaFlag_Concurrent);
+        BenchRunThreads("mt_block_churn", "platform_block_arena_concurrent", NumThreads, NumOpsPerThread, [&](u32)
+        {
+            block_arena Arena = BlockArenaCreate(&PlatformArena);
+            for (u64 Round = 0; Round < NumRounds; ++Round)
+            {
+                for (u64 PushId = 0; PushId < NumPushes; ++PushId)
+                {
+                    u8* Mem = (u8*)PushSizeAligned(&Arena, BlockArenaGetBlockSize(&Arena), 8);
+                    Mem[0] = u8(PushId);
+                }
+                ArenaClear(&Arena);
+            }
+            PlatformBlockArenaFlushThreadCache(&PlatformArena);
+        });
+        ArenaClear(&PlatformArena);
+
+        mm BlockSize = PlatformArena.BlockSize;
+        BenchRunThreads("mt_block_churn", "malloc", NumThreads, NumOpsPerThread, [&](u32)
+        {
+            void* Allocations[64];
+            for (u64 Round = 0; Round < NumRounds; ++Round)
+            {
+                for (u64 PushId = 0; PushId < NumPushes; ++PushId)
+                {
+                    u8* Mem = (u8*)BenchMalloc(BlockSize, 8);
+                    Mem[0] = u8(PushId);
+                    Allocations[PushId] = Mem;
+                }
+                for (u64 PushId = 0; PushId < NumPushes; ++PushId)
+                {
+                    BenchFree(Allocations[PushId]);
+                }
+            }
+        });
+
+        BenchRunThreads("mt_bump", "dynamic_arena_per_thread", NumThreads, NumOpsPerThread * 16, [&](u32)
+        {
+            dynamic_arena Arena = DynamicArenaCreate(KiloBytes(64));
+            for (u64 Round = 0; Round < NumRounds; ++Round)
+            {
+                dynamic_temp_mem TempMem = BeginTempMem(&Arena);
+                for (u64 PushId = 0; PushId < NumPushes * 16; ++PushId)
+                {
+                    u8* Mem = (u8*)PushSizeAligned(&Arena, 64, 8);
+                    Mem[0] = u8(PushId);
+                }
+                EndTempMem(TempMem);
+            }
+            DynamicArenaRelease(&Arena);
+        });
+    }
+}
+
+int main(int ArgCount, char** Args)
+{
+    for (int ArgId = 1; ArgId < ArgCount; ++ArgId)
+    {
+        if (strcmp(Args[ArgId], "--quick") == 0)
+        {
+            BenchScale = 1;
+        }
+    }
+
+    // NOTE: Single threaded workloads
+    {
+        linear_arena LinearArena = LinearArenaReserve(GigaBytes(4));
+        dynamic_arena DynamicArena = DynamicArenaCreate(KiloBytes(64));
+        platform_block_arena PlatformArena = PlatformBlockArenaCreate(MegaBytes(4), 256);
+        block_arena BlockArena = BlockArenaCreate(&PlatformArena);
+        malloc_arena MallocArena = {};
+
+        BenchBumpBurst("linear_arena", &LinearArena);
+        BenchBumpBurst("dynamic_arena", &DynamicArena);
+        BenchBumpBurst("block_arena", &BlockArena);
+        BenchBumpBurst("malloc", &MallocArena);
+
+        BenchTempCycle<linear_arena, temp_mem>("linear_arena", &LinearArena);
+        BenchTempCycle<dynamic_arena, dynamic_temp_mem>("dynamic_arena", &DynamicArena);
+        BenchTempCycleMalloc();
+
+        BenchMixedSizes("linear_arena", &LinearArena, 4096);
+        BenchMixedSizes("dynamic_arena", &DynamicArena, 4096);
+        BenchMixedSizes("block_arena", &BlockArena, 4096);
+        BenchMixedSizes("malloc", &MallocArena, 4096);
+
+        LinearArenaRelease(&LinearArena);
+        DynamicArenaRelease(&DynamicArena);
+        ArenaClear(&BlockArena);
+        ArenaClear(&PlatformArena);
+    }
+
+    {
+        u32 NumArenas = 256;
+        platform_block_arena PlatformArena = PlatformBlockArenaCreate(MegaBytes(4), 1024);
+        std::vector<block_arena> BlockArenas(NumArenas);
+        std::vector<dynamic_arena> DynamicArenas(NumArenas);
+        std::vector<malloc_arena> MallocArenas(NumArenas);
+        for (u32 ArenaId = 0; ArenaId < NumArenas; ++ArenaId)
+        {
+            BlockArenas[ArenaId] = BlockArenaCreate(&PlatformArena);
+            DynamicArenas[ArenaId] = DynamicArenaCreate(PlatformArena.BlockSize);
+        }
+
+        BenchSubArenas("block_arena", BlockArenas.data(), NumArenas);
+        BenchSubArenas("dynamic_arena", DynamicArenas.data(), NumArenas);
+        BenchSubArenas("malloc", MallocArenas.data(), NumArenas);
+        for (u32 ArenaId = 0; ArenaId < NumArenas; ++ArenaId)
+        {
+            DynamicArenaRelease(&DynamicArenas[ArenaId]);
+        }
+        ArenaClear(&PlatformArena);
+    }
+
+    {
+        platform_block_arena PlatformArena = PlatformBlockArenaCreate(MegaBytes(2), 32, 0, PlatformBlockArenaFlag_Aligned);
+        slab_arena SlabArena = SlabArenaCreate(&PlatformArena);
+        tlsf_arena TlsfArena = TlsfArenaCreate(MegaBytes(16));
+        malloc_free_arena MallocArena = {};
+
+        BenchFreeLatency("slab_arena", &SlabArena);
+        BenchFreeLatency("tlsf_arena", &TlsfArena);
+        BenchFreeLatency("malloc", &MallocArena);
+
+        ArenaClear(&SlabArena);
+        ArenaClear(&PlatformArena);
+        ArenaClear(&TlsfArena);
+    }
+
+    BenchZeroCopy();
+    BenchMultiThreaded();
+
+    return 0;
+}
@@ -1,41 +1,1286 @@
 
-#include "math\types.h"
+#include "math/types.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
 
 //
 // NOTE: Memory functions
 //
 
-inline void* MemoryAllocate(mm AllocSize)
+/*
+  NOTE: The OS backend splits memory into reserve (address space only), commit (backed by pages) and release. MemoryAllocate/MemoryFree
+  are the reserve + commit / release shorthand that the arenas use for their blocks.
+
+  Huge pages are opt in through the flags below. MemoryFlag_HugePages asks for transparent huge pages (madvise on linux, ignored on
+  windows since it has no transparent mode) while MemoryFlag_HugePagesExplicit asks for pages out of the reserved huge page pool
+  (MAP_HUGETLB / MEM_LARGE_PAGES) and falls back to transparent huge pages if the pool is empty or we lack the privilege. The same
+  flags have to be passed to release so that we round the size the same way.
+ */
+
+struct memory_os_stats
+{
+    // NOTE: Number of calls we made into the OS memory api, lets benchmarks see how often arenas hit the OS
+    volatile u64 NumReserves;
+    volatile u64 NumCommits;
+    volatile u64 NumDecommits;
+    volatile u64 NumReleases;
+    volatile u64 NumPurges;
+};
+
+static memory_os_stats MemoryOsStats;
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define MemoryOsStatsAdd(Field) _InterlockedIncrement64((volatile __int64*)&MemoryOsStats.Field)
+#else
+#define MemoryOsStatsAdd(Field) __atomic_fetch_add(&MemoryOsStats.Field, 1, __ATOMIC_RELAXED)
+#endif
+
+enum memory_flags
+{
+    MemoryFlag_None = 0,
+    MemoryFlag_HugePages = 1 << 0,
+    MemoryFlag_HugePagesExplicit = 1 << 1,
+    MemoryFlag_Untracked = 1 << 2, // NOTE: Keeps the call out of MemoryOsStats, for our own bookkeeping (debug rings)
+};
+
+inline mm MemoryGetPageSize()
+{
+    static mm PageSize = 0;
+    if (!PageSize)
+    {
+#if defined(_WIN32)
+        SYSTEM_INFO SystemInfo = {};
+        GetSystemInfo(&SystemInfo);
+        PageSize = mm(SystemInfo.dwPageSize);
+#else
+        PageSize = mm(sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+    return PageSize;
+}
+
+inline u64 MemoryGetTimeNs()
+{
+    // NOTE: Monotonic clock for profiling and decay timers
+#if defined(_WIN32)
+    static u64 Frequency = 0;
+    if (!Frequency)
+    {
+        LARGE_INTEGER FrequencyResult;
+        QueryPerformanceFrequency(&FrequencyResult);
+        Frequency = u64(FrequencyResult.QuadPart);
+    }
+
+    LARGE_INTEGER Counter;
+    QueryPerformanceCounter(&Counter);
+    u64 Seconds = u64(Counter.QuadPart) / Frequency;
+    u64 Remainder = u64(Counter.QuadPart) % Frequency;
+    u64 Result = Seconds*1000000000ull + (Remainder*1000000000ull) / Frequency;
+#else
+    timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    u64 Result = u64(Time.tv_sec)*1000000000ull + u64(Time.tv_nsec);
+#endif
+
+    return Result;
+}
+
+inline mm MemoryGetHugePageSize()
+{
+    static mm HugePageSize = 0;
+    if (!HugePageSize)
+    {
+#if defined(_WIN32)
+        HugePageSize = mm(GetLargePageMinimum());
+        if (!HugePageSize)
+        {
+            HugePageSize = MegaBytes(2);
+        }
+#else
+        // NOTE: Default huge page size of the kernel, 2MB on x64 but arm64 kernels can use 32MB, 512MB (64KB pages) or others
+        int File = open("/proc/meminfo", O_RDONLY);
+        if (File >= 0)
+        {
+            char Buffer[4096];
+            ssize_t NumRead = read(File, Buffer, sizeof(Buffer) - 1);
+            close(File);
+            
+            Buffer[NumRead > 0 ? NumRead : 0] = 0;
+            const char* Key = "Hugepagesize:";
+            for (char* At = Buffer; *At; ++At)
+            {
+                mm KeyId = 0;
+                while (Key[KeyId] && At[KeyId] == Key[KeyId])
+                {
+                    ++KeyId;
+                }
+
+                if (!Key[KeyId])
+                {
+                    mm SizeKb = 0;
+                    for (At += KeyId; *At == ' ' || *At == '\t'; ++At);
+                    for (; *At >= '0' && *At <= '9'; ++At)
+                    {
+                        SizeKb = SizeKb*10 + mm(*At - '0');
+                    }
+                    HugePageSize = SizeKb*1024;
+                    break;
+                }
+            }
+        }
+
+        if (!HugePageSize)
+        {
+            HugePageSize = MegaBytes(2);
+        }
+#endif
+    }
+
+    return HugePageSize;
+}
+
+inline mm MemoryGetAllocSize(mm Size, u32 Flags)
 {
-    void* Result = VirtualAlloc(0, AllocSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    // NOTE: Rounds a request to the granularity the OS will actually map for it
+    mm Granularity = (Flags & (MemoryFlag_HugePages | MemoryFlag_HugePagesExplicit)) ? MemoryGetHugePageSize() : MemoryGetPageSize();
+    mm Result = (Size + Granularity - 1) & ~(Granularity - 1);
+    return Result;
+}
+
+#if !defined(_WIN32)
+
+inline void* MemoryMapAligned_(mm Size, mm Alignment, int Protection, int MapFlags)
+{
+    // NOTE: Over map by the alignment and trim the head and tail so the range starts aligned
+    void* Result = 0;
+    
+    mm MapSize = Size + Alignment;
+    u8* Mem = (u8*)mmap(0, MapSize, Protection, MapFlags, -1, 0);
+    if (Mem != MAP_FAILED)
+    {
+        u8* AlignedMem = (u8*)((mm(Mem) + (Alignment - 1)) & ~(Alignment - 1));
+        mm HeadSize = mm(AlignedMem - Mem);
+        mm TailSize = MapSize - HeadSize - Size;
+        if (HeadSize)
+        {
+            munmap(Mem, HeadSize);
+        }
+        if (TailSize)
+        {
+            munmap(AlignedMem + Size, TailSize);
+        }
+
+        Result = AlignedMem;
+    }
+
     return Result;
 }
 
-inline void MemoryFree(void* Mem)
+inline void* MemoryMap_(mm Size, int Protection, int MapFlags, u32 Flags)
 {
-    BOOL Result = VirtualFree(Mem, 0, MEM_RELEASE);
-    DWORD Error = GetLastError();
+    void* Result = 0;
+    
+    if (Flags & MemoryFlag_HugePagesExplicit)
+    {
+        Result = mmap(0, Size, Protection, MapFlags | MAP_HUGETLB, -1, 0);
+        if (Result == MAP_FAILED)
+        {
+            // NOTE: Huge page pool is empty or not configured, fall back to transparent huge pages
+            Result = 0;
+            Flags |= MemoryFlag_HugePages;
+        }
+    }
+
+    if (!Result && (Flags & MemoryFlag_HugePages))
+    {
+        // NOTE: THP only backs huge page aligned ranges so make sure we start on one
+        Result = MemoryMapAligned_(Size, MemoryGetHugePageSize(), Protection, MapFlags);
+        if (Result)
+        {
+            madvise(Result, Size, MADV_HUGEPAGE);
+        }
+    }
+    
+    if (!Result)
+    {
+        Result = mmap(0, Size, Protection, MapFlags, -1, 0);
+        if (Result == MAP_FAILED)
+        {
+            Result = 0;
+        }
+    }
+
+    return Result;
+}
+
+#endif
+
+inline void* MemoryReserve(mm Size, u32 Flags = 0)
+{
+    if (!(Flags & MemoryFlag_Untracked))
+    {
+        MemoryOsStatsAdd(NumReserves);
+    }
+    // NOTE: Reserves address space, pages are unusable until they are committed
+    void* Result = 0;
+    mm AllocSize = MemoryGetAllocSize(Size, Flags);
+    
+#if defined(_WIN32)
+    if (Flags & MemoryFlag_HugePagesExplicit)
+    {
+        // NOTE: Windows large pages can't be reserved without being committed
+        Result = VirtualAlloc(0, AllocSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    }
+    if (!Result)
+    {
+        Result = VirtualAlloc(0, AllocSize, MEM_RESERVE, PAGE_NOACCESS);
+    }
+#else
+    Result = MemoryMap_(AllocSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, Flags);
+#endif
+
+    return Result;
+}
+
+inline void* MemoryReserveAligned(mm Size, mm Alignment, u32 Flags = 0)
+{
+    if (!(Flags & MemoryFlag_Untracked))
+    {
+        MemoryOsStatsAdd(NumReserves);
+    }
+    // IMPORTANT: We assume a power of 2 alignment that is a multiple of the page size
+    void* Result = 0;
+    mm AllocSize = MemoryGetAllocSize(Size, Flags);
+    
+#if defined(_WIN32)
+    // NOTE: Windows can't trim a reservation so we find an aligned hole and try to grab it, another thread can steal it so we loop
+    while (!Result)
+    {
+        void* Mem = VirtualAlloc(0, AllocSize + Alignment, MEM_RESERVE, PAGE_NOACCESS);
+        if (!Mem)
+        {
+            break;
+        }
+        VirtualFree(Mem, 0, MEM_RELEASE);
+
+        void* AlignedMem = (void*)((mm(Mem) + (Alignment - 1)) & ~(Alignment - 1));
+        Result = VirtualAlloc(AlignedMem, AllocSize, MEM_RESERVE, PAGE_NOACCESS);
+    }
+#else
+    Result = MemoryMapAligned_(AllocSize, Alignment, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE);
+    if (Result && (Flags & (MemoryFlag_HugePages | MemoryFlag_HugePagesExplicit)))
+    {
+        madvise(Result, AllocSize, MADV_HUGEPAGE);
+    }
+#endif
+
+    return Result;
+}
+
+inline b32 MemoryCommit(void* Mem, mm Size, u32 Flags = 0)
+{
+    if (!(Flags & MemoryFlag_Untracked))
+    {
+        MemoryOsStatsAdd(NumCommits);
+    }
+    // IMPORTANT: Mem and Size are expected to be page aligned
+#if defined(_WIN32)
+    b32 Result = VirtualAlloc(Mem, Size, MEM_COMMIT, PAGE_READWRITE) != 0;
+#else
+    b32 Result = mprotect(Mem, Size, PROT_READ | PROT_WRITE) == 0;
+#endif
+
+    return Result;
+}
+
+inline b32 MemoryDecommit(void* Mem, mm Size)
+{
+    MemoryOsStatsAdd(NumDecommits);
+    // NOTE: Returns the physical pages to the OS but keeps the address range reserved. On failure the pages stay committed and
+    // usable (their contents might be gone), so callers can carry on as if they never decommitted and we don't assert
+#if defined(_WIN32)
+    b32 Result = VirtualFree(Mem, Size, MEM_DECOMMIT) != 0;
+#else
+    b32 Result = madvise(Mem, Size, MADV_DONTNEED) == 0 && mprotect(Mem, Size, PROT_NONE) == 0;
+#endif
+
+    return Result;
+}
+
+inline b32 MemoryPurge(void* Mem, mm Size, b32 Lazy = false)
+{
+    MemoryOsStatsAdd(NumPurges);
+    /*
+      NOTE: Drops the contents of committed pages while keeping them usable, the next touch gets zeroed (or, when lazy, possibly the
+      old) pages. Lazy purges (MADV_FREE / MEM_RESET) only get reclaimed once the OS is short on memory so they are cheaper but don't
+      lower RSS right away.
+      IMPORTANT: Mem and Size are expected to be page aligned
+     */
+#if defined(_WIN32)
+    b32 Result = false;
+    if (Lazy)
+    {
+        Result = VirtualAlloc(Mem, Size, MEM_RESET, PAGE_READWRITE) != 0;
+    }
+    else
+    {
+        b32 Decommitted = VirtualFree(Mem, Size, MEM_DECOMMIT) != 0;
+        b32 Committed = VirtualAlloc(Mem, Size, MEM_COMMIT, PAGE_READWRITE) != 0;
+        Result = Decommitted && Committed;
+    }
+#else
+    int Error = -1;
+#if defined(MADV_FREE)
+    if (Lazy)
+    {
+        Error = madvise(Mem, Size, MADV_FREE);
+    }
+#endif
+    if (Error != 0)
+    {
+        Error = madvise(Mem, Size, MADV_DONTNEED);
+    }
+    b32 Result = Error == 0;
+#endif
     Assert(Result);
+
+    return Result;
+}
+
+inline b32 MemoryRelease(void* Mem, mm Size, u32 Flags = 0)
+{
+    if (!(Flags & MemoryFlag_Untracked))
+    {
+        MemoryOsStatsAdd(NumReleases);
+    }
+    // NOTE: Only fails on bad arguments, in which case the range stays mapped
+#if defined(_WIN32)
+    b32 Result = VirtualFree(Mem, 0, MEM_RELEASE) != 0;
+#else
+    b32 Result = munmap(Mem, MemoryGetAllocSize(Size, Flags)) == 0;
+#endif
+    Assert(Result);
+
+    return Result;
+}
+
+inline void* MemoryAllocate(mm AllocSize, u32 Flags = 0)
+{
+    if (!(Flags & MemoryFlag_Untracked))
+    {
+        MemoryOsStatsAdd(NumReserves);
+    }
+    void* Result = 0;
+    mm Size = MemoryGetAllocSize(AllocSize, Flags);
+    
+#if defined(_WIN32)
+    if (Flags & MemoryFlag_HugePagesExplicit)
+    {
+        Result = VirtualAlloc(0, Size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    }
+    if (!Result)
+    {
+        Result = VirtualAlloc(0, Size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+#else
+    Result = MemoryMap_(Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, Flags);
+#endif
+    
+    return Result;
+}
+
+inline void* MemoryAllocateAligned(mm AllocSize, mm Alignment, u32 Flags = 0)
+{
+    // IMPORTANT: We assume a power of 2 alignment that is a multiple of the page size
+    void* Result = MemoryReserveAligned(AllocSize, Alignment, Flags);
+    if (Result && !MemoryCommit(Result, MemoryGetAllocSize(AllocSize, Flags), Flags))
+    {
+        MemoryRelease(Result, AllocSize, Flags);
+        Result = 0;
+    }
+
+    return Result;
+}
+
+inline void MemoryFree(void* Mem, mm Size, u32 Flags = 0)
+{
+    // NOTE: Size has to match the allocation since munmap needs it
+    MemoryRelease(Mem, Size, Flags);
+}
+
+//
+// NOTE: NUMA
+//
+
+/*
+  NOTE: Node queries for the NUMA aware arenas. We only ask the OS for a node count once and cache the node of the calling thread,
+  re-reading it every MEMORY_NUMA_NODE_REFRESH calls since threads can migrate between sockets. MemoryBindToNode sets a preferred node
+  for a range that hasn't been touched yet (mbind on linux). Windows can only pick a node when reserving, so there we rely on first
+  touch from a thread on the owning node, which is windows default policy anyway.
+
+  MemoryNumaSetEmulation fakes a machine with NumNodes nodes (cpu i sits on node i % NumNodes) so NUMA code paths can be tested on
+  single node machines. Binding to an emulated node that doesn't exist is skipped. Pass 0 to go back to the real topology.
+  MemoryNumaSetThreadNode pins the calling thread to an emulated node, for tests on machines with fewer cpus than nodes.
+ */
+
+// NOTE: Size of the node masks we pass to the OS, nodes past it are treated as the last one
+#define MEMORY_MAX_NUMA_NODES 64
+#define MEMORY_NUMA_NODE_REFRESH 256
+
+static volatile u32 MemoryNumaEmulatedNodes;
+static thread_local u32 MemoryNumaCachedNode;
+static thread_local u32 MemoryNumaCallsUntilRefresh;
+static thread_local u32 MemoryNumaThreadNode; // NOTE: Emulated node + 1, 0 if the thread isn't pinned
+
+inline u32 MemoryGetRealNumaNodeCount()
+{
+    static u32 NumNodes = 0;
+    if (!NumNodes)
+    {
+        u32 Result = 1;
+#if defined(_WIN32)
+        ULONG HighestNode = 0;
+        if (GetNumaHighestNodeNumber(&HighestNode))
+        {
+            Result = u32(HighestNode) + 1;
+        }
+#elif defined(__linux__) && defined(SYS_get_mempolicy)
+        // NOTE: MPOL_F_MEMS_ALLOWED returns the nodes we are allowed to use, so the highest set bit gives us the count
+        unsigned long NodeMask[MEMORY_MAX_NUMA_NODES / (8*sizeof(unsigned long))] = {};
+        if (syscall(SYS_get_mempolicy, 0, NodeMask, 8*sizeof(NodeMask), 0, 4 /* MPOL_F_MEMS_ALLOWED */) == 0)
+        {
+            for (u32 NodeId = 0; NodeId < 8*sizeof(NodeMask); ++NodeId)
+            {
+                if (NodeMask[NodeId / (8*sizeof(unsigned long))] & (1ul << (NodeId % (8*sizeof(unsigned long)))))
+                {
+                    Result = NodeId + 1;
+                }
+            }
+        }
+#endif
+        NumNodes = Min(Result, u32(MEMORY_MAX_NUMA_NODES));
+    }
+
+    return NumNodes;
+}
+
+inline void MemoryNumaSetEmulation(u32 NumNodes)
+{
+    Assert(NumNodes <= MEMORY_MAX_NUMA_NODES);
+    MemoryNumaEmulatedNodes = NumNodes;
+    MemoryNumaCallsUntilRefresh = 0;
+}
+
+inline void MemoryNumaSetThreadNode(u32 Node)
+{
+    Assert(Node < MEMORY_MAX_NUMA_NODES);
+    MemoryNumaThreadNode = Node + 1;
+    MemoryNumaCallsUntilRefresh = 0;
+}
+
+inline u32 MemoryGetNumaNodeCount()
+{
+    u32 Result = MemoryNumaEmulatedNodes ? MemoryNumaEmulatedNodes : MemoryGetRealNumaNodeCount();
+    return Result;
+}
+
+inline u32 MemoryGetCurrentNumaNode()
+{
+    if (MemoryNumaCallsUntilRefresh == 0)
+    {
+        u32 Cpu = 0;
+        u32 Node = 0;
+#if defined(_WIN32)
+        PROCESSOR_NUMBER Processor = {};
+        GetCurrentProcessorNumberEx(&Processor);
+        Cpu = u32(Processor.Group)*64 + u32(Processor.Number);
+        USHORT NodeNumber = 0;
+        if (GetNumaProcessorNodeEx(&Processor, &NodeNumber) && NodeNumber != 0xFFFF)
+        {
+            Node = u32(NodeNumber);
+        }
+#elif defined(__linux__) && defined(SYS_getcpu)
+        unsigned CpuResult = 0;
+        unsigned NodeResult = 0;
+        if (syscall(SYS_getcpu, &CpuResult, &NodeResult, 0) == 0)
+        {
+            Cpu = u32(CpuResult);
+            Node = u32(NodeResult);
+        }
+#endif
+        u32 EmulatedNodes = MemoryNumaEmulatedNodes;
+        if (EmulatedNodes)
+        {
+            MemoryNumaCachedNode = MemoryNumaThreadNode ? (MemoryNumaThreadNode - 1) % EmulatedNodes : Cpu % EmulatedNodes;
+        }
+        else
+        {
+            MemoryNumaCachedNode = Min(Node, MemoryGetRealNumaNodeCount() - 1);
+        }
+        MemoryNumaCallsUntilRefresh = MEMORY_NUMA_NODE_REFRESH;
+    }
+
+    MemoryNumaCallsUntilRefresh -= 1;
+    return MemoryNumaCachedNode;
+}
+
+inline b32 MemoryBindToNode(void* Mem, mm Size, u32 Node)
+{
+    // NOTE: Has to happen before the pages get touched, returns false if the range stays on the default policy
+    b32 Result = false;
+    if (Node < MemoryGetRealNumaNodeCount() && MemoryGetRealNumaNodeCount() > 1)
+    {
+#if defined(__linux__) && defined(SYS_mbind)
+        unsigned long NodeMask[MEMORY_MAX_NUMA_NODES / (8*sizeof(unsigned long))] = {};
+        NodeMask[Node / (8*sizeof(unsigned long))] = 1ul << (Node % (8*sizeof(unsigned long)));
+        Result = syscall(SYS_mbind, Mem, Size, 1 /* MPOL_PREFERRED */, NodeMask, 8*sizeof(NodeMask) + 1, 0) == 0;
+#endif
+    }
+
+    return Result;
+}
+
+//
+// NOTE: Memory mapped files
+//
+
+/*
+  NOTE: Shared file mappings for the file backed arenas. Handles are a u64 that is 0 when invalid (fd + 1 on linux, the HANDLE on
+  windows). On linux we can map more than the file holds and grow the file under the mapping with MemoryFileSetSize, pages past the
+  end of the file fault with SIGBUS so they have to be grown into before use. Windows can't grow a file under an existing view so
+  there MemoryFileMap grows the file to the whole mapping up front.
+ */
+
+inline u64 MemoryFileOpen(const char* Path, b32 Create)
+{
+    u64 Result = 0;
+#if defined(_WIN32)
+    HANDLE File = CreateFileA(Path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, 0, Create ? CREATE_ALWAYS : OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, 0);
+    if (File != INVALID_HANDLE_VALUE)
+    {
+        Result = u64(File);
+    }
+#else
+    int File = open(Path, Create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+    if (File >= 0)
+    {
+        Result = u64(File) + 1;
+    }
+#endif
+
+    return Result;
+}
+
+inline void MemoryFileClose(u64 File)
+{
+#if defined(_WIN32)
+    CloseHandle(HANDLE(File));
+#else
+    close(int(File - 1));
+#endif
+}
+
+inline mm MemoryFileGetSize(u64 File)
+{
+    mm Result = 0;
+#if defined(_WIN32)
+    LARGE_INTEGER Size = {};
+    if (GetFileSizeEx(HANDLE(File), &Size))
+    {
+        Result = mm(Size.QuadPart);
+    }
+#else
+    struct stat Stat = {};
+    if (fstat(int(File - 1), &Stat) == 0)
+    {
+        Result = mm(Stat.st_size);
+    }
+#endif
+
+    return Result;
+}
+
+inline b32 MemoryFileSetSize(u64 File, mm Size)
+{
+#if defined(_WIN32)
+    // NOTE: Already sized to the whole mapping by MemoryFileMap
+    b32 Result = MemoryFileGetSize(File) >= Size;
+#else
+    b32 Result = ftruncate(int(File - 1), off_t(Size)) == 0;
+#endif
+    return Result;
+}
+
+inline void* MemoryFileMap(u64 File, mm Size)
+{
+    void* Result = 0;
+#if defined(_WIN32)
+    // NOTE: The view keeps the mapping object alive so we can close it right away
+    HANDLE Mapping = CreateFileMappingA(HANDLE(File), 0, PAGE_READWRITE, DWORD(u64(Size) >> 32), DWORD(Size), 0);
+    if (Mapping)
+    {
+        Result = MapViewOfFile(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, Size);
+        CloseHandle(Mapping);
+    }
+#else
+    Result = mmap(0, Size, PROT_READ | PROT_WRITE, MAP_SHARED, int(File - 1), 0);
+    if (Result == MAP_FAILED)
+    {
+        Result = 0;
+    }
+#endif
+    
+    return Result;
+}
+
+inline void MemoryFileUnmap(void* Mem, mm Size)
+{
+#if defined(_WIN32)
+    UnmapViewOfFile(Mem);
+#else
+    munmap(Mem, Size);
+#endif
+}
+
+inline b32 MemoryFileSync(u64 File, void* Mem, mm Size)
+{
+    // NOTE: Blocks until the dirty pages of [Mem, Mem + Size) are on disk, Mem has to be page aligned
+#if defined(_WIN32)
+    b32 Result = FlushViewOfFile(Mem, Size) && FlushFileBuffers(HANDLE(File));
+#else
+    (void)File; // NOTE: msync only needs the mapping
+    b32 Result = msync(Mem, Size, MS_SYNC) == 0;
+#endif
+    return Result;
+}
+
+//
+// NOTE: Mirrored mappings
+//
+
+/*
+  NOTE: Maps the same Size bytes twice, back to back, so a write to Mem + i shows up at Mem + Size + i as well and anything that starts
+  in the first half can run past its end without wrapping. Size has to be a multiple of MemoryGetMirrorGranularity (the page size on
+  linux, the 64KB allocation granularity on windows). Both views share one anonymous memory object (a memfd on linux, a pagefile
+  backed section on windows) that lives as long as the mapping does.
+ */
+
+inline mm MemoryGetMirrorGranularity()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO SystemInfo = {};
+    GetSystemInfo(&SystemInfo);
+    mm Result = mm(SystemInfo.dwAllocationGranularity);
+#else
+    mm Result = MemoryGetPageSize();
+#endif
+    return Result;
+}
+
+inline void* MemoryMapMirrored(mm Size)
+{
+    MemoryOsStatsAdd(NumReserves);
+    Assert((Size % MemoryGetMirrorGranularity()) == 0);
+    
+    u8* Result = 0;
+#if defined(_WIN32)
+    HANDLE Mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, 0, PAGE_READWRITE, DWORD(u64(Size) >> 32), DWORD(Size), 0);
+    if (Mapping)
+    {
+        // NOTE: Find a free range for both views and map into it. Another thread can take the range between the free and the map, so
+        // we retry a few times
+        for (u32 Attempt = 0; Attempt < 16 && !Result; ++Attempt)
+        {
+            u8* Base = (u8*)VirtualAlloc(0, 2*Size, MEM_RESERVE, PAGE_NOACCESS);
+            if (!Base)
+            {
+                break;
+            }
+            VirtualFree(Base, 0, MEM_RELEASE);
+
+            void* First = MapViewOfFileEx(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, Size, Base);
+            void* Second = First ? MapViewOfFileEx(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, Size, Base + Size) : 0;
+            if (Second)
+            {
+                Result = Base;
+            }
+            else if (First)
+            {
+                UnmapViewOfFile(First);
+            }
+        }
+        CloseHandle(Mapping);
+    }
+#else
+#if defined(__linux__) && defined(SYS_memfd_create)
+    int File = int(syscall(SYS_memfd_create, "memory_mirror", 1u /* MFD_CLOEXEC */));
+#else
+    // NOTE: No memfd, use an unlinked temp file instead
+    char Path[] = "/tmp/memory_mirror_XXXXXX";
+    int File = mkstemp(Path);
+    if (File >= 0)
+    {
+        unlink(Path);
+    }
+#endif
+    if (File >= 0)
+    {
+        if (ftruncate(File, off_t(Size)) == 0)
+        {
+            // NOTE: Reserve the range for both halves, then map the file over each half
+            u8* Base = (u8*)mmap(0, 2*Size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (Base != MAP_FAILED)
+            {
+                void* First = mmap(Base, Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, File, 0);
+                void* Second = mmap(Base + Size, Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, File, 0);
+                if (First == Base && Second == Base + Size)
+                {
+                    Result = Base;
+                }
+                else
+                {
+                    munmap(Base, 2*Size);
+                }
+            }
+        }
+
+        // NOTE: The mappings keep the memory alive
+        close(File);
+    }
+#endif
+
+    return Result;
+}
+
+inline void MemoryUnmapMirrored(void* Mem, mm Size)
+{
+    MemoryOsStatsAdd(NumReleases);
+#if defined(_WIN32)
+    UnmapViewOfFile(Mem);
+    UnmapViewOfFile((u8*)Mem + Size);
+#else
+    munmap(Mem, 2*Size);
+#endif
+}
+
+//
+// NOTE: Atomic functions
+//
+
+/*
+  NOTE: Thin wrappers over the compiler intrinsics so the concurrent arena modes can operate on plain fields. CompareExchange returns
+  the value that was in Dest before the exchange, like the win32 interlocked functions, so success is Result == Expected.
+ */
+
+inline u32 AtomicLoadU32(volatile u32* Src)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    u32 Result = *Src;
+    _ReadWriteBarrier();
+#else
+    u32 Result = __atomic_load_n(Src, __ATOMIC_ACQUIRE);
+#endif
+    return Result;
+}
+
+inline u64 AtomicLoadU64(volatile u64* Src)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    u64 Result = *Src;
+    _ReadWriteBarrier();
+#else
+    u64 Result = __atomic_load_n(Src, __ATOMIC_ACQUIRE);
+#endif
+    return Result;
+}
+
+inline void AtomicStoreU32(volatile u32* Dest, u32 Value)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    _ReadWriteBarrier();
+    *Dest = Value;
+#else
+    __atomic_store_n(Dest, Value, __ATOMIC_RELEASE);
+#endif
+}
+
+inline void AtomicStoreU64(volatile u64* Dest, u64 Value)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    _ReadWriteBarrier();
+    *Dest = Value;
+#else
+    __atomic_store_n(Dest, Value, __ATOMIC_RELEASE);
+#endif
+}
+
+inline u32 AtomicAddU32(volatile u32* Dest, u32 Addend)
+{
+    // NOTE: Returns the value before the add
+#if defined(_MSC_VER) && !defined(__clang__)
+    u32 Result = (u32)_InterlockedExchangeAdd((volatile long*)Dest, (long)Addend);
+#else
+    u32 Result = __atomic_fetch_add(Dest, Addend, __ATOMIC_ACQ_REL);
+#endif
+    return Result;
+}
+
+inline u64 AtomicAddU64(volatile u64* Dest, u64 Addend)
+{
+    // NOTE: Returns the value before the add
+#if defined(_MSC_VER) && !defined(__clang__)
+    u64 Result = (u64)_InterlockedExchangeAdd64((volatile __int64*)Dest, (__int64)Addend);
+#else
+    u64 Result = __atomic_fetch_add(Dest, Addend, __ATOMIC_ACQ_REL);
+#endif
+    return Result;
+}
+
+inline u32 AtomicCompareExchangeU32(volatile u32* Dest, u32 Expected, u32 New)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    u32 Result = (u32)_InterlockedCompareExchange((volatile long*)Dest, (long)New, (long)Expected);
+#else
+    u32 Result = Expected;
+    __atomic_compare_exchange_n(Dest, &Result, New, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+    return Result;
+}
+
+inline u64 AtomicCompareExchangeU64(volatile u64* Dest, u64 Expected, u64 New)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    u64 Result = (u64)_InterlockedCompareExchange64((volatile __int64*)Dest, (__int64)New, (__int64)Expected);
+#else
+    u64 Result = Expected;
+    __atomic_compare_exchange_n(Dest, &Result, New, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+    return Result;
+}
+
+inline void AtomicPause()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+inline void SpinLockAcquire(volatile u32* Lock)
+{
+    while (AtomicCompareExchangeU32(Lock, 0, 1) != 0)
+    {
+        while (AtomicLoadU32(Lock) != 0)
+        {
+            AtomicPause();
+        }
+    }
+}
+
+inline void SpinLockRelease(volatile u32* Lock)
+{
+    AtomicStoreU32(Lock, 0);
+}
+
+//
+// NOTE: Zero/Copy/Move
+//
+
+/*
+
+  NOTE: ZeroMem/Copy/Move pick a SSE2/AVX2/AVX-512 kernel the first time they get called based on what the CPU supports. Kernels
+  write an unaligned vector at the head, then aligned vectors up to the tail and finish with an unaligned vector that ends at the last
+  byte, so there are no scalar loops for sizes past one vector. Anything bigger than the last level cache uses streaming stores so we
+  don't evict the working set for data that won't be read soon.
+
+  Copy expects the ranges to not overlap, use Move when they might.
+
+  MEMORY_SIMD_COPY picks our kernels over memset/memcpy/memmove. glibc and Apple's libc pick tuned AVX/ERMS kernels for the CPU at
+  load time. Against glibc on an AVX-512 machine ours only tie from 1KB up and lose below 512 bytes (and on 64MB zeroing), so
+  there is no size where a threshold would pay off and those CRTs get everything. Other x86 CRTs (MSVC, musl, mingw) use our
+  kernels. Define MEMORY_SIMD_COPY to 1 to force them on, tests/test_copy.cpp does so the kernels get covered everywhere.
+  
+ */
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MEMORY_X86 1
+#include <immintrin.h>
+#else
+#define MEMORY_X86 0
+#endif
+
+#ifndef MEMORY_SIMD_COPY
+#if MEMORY_X86 && !defined(__GLIBC__) && !defined(__APPLE__)
+#define MEMORY_SIMD_COPY 1
+#else
+#define MEMORY_SIMD_COPY 0
+#endif
+#endif
+
+#if MEMORY_X86 && MEMORY_SIMD_COPY
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define MEMORY_TARGET_AVX2
+#define MEMORY_TARGET_AVX512
+#else
+#define MEMORY_TARGET_AVX2 __attribute__((target("avx2")))
+#define MEMORY_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+enum memory_simd_level
+{
+    MemorySimdLevel_Sse2,
+    MemorySimdLevel_Avx2,
+    MemorySimdLevel_Avx512,
+};
+
+struct memory_simd_state
+{
+    volatile u32 InitState; // NOTE: 0 = not started, 1 = a thread is filling in the table, 2 = ready
+    u32 Level;
+    mm Width;
+    mm NonTemporalThreshold;
+    void (*Zero)(u8* Dest, mm Size);
+    void (*Copy)(const u8* Src, u8* Dest, mm Size);
+};
+
+static memory_simd_state MemorySimd;
+
+// NOTE: Kernels expect Size >= Width, smaller sizes get handled by the dispatch functions
+#define MEMORY_SIMD_KERNELS(Name, Target, Vec, Width, SetZero, LoadU, StoreU, Store, Stream) \
+    Target static void ZeroMem##Name(u8* Dest, mm Size)                 \
+    {                                                                   \
+        Vec Zero = SetZero();                                           \
+        u8* End = Dest + Size;                                          \
+        u8* Curr = (u8*)((mm(Dest) + Width) & ~mm(Width - 1));          \
+        StoreU((Vec*)Dest, Zero);                                       \
+        if (Size >= MemorySimd.NonTemporalThreshold)                    \
+        {                                                               \
+            for (; Curr + Width <= End; Curr += Width)                  \
+            {                                                           \
+                Stream((Vec*)Curr, Zero);                               \
+            }                                                           \
+            _mm_sfence();                                               \
+        }                                                               \
+        else                                                            \
+        {                                                               \
+            for (; Curr + 4*Width <= End; Curr += 4*Width)              \
+            {                                                           \
+                Store((Vec*)Curr + 0, Zero);                            \
+                Store((Vec*)Curr + 1, Zero);                            \
+                Store((Vec*)Curr + 2, Zero);                            \
+                Store((Vec*)Curr + 3, Zero);                            \
+            }                                                           \
+            for (; Curr + Width <= End; Curr += Width)                  \
+            {                                                           \
+                Store((Vec*)Curr, Zero);                                \
+            }                                                           \
+        }                                                               \
+        StoreU((Vec*)(End - Width), Zero);                              \
+    }                                                                   \
+                                                                        \
+    Target static void Copy##Name(const u8* Src, u8* Dest, mm Size)     \
+    {                                                                   \
+        Vec Tail = LoadU((const Vec*)(Src + Size - Width));             \
+        StoreU((Vec*)Dest, LoadU((const Vec*)Src));                     \
+        mm Offset = ((mm(Dest) + Width) & ~mm(Width - 1)) - mm(Dest);   \
+        if (Size >= MemorySimd.NonTemporalThreshold)                    \
+        {                                                               \
+            for (; Offset + Width <= Size; Offset += Width)             \
+            {                                                           \
+                Stream((Vec*)(Dest + Offset), LoadU((const Vec*)(Src + Offset))); \
+            }                                                           \
+            _mm_sfence();                                               \
+        }                                                               \
+        else                                                            \
+        {                                                               \
+            for (; Offset + 4*Width <= Size; Offset += 4*Width)         \
+            {                                                           \
+                Vec A = LoadU((const Vec*)(Src + Offset) + 0);          \
+                Vec B = LoadU((const Vec*)(Src + Offset) + 1);          \
+                Vec C = LoadU((const Vec*)(Src + Offset) + 2);          \
+                Vec D = LoadU((const Vec*)(Src + Offset) + 3);          \
+                Store((Vec*)(Dest + Offset) + 0, A);                    \
+                Store((Vec*)(Dest + Offset) + 1, B);                    \
+                Store((Vec*)(Dest + Offset) + 2, C);                    \
+                Store((Vec*)(Dest + Offset) + 3, D);                    \
+            }                                                           \
+            for (; Offset + Width <= Size; Offset += Width)             \
+            {                                                           \
+                Store((Vec*)(Dest + Offset), LoadU((const Vec*)(Src + Offset))); \
+            }                                                           \
+        }                                                               \
+        StoreU((Vec*)(Dest + Size - Width), Tail);                      \
+    }                                                                   \
+
+MEMORY_SIMD_KERNELS(Sse2_, , __m128i, 16, _mm_setzero_si128, _mm_loadu_si128, _mm_storeu_si128, _mm_store_si128, _mm_stream_si128)
+MEMORY_SIMD_KERNELS(Avx2_, MEMORY_TARGET_AVX2, __m256i, 32, _mm256_setzero_si256, _mm256_loadu_si256, _mm256_storeu_si256,
+                    _mm256_store_si256, _mm256_stream_si256)
+MEMORY_SIMD_KERNELS(Avx512_, MEMORY_TARGET_AVX512, __m512i, 64, _mm512_setzero_si512, _mm512_loadu_si512, _mm512_storeu_si512,
+                    _mm512_store_si512, _mm512_stream_si512)
+
+inline u32 MemoryGetSimdLevel()
+{
+    u32 Result = MemorySimdLevel_Sse2;
+    
+#if defined(_MSC_VER) && !defined(__clang__)
+    int Info[4] = {};
+    __cpuid(Info, 1);
+    b32 OsXSave = (Info[2] & (1 << 27)) != 0;
+    b32 Avx = (Info[2] & (1 << 28)) != 0;
+    u64 Xcr0 = OsXSave ? _xgetbv(0) : 0;
+    
+    __cpuidex(Info, 7, 0);
+    b32 Avx2 = (Info[1] & (1 << 5)) != 0;
+    b32 Avx512 = (Info[1] & (1 << 16)) != 0;
+
+    // NOTE: Make sure the OS saves the ymm/zmm registers before we use them
+    if (Avx512 && (Xcr0 & 0xE6) == 0xE6)
+    {
+        Result = MemorySimdLevel_Avx512;
+    }
+    else if (Avx && Avx2 && (Xcr0 & 0x6) == 0x6)
+    {
+        Result = MemorySimdLevel_Avx2;
+    }
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        Result = MemorySimdLevel_Avx512;
+    }
+    else if (__builtin_cpu_supports("avx2"))
+    {
+        Result = MemorySimdLevel_Avx2;
+    }
+#endif
+
+    return Result;
+}
+
+inline mm MemoryGetLastLevelCacheSize()
+{
+    mm Result = 0;
+    
+#if defined(_WIN32)
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION Infos[256];
+    DWORD InfoSize = sizeof(Infos);
+    if (GetLogicalProcessorInformation(Infos, &InfoSize))
+    {
+        for (DWORD InfoId = 0; InfoId < InfoSize / sizeof(Infos[0]); ++InfoId)
+        {
+            if (Infos[InfoId].Relationship == RelationCache)
+            {
+                Result = Max(Result, mm(Infos[InfoId].Cache.Size));
+            }
+        }
+    }
+#elif defined(_SC_LEVEL3_CACHE_SIZE)
+    long CacheSize = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (CacheSize <= 0)
+    {
+        CacheSize = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    }
+    Result = CacheSize > 0 ? mm(CacheSize) : 0;
+#endif
+
+    if (!Result)
+    {
+        Result = MegaBytes(8);
+    }
+    
+    return Result;
+}
+
+inline void MemorySimdInit()
+{
+    // NOTE: One thread fills in the table and publishes it with a release store, everyone else waits for it
+    if (AtomicLoadU32(&MemorySimd.InitState) == 2)
+    {
+        return;
+    }
+    
+    if (AtomicCompareExchangeU32(&MemorySimd.InitState, 0, 1) == 0)
+    {
+        MemorySimd.NonTemporalThreshold = MemoryGetLastLevelCacheSize();
+        MemorySimd.Level = MemoryGetSimdLevel();
+        switch (MemorySimd.Level)
+        {
+            case MemorySimdLevel_Avx512:
+            {
+                MemorySimd.Width = 64;
+                MemorySimd.Zero = ZeroMemAvx512_;
+                MemorySimd.Copy = CopyAvx512_;
+            } break;
+
+            case MemorySimdLevel_Avx2:
+            {
+                MemorySimd.Width = 32;
+                MemorySimd.Zero = ZeroMemAvx2_;
+                MemorySimd.Copy = CopyAvx2_;
+            } break;
+
+            default:
+            {
+                MemorySimd.Width = 16;
+                MemorySimd.Zero = ZeroMemSse2_;
+                MemorySimd.Copy = CopySse2_;
+            } break;
+        }
+        AtomicStoreU32(&MemorySimd.InitState, 2);
+    }
+    else
+    {
+        while (AtomicLoadU32(&MemorySimd.InitState) != 2)
+        {
+            AtomicPause();
+        }
+    }
 }
 
 inline void ZeroMem(void* Mem, mm Size)
 {
+    MemorySimdInit();
+
     u8* CurrByte = (u8*)Mem;
-    for (mm Byte = 0; Byte < Size; ++Byte)
+    if (Size >= MemorySimd.Width)
+    {
+        MemorySimd.Zero(CurrByte, Size);
+    }
+    else if (Size >= 16)
     {
-        *CurrByte++ = 0;
+        ZeroMemSse2_(CurrByte, Size);
+    }
+    else
+    {
+        for (mm Byte = 0; Byte < Size; ++Byte)
+        {
+            *CurrByte++ = 0;
+        }
     }
 }
 
 #define CopyArray(Mem, Dest, Type, Count) Copy(Mem, Dest, sizeof(Type)*(Count))
 inline void Copy(const void* Mem, void* Dest, mm Size)
 {
+    MemorySimdInit();
+
     u8* CurrentByte = (u8*)Mem;
     u8* DestByte = (u8*)Dest;
-    for (mm Byte = 0; Byte < Size; ++Byte)
+    if (Size >= MemorySimd.Width)
+    {
+        MemorySimd.Copy(CurrentByte, DestByte, Size);
+    }
+    else if (Size >= 16)
+    {
+        CopySse2_(CurrentByte, DestByte, Size);
+    }
+    else
+    {
+        for (mm Byte = 0; Byte < Size; ++Byte)
+        {
+            *DestByte++ = *CurrentByte++;
+        }
+    }
+}
+
+#define MoveArray(Mem, Dest, Type, Count) Move(Mem, Dest, sizeof(Type)*(Count))
+inline void Move(const void* Mem, void* Dest, mm Size)
+{
+    const u8* SrcByte = (const u8*)Mem;
+    u8* DestByte = (u8*)Dest;
+    if (DestByte + Size <= SrcByte || SrcByte + Size <= DestByte)
     {
-        *DestByte++ = *CurrentByte++;
+        Copy(Mem, Dest, Size);
     }
+    else if (Size < 16)
+    {
+        if (DestByte < SrcByte)
+        {
+            for (mm Byte = 0; Byte < Size; ++Byte)
+            {
+                DestByte[Byte] = SrcByte[Byte];
+            }
+        }
+        else
+        {
+            for (mm Byte = Size; Byte > 0; --Byte)
+            {
+                DestByte[Byte - 1] = SrcByte[Byte - 1];
+            }
+        }
+    }
+    else if (DestByte < SrcByte)
+    {
+        // NOTE: Walk forward, the tail gets loaded before any stores since our stores can land on it
+        __m128i Tail = _mm_loadu_si128((const __m128i*)(SrcByte + Size - 16));
+        for (mm Offset = 0; Offset + 16 <= Size; Offset += 16)
+        {
+            _mm_storeu_si128((__m128i*)(DestByte + Offset), _mm_loadu_si128((const __m128i*)(SrcByte + Offset)));
+        }
+        _mm_storeu_si128((__m128i*)(DestByte + Size - 16), Tail);
+    }
+    else
+    {
+        // NOTE: Walk backward, the head gets loaded before any stores since our stores can land on it
+        __m128i Head = _mm_loadu_si128((const __m128i*)SrcByte);
+        for (mm Offset = Size; Offset >= 16; Offset -= 16)
+        {
+            _mm_storeu_si128((__m128i*)(DestByte + Offset - 16), _mm_loadu_si128((const __m128i*)(SrcByte + Offset - 16)));
+        }
+        _mm_storeu_si128((__m128i*)DestByte, Head);
+    }
+}
+
+#else
+
+// NOTE: No kernels of our own here, glibc/Apple and the CRTs on ARM platforms ship tuned versions that we don't beat
+inline void ZeroMem(void* Mem, mm Size)
+{
+    memset(Mem, 0, Size);
+}
+
+#define CopyArray(Mem, Dest, Type, Count) Copy(Mem, Dest, sizeof(Type)*(Count))
+inline void Copy(const void* Mem, void* Dest, mm Size)
+{
+    memcpy(Dest, Mem, Size);
+}
+
+#define MoveArray(Mem, Dest, Type, Count) Move(Mem, Dest, sizeof(Type)*(Count))
+inline void Move(const void* Mem, void* Dest, mm Size)
+{
+    memmove(Dest, Mem, Size);
+}
+
+#endif
+
+inline void MemoryPrefetch(const void* Mem)
+{
+    // NOTE: Hint that we'll read the cache line at Mem soon
+#if MEMORY_X86
+    _mm_prefetch((const char*)Mem, _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(Mem);
+#endif
 }
 
 // TODO: Macro to not have to make copies??
@@ -175,14 +1420,124 @@ inline mm AlignAddress(void* Address, mm Alignment)
 // NOTE: Memory Alloc Macros
 //
 
-#define PushStruct(Arena, Type) (Type*)PushSizeAligned(Arena, sizeof(Type), 1)
+// NOTE: Structs and arrays default to the alignment of their type, doubles and SIMD members fault or split loads otherwise
+#define PushStruct(Arena, Type) (Type*)PushSizeAligned(Arena, sizeof(Type), alignof(Type))
 #define PushStructAligned(Arena, Type, Alignment) (Type*)PushSizeAligned(Arena, sizeof(Type), Alignment)
 
-#define PushArray(Arena, Type, Count) (Type*)PushSizeAligned(Arena, sizeof(Type)*(Count), 1)
+#define PushArray(Arena, Type, Count) (Type*)PushSizeAligned(Arena, sizeof(Type)*(Count), alignof(Type))
 #define PushArrayAligned(Arena, Type, Count, Alignment) (Type*)PushSizeAligned(Arena, sizeof(Type)*(Count), Alignment)
 
 #define PushSize(Arena, Size) PushSizeAligned(Arena, Size, 1)
 
+//
+// NOTE: Typed Push
+//
+
+/*
+
+  NOTE: Push<T>(Arena, Count, Flags) is the typed version of the macros above. It works on any arena with a PushSizeAligned overload
+  (linear, dynamic, block and the rest), aligns to alignof(T) unless told otherwise, and can zero the memory with ZeroMem
+  (PushFlag_Zero) or default construct every element in place (PushFlag_Construct). PushNew<T>(Arena, Args...) constructs one object
+  with arguments. Arenas never run destructors, so only construct types that are fine with never being destroyed. Both return 0 without
+  touching anything if the arena push fails.
+
+  The policy parameter picks which checks get compiled in: push_checked asserts that Count * sizeof(T) doesn't overflow, that the
+  alignment is a power of 2 and that the arena handed back aligned memory, push_unchecked compiles all of that away. The default is
+  MEMORY_PUSH_POLICY, checked unless NDEBUG is defined.
+  
+ */
+
+#include <new>
+
+enum push_flags
+{
+    PushFlag_None = 0,
+    PushFlag_Zero = 1 << 0,
+    PushFlag_Construct = 1 << 1,
+};
+
+struct push_checked
+{
+    static constexpr b32 Checks = true;
+};
+
+struct push_unchecked
+{
+    static constexpr b32 Checks = false;
+};
+
+#ifndef MEMORY_PUSH_POLICY
+#if defined(NDEBUG)
+#define MEMORY_PUSH_POLICY push_unchecked
+#else
+#define MEMORY_PUSH_POLICY push_checked
+#endif
+#endif
+
+template<typename T, typename policy = MEMORY_PUSH_POLICY, typename arena>
+inline T* Push(arena* Arena, mm Count = 1, u32 Flags = 0, mm Alignment = alignof(T))
+{
+    if constexpr (policy::Checks)
+    {
+        Assert(Count <= ~mm(0) / sizeof(T));
+        Assert(Alignment && (Alignment & (Alignment - 1)) == 0);
+    }
+
+    mm Size = sizeof(T)*Count;
+    T* Result = (T*)PushSizeAligned(Arena, Size, Alignment);
+    if (!Result)
+    {
+        // NOTE: The arena is out of space or the OS is out of memory
+        return 0;
+    }
+
+    if constexpr (policy::Checks)
+    {
+        Assert((mm(Result) & (Alignment - 1)) == 0);
+    }
+
+    // NOTE: Zero first so constructors that leave members alone still hand back zeroed members
+    if (Flags & PushFlag_Zero)
+    {
+        ZeroMem(Result, Size);
+    }
+    
+    if (Flags & PushFlag_Construct)
+    {
+        for (mm ElementId = 0; ElementId < Count; ++ElementId)
+        {
+            new (Result + ElementId) T();
+        }
+    }
+
+    return Result;
+}
+
+template<typename T, typename policy = MEMORY_PUSH_POLICY, typename arena, typename... args>
+inline T* PushNew(arena* Arena, args&&... Args)
+{
+    T* Result = Push<T, policy>(Arena);
+    if (Result)
+    {
+        new (Result) T(static_cast<args&&>(Args)...);
+    }
+
+    return Result;
+}
+
+#if DEBUG_MEMORY_PROFILING
+#include "memory_debug.cpp"
+#endif
+
 #include "memory_linear_arena.cpp"
 #include "memory_dynamic_arena.cpp"
 #include "memory_block_arena.cpp"
+#include "memory_block_array.cpp"
+#include "memory_soa_array.cpp"
+#include "memory_hash_map.cpp"
+#include "memory_string.cpp"
+#include "memory_scratch_arena.cpp"
+#include "memory_slab_arena.cpp"
+#include "memory_tlsf_arena.cpp"
+#include "memory_arena_producer.cpp"
+#include "memory_ring_arena.cpp"
@@ -3,7 +3,21 @@
 // TODO: Add a diff between addresses macro
 // TODO: Add a get array index func into platform.h
 
+#if DEBUG_MEMORY_PROFILING
+#include "memory_debug.h"
+#endif
+
+#include "memory_rel_ptr.h"
 #include "memory_linear_arena.h"
 #include "memory_dynamic_arena.h"
 #include "memory_block_arena.h"
+#include "memory_block_array.h"
+#include "memory_soa_array.h"
+#include "memory_hash_map.h"
+#include "memory_string.h"
+#include "memory_scratch_arena.h"
+#include "memory_slab_arena.h"
+#include "memory_tlsf_arena.h"
+#include "memory_arena_producer.h"
+#include "memory_ring_arena.h"
 #include "memory.cpp"
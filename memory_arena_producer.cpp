@@ -0,0 +1,46 @@
+
+//
+// NOTE: Arena Producer
+//
+
+template<typename arena>
+inline arena_producer<arena> ArenaProducerCreate(arena* Arena, mm ChunkSize = ARENA_PRODUCER_DEFAULT_CHUNK_SIZE)
+{
+    arena_producer<arena> Result = {};
+    Result.Arena = Arena;
+    Result.ChunkSize = ChunkSize;
+
+    return Result;
+}
+
+template<typename arena>
+inline void ArenaProducerReset(arena_producer<arena>* Producer)
+{
+    // NOTE: Call after the shared arena got cleared or popped, the next push reserves a new chunk
+    Producer->Mem = 0;
+    Producer->Used = 0;
+    Producer->Size = 0;
+}
+
+template<typename arena>
+inline void* PushSizeAligned(arena_producer<arena>* Producer, mm Size, mm Alignment = 4)
+{
+    // IMPORTANT: Default Alignment = 4 since ARM requires it
+    mm AlignedOffset = Producer->Mem ? AlignAddress(Producer->Mem + Producer->Used, Alignment) - mm(Producer->Mem) : 0;
+    if (!Producer->Mem || (AlignedOffset + Size) > Producer->Size)
+    {
+        if (Size + Alignment > Producer->ChunkSize / 4)
+        {
+            return PushSizeAligned(Producer->Arena, Size, Alignment);
+        }
+
+        Producer->Mem = (u8*)PushSizeAligned(Producer->Arena, Producer->ChunkSize, ARENA_PRODUCER_CHUNK_ALIGNMENT);
+        Producer->Size = Producer->ChunkSize;
+        AlignedOffset = AlignAddress(Producer->Mem, Alignment) - mm(Producer->Mem);
+    }
+
+    void* Result = Producer->Mem + AlignedOffset;
+    Producer->Used = AlignedOffset + Size;
+
+    return Result;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+//
+// NOTE: Arena Producer
+//
+
+/*
+
+  NOTE: A producer is a thread private window onto a shared concurrent arena. It reserves ChunkSize bytes from the arena at a time and
+  bumps through them without any atomics, so only one push per chunk touches the shared counter. Pushes bigger than a quarter of a
+  chunk go straight to the shared arena so they don't throw away the rest of the chunk. The unused tail of the last chunk is wasted
+  when the producer stops.
+
+  Chunks belong to the shared arena, so after EndTempMem/ArenaClear on it every producer has to be reset before pushing again.
+  
+ */
+
+#ifndef ARENA_PRODUCER_DEFAULT_CHUNK_SIZE
+#define ARENA_PRODUCER_DEFAULT_CHUNK_SIZE KiloBytes(16)
+#endif
+
+// NOTE: Chunks are aligned to a cache line so two producers never write to the same line
+#define ARENA_PRODUCER_CHUNK_ALIGNMENT 64
+
+template<typename arena>
+struct arena_producer
+{
+    arena* Arena;
+    u8* Mem;
+    mm Used;
+    mm Size;
+    mm ChunkSize;
+};
@@ -9,161 +9,985 @@
   going to be partitioned into smaller blocks that various other systems can allocate. We also want these systems to have the ability
   to free these allocations, which just adds these blocks to a free list. If all blocks in a allocation are free, we free the entire
   large allocation. 
+
+  Fresh platform blocks are carved lazily: each header keeps a bump cursor (NumCarvedBlocks) and we only hand out never used blocks
+  from it once its free list is empty. We never walk the whole mapping up front, so pages get touched (and become resident) only
+  when a block on them actually gets allocated.
+
+  In NUMA mode every platform block gets bound to the node of the thread that mapped it and each node keeps its own free list (and
+  stack/carve block in concurrent mode). Allocations only look at the node of the calling thread and map a new platform block for it
+  when that node has nothing free, so a block arena always gets memory local to the thread pushing onto it. Freed blocks go back to
+  the node they came from. On single node machines (or without the flag) everything lives on node 0 and behaves like before.
+  
+ */
+
+inline mm PlatformBlockArenaGetHeaderSize()
+{
+    mm Result = AlignAddress(u64(sizeof(platform_block_header)), u64(PLATFORM_BLOCK_ALIGNMENT));
+    return Result;
+}
+
+inline mm PlatformBlockArenaNumBlocks(platform_block_arena* Arena)
+{
+    mm Result = (Arena->PlatformBlockSize - PlatformBlockArenaGetHeaderSize()) / Arena->BlockSize;
+    return Result;
+}
+
+inline u32 PlatformBlockArenaGetNode(platform_block_arena* Arena, u32* OsNode = 0)
+{
+    // NOTE: Returns the index of the node list for the calling thread. Machines with more than PLATFORM_BLOCK_MAX_NODES nodes fold
+    // several nodes onto one list, so memory we map gets bound to OsNode (the node the thread actually runs on) instead
+    u32 Result = 0;
+    u32 CurrentNode = 0;
+    if (Arena->NumNodes > 1)
+    {
+        CurrentNode = MemoryGetCurrentNumaNode();
+        Result = CurrentNode % Arena->NumNodes;
+    }
+
+    if (OsNode)
+    {
+        *OsNode = CurrentNode;
+    }
+    
+    return Result;
+}
+
+inline block* PlatformBlockArenaGetBlockById(platform_block_arena* Arena, platform_block_header* PlatformHeader, mm BlockId)
+{
+    block* Result = (block*)((u8*)PlatformHeader + PlatformBlockArenaGetHeaderSize() + BlockId*Arena->BlockSize);
+    return Result;
+}
+
+inline mm PlatformBlockGetPurgeRange(platform_block_arena* Arena, block* Block, u8** Start)
+{
+    // NOTE: Whole OS pages past the block struct, the struct has to stay resident since free lists run through it
+    mm Granularity = MemoryGetAllocSize(1, Arena->Flags);
+    mm First = (mm(Block + 1) + Granularity - 1) & ~(Granularity - 1);
+    mm End = (mm(Block) + Arena->BlockSize) & ~(Granularity - 1);
+    *Start = (u8*)First;
+    
+    mm Result = End > First ? End - First : 0;
+    return Result;
+}
+
+// NOTE: Every create/clear gets a new generation so stale per thread caches can tell they point to released memory
+static volatile u32 PlatformBlockArenaGenerationCounter;
+
+inline platform_block_arena PlatformBlockArenaCreate(mm PlatformBlockSize, mm NumBlocks, u32 Flags = 0, u32 ArenaFlags = 0)
+{
+    // NOTE: The OS rounds our blocks up to its page size (2MB for huge pages) so we hand that space out instead of wasting it
+    platform_block_arena Result = {};
+    Result.Flags = Flags;
+    Result.ArenaFlags = ArenaFlags;
+    Result.PlatformBlockSize = MemoryGetAllocSize(PlatformBlockSize, Flags);
+    Result.BlockSize = ((Result.PlatformBlockSize - PlatformBlockArenaGetHeaderSize()) / NumBlocks) & ~mm(PLATFORM_BLOCK_ALIGNMENT - 1);
+    Assert(Result.BlockSize >= sizeof(block));
+    Result.Generation = AtomicAddU32(&PlatformBlockArenaGenerationCounter, 1) + 1;
+    Result.NumNodes = 1;
+    if (ArenaFlags & PlatformBlockArenaFlag_Numa)
+    {
+        Result.NumNodes = Min(MemoryGetNumaNodeCount(), u32(PLATFORM_BLOCK_MAX_NODES));
+    }
+
+    // NOTE: Aligned arenas find headers by masking pointers so the platform block size has to be a power of 2
+    Assert(!(ArenaFlags & PlatformBlockArenaFlag_Aligned) || (Result.PlatformBlockSize & (Result.PlatformBlockSize - 1)) == 0);
+
+    return Result;
+}
+
+inline platform_block_header* PlatformBlockArenaMapHeader(platform_block_arena* Arena, u32 Node, u32 OsNode)
+{
+    platform_block_header* Result = 0;
+    if (Arena->ArenaFlags & PlatformBlockArenaFlag_Aligned)
+    {
+        Result = (platform_block_header*)MemoryAllocateAligned(Arena->PlatformBlockSize, Arena->PlatformBlockSize, Arena->Flags);
+    }
+    else
+    {
+        Result = (platform_block_header*)MemoryAllocate(Arena->PlatformBlockSize, Arena->Flags);
+    }
+    Assert(Result);
+
+    if (Arena->NumNodes > 1)
+    {
+        // NOTE: Nothing touched the pages yet, if binding isn't supported first touch from this thread puts them on OsNode anyway
+        MemoryBindToNode(Result, Arena->PlatformBlockSize, OsNode);
+    }
+    *Result = {};
+    Result->Node = Node;
+
+    return Result;
+}
+
+inline block* PlatformBlockArenaGetBlock(platform_block_arena* Arena, void* Mem)
+{
+    // NOTE: Finds the block that holds Mem, only works for aligned arenas
+    Assert(Arena->ArenaFlags & PlatformBlockArenaFlag_Aligned);
+    platform_block_header* PlatformHeader = (platform_block_header*)(mm(Mem) & ~(Arena->PlatformBlockSize - 1));
+    mm BlockId = (mm(Mem) - mm(PlatformHeader) - PlatformBlockArenaGetHeaderSize()) / Arena->BlockSize;
+    block* Result = PlatformBlockArenaGetBlockById(Arena, PlatformHeader, BlockId);
+    
+    return Result;
+}
+
+//
+// NOTE: Concurrent Platform Block Arena
+//
+
+/*
+
+  In concurrent mode each thread keeps a small magazine of blocks per arena, so most allocate/free calls never touch shared memory.
+  When a magazine runs dry it pulls blocks from a global lock free stack, and when it overflows it pushes half of its blocks back, so
+  blocks freed on a different thread than the one that allocated them flow back through the stack. The stack head carries a 16 bit
+  tag that changes on every update which protects the pop against ABA. Only mapping a new platform block takes a (spin) lock.
+
+  Platform blocks are never given back to the OS in this mode since no single thread knows when one is completely free, they get
+  released by ArenaClear which has to be called once all threads are done with the arena. Threads that stop using an arena should call
+  PlatformBlockArenaFlushThreadCache so their cached blocks can be reused by others, and a thread that exits flushes all of its
+  magazines on the way out. ArenaClear is also how a concurrent arena gets destroyed, it takes the arena off the live list that
+  magazines get checked against. Putting a new arena at the address of one that went away without it asserts.
   
  */
 
-inline mm PlatformBlockArenaNumBlocks(platform_block_arena* Arena)
-{
-    mm Result = (Arena->PlatformBlockSize - sizeof(platform_block_header)) / Arena->BlockSize;
-    return Result;
+static thread_local u32 PlatformBlockMagazineEvictId;
+
+/*
+  NOTE: A magazine can outlive its arena, so evicting one can't read through its Arena pointer. Instead arenas that threads hold
+  magazines for sit on a global live list, and eviction only flushes into an arena it finds on that list with the generation the
+  magazine was filled at. ArenaClear takes the arena off the list under the same lock, so a flush never races a clear, and magazines of
+  cleared or dead arenas just get dropped.
+ */
+static volatile u32 PlatformBlockLiveLock;
+static platform_block_arena* PlatformBlockLiveArenas;
+
+#define PLATFORM_BLOCK_TAG_SHIFT 48
+#define PLATFORM_BLOCK_PTR_MASK ((u64(1) << PLATFORM_BLOCK_TAG_SHIFT) - 1)
+
+// NOTE: Blocks on the global stacks only use Next, the purger marks the ones it gave back to the OS through Prev
+#define PLATFORM_BLOCK_PURGED ((block*)1)
+
+inline block* PlatformBlockStackPop(platform_block_arena* Arena, u32 Node)
+{
+    block* Result = 0;
+    
+    volatile u64* FreeStack = &Arena->Nodes[Node].FreeStack;
+    u64 OldHead = AtomicLoadU64(FreeStack);
+    while (OldHead & PLATFORM_BLOCK_PTR_MASK)
+    {
+        // NOTE: Head can get popped and reused under us, the memory stays mapped so reading Next is safe and the tag makes the CAS fail
+        block* Head = (block*)(OldHead & PLATFORM_BLOCK_PTR_MASK);
+        u64 NewTag = ((OldHead >> PLATFORM_BLOCK_TAG_SHIFT) + 1) << PLATFORM_BLOCK_TAG_SHIFT;
+        u64 NewHead = NewTag | u64(Head->Next);
+        u64 PrevHead = AtomicCompareExchangeU64(FreeStack, OldHead, NewHead);
+        if (PrevHead == OldHead)
+        {
+            Result = Head;
+            break;
+        }
+        OldHead = PrevHead;
+    }
+
+    if (Result && Result->Prev == PLATFORM_BLOCK_PURGED)
+    {
+        // NOTE: We own the block now so nobody else can see the mark
+        u8* PurgeStart = 0;
+        mm PurgeSize = PlatformBlockGetPurgeRange(Arena, Result, &PurgeStart);
+        AtomicAddU64(&Arena->NumPurgedBlocks, ~u64(0));
+        AtomicAddU64(&Arena->PurgedSize, u64(0) - PurgeSize);
+        Result->Prev = 0;
+    }
+
+    return Result;
+}
+
+inline void PlatformBlockStackPushChain(platform_block_arena* Arena, u32 Node, block* First, block* Last, mm NumBlocks)
+{
+    // NOTE: First..Last have to already be linked through Next and come from Node
+    Assert((u64(First) & ~PLATFORM_BLOCK_PTR_MASK) == 0);
+
+    // NOTE: Count goes up before the blocks become visible so poppers never take it below 0
+    platform_block_node* ArenaNode = Arena->Nodes + Node;
+    AtomicAddU64(&ArenaNode->NumStackBlocks, NumBlocks);
+    if (Arena->PurgeDecayNs)
+    {
+        AtomicStoreU64(&ArenaNode->LastFreeTimeNs, MemoryGetTimeNs());
+    }
+    
+    volatile u64* FreeStack = &ArenaNode->FreeStack;
+    u64 OldHead = AtomicLoadU64(FreeStack);
+    for (;;)
+    {
+        Last->Next = (block*)(OldHead & PLATFORM_BLOCK_PTR_MASK);
+        u64 NewTag = ((OldHead >> PLATFORM_BLOCK_TAG_SHIFT) + 1) << PLATFORM_BLOCK_TAG_SHIFT;
+        u64 PrevHead = AtomicCompareExchangeU64(FreeStack, OldHead, NewTag | u64(First));
+        if (PrevHead == OldHead)
+        {
+            break;
+        }
+        OldHead = PrevHead;
+    }
+}
+
+inline void PlatformBlockMagazineFlush(platform_block_magazine* Magazine, u32 NumBlocks)
+{
+    // NOTE: Push the top NumBlocks blocks of the magazine back to the global stack
+    Assert(NumBlocks <= Magazine->NumBlocks);
+    if (NumBlocks)
+    {
+        u32 FirstId = Magazine->NumBlocks - NumBlocks;
+        for (u32 BlockId = FirstId; BlockId < Magazine->NumBlocks - 1; ++BlockId)
+        {
+            Magazine->Blocks[BlockId]->Next = Magazine->Blocks[BlockId + 1];
+        }
+        PlatformBlockStackPushChain(Magazine->Arena, Magazine->Node, Magazine->Blocks[FirstId], Magazine->Blocks[Magazine->NumBlocks - 1], NumBlocks);
+        Magazine->NumBlocks = FirstId;
+    }
+}
+
+inline void PlatformBlockArenaMakeLive(platform_block_arena* Arena)
+{
+    if (!AtomicLoadU32(&Arena->IsLive))
+    {
+        SpinLockAcquire(&PlatformBlockLiveLock);
+        if (!Arena->IsLive)
+        {
+#if !defined(NDEBUG)
+            // NOTE: An entry for our address means the arena that lived here was never cleared, its list links are gone now
+            for (platform_block_arena* LiveArena = PlatformBlockLiveArenas; LiveArena; LiveArena = LiveArena->NextLive)
+            {
+                Assert(LiveArena != Arena);
+            }
+#endif
+            Arena->PrevLive = 0;
+            Arena->NextLive = PlatformBlockLiveArenas;
+            if (PlatformBlockLiveArenas)
+            {
+                PlatformBlockLiveArenas->PrevLive = Arena;
+            }
+            PlatformBlockLiveArenas = Arena;
+            AtomicStoreU32(&Arena->IsLive, 1);
+        }
+        SpinLockRelease(&PlatformBlockLiveLock);
+    }
+}
+
+inline void PlatformBlockArenaRemoveLive(platform_block_arena* Arena)
+{
+    // IMPORTANT: Expects PlatformBlockLiveLock to be held
+    if (Arena->IsLive)
+    {
+        if (Arena->PrevLive)
+        {
+            Arena->PrevLive->NextLive = Arena->NextLive;
+        }
+        else
+        {
+            PlatformBlockLiveArenas = Arena->NextLive;
+        }
+        
+        if (Arena->NextLive)
+        {
+            Arena->NextLive->PrevLive = Arena->PrevLive;
+        }
+        Arena->NextLive = 0;
+        Arena->PrevLive = 0;
+        AtomicStoreU32(&Arena->IsLive, 0);
+    }
+}
+
+inline void PlatformBlockMagazineEvict(platform_block_magazine* Magazine)
+{
+    // NOTE: Only compares the magazines Arena pointer against live arenas, it might point at an arena that is gone
+    SpinLockAcquire(&PlatformBlockLiveLock);
+    for (platform_block_arena* LiveArena = PlatformBlockLiveArenas; LiveArena; LiveArena = LiveArena->NextLive)
+    {
+        if (LiveArena == Magazine->Arena)
+        {
+            if (LiveArena->Generation == Magazine->Generation)
+            {
+                PlatformBlockMagazineFlush(Magazine, Magazine->NumBlocks);
+            }
+            break;
+        }
+    }
+    SpinLockRelease(&PlatformBlockLiveLock);
+
+    *Magazine = {};
+}
+
+struct platform_block_thread_cache
+{
+    platform_block_magazine Magazines[PLATFORM_BLOCK_MAX_MAGAZINES];
+
+    ~platform_block_thread_cache()
+    {
+        // NOTE: Give cached blocks back on thread exit, otherwise they are lost until their arena gets cleared
+        for (u32 MagazineId = 0; MagazineId < PLATFORM_BLOCK_MAX_MAGAZINES; ++MagazineId)
+        {
+            if (Magazines[MagazineId].Arena)
+            {
+                PlatformBlockMagazineEvict(Magazines + MagazineId);
+            }
+        }
+    }
+};
+
+static thread_local platform_block_thread_cache PlatformBlockThreadCache;
+
+inline platform_block_magazine* PlatformBlockArenaGetMagazine(platform_block_arena* Arena, u32 Node)
+{
+    platform_block_magazine* Result = 0;
+    for (u32 MagazineId = 0; MagazineId < PLATFORM_BLOCK_MAX_MAGAZINES; ++MagazineId)
+    {
+        platform_block_magazine* Magazine = PlatformBlockThreadCache.Magazines + MagazineId;
+        if (Magazine->Arena == Arena)
+        {
+            Result = Magazine;
+            break;
+        }
+        if (!Magazine->Arena && !Result)
+        {
+            Result = Magazine;
+        }
+    }
+
+    if (!Result)
+    {
+        // NOTE: All slots are used by other arenas, evict one and give its blocks back to its arena
+        Result = PlatformBlockThreadCache.Magazines + (PlatformBlockMagazineEvictId++ % PLATFORM_BLOCK_MAX_MAGAZINES);
+        PlatformBlockMagazineEvict(Result);
+    }
+
+    if (Result->Arena != Arena || Result->Generation != Arena->Generation)
+    {
+        // NOTE: New slot or the arena got cleared since we last used it so our cached blocks are gone
+        PlatformBlockArenaMakeLive(Arena);
+        Result->Arena = Arena;
+        Result->Generation = Arena->Generation;
+        Result->Node = Node;
+        Result->NumBlocks = 0;
+    }
+    else if (Result->Node != Node)
+    {
+        // NOTE: We moved to another node, give the cached blocks back to their node and start caching local ones
+        PlatformBlockMagazineFlush(Result, Result->NumBlocks);
+        Result->Node = Node;
+    }
+    
+    return Result;
+}
+
+inline block* PlatformBlockArenaAllocateConcurrent(platform_block_arena* Arena)
+{
+    block* Result = 0;
+    u32 OsNode = 0;
+    u32 Node = PlatformBlockArenaGetNode(Arena, &OsNode);
+    platform_block_node* ArenaNode = Arena->Nodes + Node;
+    platform_block_magazine* Magazine = PlatformBlockArenaGetMagazine(Arena, Node);
+
+    if (!Magazine->NumBlocks)
+    {
+        // NOTE: Refill half the magazine from the global stack
+        for (u32 BlockId = 0; BlockId < PLATFORM_BLOCK_MAGAZINE_SIZE / 2; ++BlockId)
+        {
+            block* Block = PlatformBlockStackPop(Arena, Node);
+            if (!Block)
+            {
+                break;
+            }
+            Magazine->Blocks[Magazine->NumBlocks++] = Block;
+        }
+        AtomicAddU64(&ArenaNode->NumStackBlocks, u64(0) - Magazine->NumBlocks);
+    }
+
+    if (Magazine->NumBlocks)
+    {
+        Result = Magazine->Blocks[--Magazine->NumBlocks];
+    }
+    else
+    {
+        SpinLockAcquire(&Arena->Lock);
+
+        // NOTE: Another thread might have freed blocks or carved a new platform block while we waited
+        Result = PlatformBlockStackPop(Arena, Node);
+        if (Result)
+        {
+            AtomicAddU64(&ArenaNode->NumStackBlocks, ~u64(0));
+        }
+        else
+        {
+            mm NumBlocks = PlatformBlockArenaNumBlocks(Arena);
+            platform_block_header* PlatformHeader = ArenaNode->CarveHeader;
+            if (!PlatformHeader || PlatformHeader->NumCarvedBlocks == NumBlocks)
+            {
+                PlatformHeader = PlatformBlockArenaMapHeader(Arena, Node, OsNode);
+                DoubleListAppend(Arena, PlatformHeader, Next, Prev);
+                ArenaNode->CarveHeader = PlatformHeader;
+            }
+
+            // NOTE: Carve our result plus up to half a magazine, the rest of the platform block stays untouched for later
+            Result = PlatformBlockArenaGetBlockById(Arena, PlatformHeader, PlatformHeader->NumCarvedBlocks++);
+            Result->ParentBlock = PlatformHeader;
+            while (PlatformHeader->NumCarvedBlocks < NumBlocks && Magazine->NumBlocks < PLATFORM_BLOCK_MAGAZINE_SIZE / 2)
+            {
+                block* Block = PlatformBlockArenaGetBlockById(Arena, PlatformHeader, PlatformHeader->NumCarvedBlocks++);
+                Block->ParentBlock = PlatformHeader;
+                Magazine->Blocks[Magazine->NumBlocks++] = Block;
+            }
+        }
+        
+        SpinLockRelease(&Arena->Lock);
+    }
+
+    Result->Next = 0;
+    Result->Prev = 0;
+    
+    return Result;
+}
+
+inline void PlatformBlockArenaFreeConcurrent(platform_block_arena* Arena, block* Block)
+{
+    u32 Node = PlatformBlockArenaGetNode(Arena);
+    if (Block->ParentBlock->Node != Node)
+    {
+        // NOTE: Remote block, skip our magazine so it only ever caches blocks local to this thread
+        PlatformBlockStackPushChain(Arena, Block->ParentBlock->Node, Block, Block, 1);
+        return;
+    }
+    
+    platform_block_magazine* Magazine = PlatformBlockArenaGetMagazine(Arena, Node);
+    if (Magazine->NumBlocks == PLATFORM_BLOCK_MAGAZINE_SIZE)
+    {
+        PlatformBlockMagazineFlush(Magazine, PLATFORM_BLOCK_MAGAZINE_SIZE / 2);
+    }
+    Magazine->Blocks[Magazine->NumBlocks++] = Block;
+}
+
+inline void PlatformBlockArenaFlushThreadCache(platform_block_arena* Arena)
+{
+    for (u32 MagazineId = 0; MagazineId < PLATFORM_BLOCK_MAX_MAGAZINES; ++MagazineId)
+    {
+        platform_block_magazine* Magazine = PlatformBlockThreadCache.Magazines + MagazineId;
+        if (Magazine->Arena == Arena)
+        {
+            if (Magazine->Generation == Arena->Generation)
+            {
+                PlatformBlockMagazineFlush(Magazine, Magazine->NumBlocks);
+            }
+            *Magazine = {};
+        }
+    }
+}
+
+//
+// NOTE: Platform Block Arena
+//
+
+inline void PlatformBlockNodeAddFree(platform_block_node* ArenaNode, platform_block_header* PlatformHeader)
+{
+    // NOTE: Chain header to our list of headers with free space
+    PlatformHeader->FreeNext = ArenaNode->FreeList;
+    PlatformHeader->FreePrev = 0;
+    if (PlatformHeader->FreeNext)
+    {
+        PlatformHeader->FreeNext->FreePrev = PlatformHeader;
+    }
+    ArenaNode->FreeList = PlatformHeader;
+}
+
+inline void PlatformBlockNodeRemoveFree(platform_block_node* ArenaNode, platform_block_header* PlatformHeader)
+{
+    if (PlatformHeader->FreeNext)
+    {
+        PlatformHeader->FreeNext->FreePrev = PlatformHeader->FreePrev;
+    }
+    if (PlatformHeader->FreePrev)
+    {
+        PlatformHeader->FreePrev->FreeNext = PlatformHeader->FreeNext;
+    }
+    else
+    {
+        ArenaNode->FreeList = PlatformHeader->FreeNext;
+    }
+    PlatformHeader->FreeNext = 0;
+    PlatformHeader->FreePrev = 0;
+}
+
+inline platform_block_header* PlatformBlockArenaGetFreeHeader(platform_block_arena* Arena, platform_block_node* ArenaNode, u32 OsNode)
+{
+    // NOTE: Free list is empty so allocate a new platform block, only its header gets touched
+    platform_block_header* Result = ArenaNode->FreeList;
+    if (!Result)
+    {
+        Result = PlatformBlockArenaMapHeader(Arena, u32(ArenaNode - Arena->Nodes), OsNode);
+        Result->NumFreeBlocks = PlatformBlockArenaNumBlocks(Arena);
+        DoubleListAppend(Arena, Result, Next, Prev);
+        PlatformBlockNodeAddFree(ArenaNode, Result);
+    }
+
+    return Result;
+}
+
+inline block* PlatformBlockHeaderTakeBlock(platform_block_arena* Arena, platform_block_header* PlatformHeader)
+{
+    // NOTE: Caller already took the block out of NumFreeBlocks
+    block* Result = 0;
+    if (PlatformHeader->FreeBlocks)
+    {
+        // NOTE: Reuse a freed block, dirty blocks come first so we only hit purged ones once those ran out
+        Result = PlatformHeader->FreeBlocks;
+        FreeListRemove(PlatformHeader->FreeBlocks, Result, Next, Prev);
+        if (PlatformHeader->NumDirtyBlocks)
+        {
+            PlatformHeader->NumDirtyBlocks -= 1;
+        }
+        else
+        {
+            u8* PurgeStart = 0;
+            mm PurgeSize = PlatformBlockGetPurgeRange(Arena, Result, &PurgeStart);
+            PlatformHeader->PurgedSize -= PurgeSize;
+            Arena->PurgedSize -= PurgeSize;
+        }
+    }
+    else
+    {
+        // NOTE: Carve a never used block
+        Assert(PlatformHeader->NumCarvedBlocks < PlatformBlockArenaNumBlocks(Arena));
+        Result = PlatformBlockArenaGetBlockById(Arena, PlatformHeader, PlatformHeader->NumCarvedBlocks++);
+    }
+    *Result = {};
+    Result->ParentBlock = PlatformHeader;
+
+    return Result;
+}
+
+inline block* PlatformBlockArenaAllocate(platform_block_arena* Arena)
+{
+    if (Arena->ArenaFlags & PlatformBlockArenaFlag_Concurrent)
+    {
+        return PlatformBlockArenaAllocateConcurrent(Arena);
+    }
+    
+    u32 OsNode = 0;
+    platform_block_node* ArenaNode = Arena->Nodes + PlatformBlockArenaGetNode(Arena, &OsNode);
+    platform_block_header* PlatformHeader = PlatformBlockArenaGetFreeHeader(Arena, ArenaNode, OsNode);
+    
+    Assert(PlatformHeader->NumFreeBlocks > 0);
+    PlatformHeader->NumFreeBlocks -= 1;
+    if (PlatformHeader->NumFreeBlocks == 0)
+    {
+        // NOTE: Remove the platform block from free list
+        PlatformBlockNodeRemoveFree(ArenaNode, PlatformHeader);
+    }
+
+    // NOTE: Its next and prev will get linked by block arena
+    block* Result = PlatformBlockHeaderTakeBlock(Arena, PlatformHeader);
+    return Result;
+}
+
+inline void PlatformBlockArenaFreeRun(platform_block_arena* Arena, block* First, block* Last, mm NumBlocks)
+{
+    // NOTE: First..Last all come from the same platform block and are linked through Next/Prev
+    platform_block_header* PlatformHeader = First->ParentBlock;
+    platform_block_node* ArenaNode = Arena->Nodes + PlatformHeader->Node;
+
+    b32 WasFull = PlatformHeader->NumFreeBlocks == 0;
+    PlatformHeader->NumFreeBlocks += NumBlocks;
+    Assert(PlatformHeader->NumFreeBlocks <= PlatformBlockArenaNumBlocks(Arena));
+    
+    if (PlatformHeader->NumFreeBlocks == PlatformBlockArenaNumBlocks(Arena))
+    {
+        // NOTE: This platform block is completely empty so we can free it
+        if (Arena->PurgeCursor == PlatformHeader)
+        {
+            Arena->PurgeCursor = PlatformHeader->Next;
+        }
+        Arena->PurgedSize -= PlatformHeader->PurgedSize;
+        DoubleListRemove(Arena, PlatformHeader, Next, Prev);
+        if (!WasFull)
+        {
+            PlatformBlockNodeRemoveFree(ArenaNode, PlatformHeader);
+        }
+        
+        MemoryFree(PlatformHeader, Arena->PlatformBlockSize, Arena->Flags);
+    }
+    else
+    {
+        // NOTE: We still have blocks in use so splice the run onto its free blocks
+        First->Prev = 0;
+        Last->Next = PlatformHeader->FreeBlocks;
+        if (Last->Next)
+        {
+            Last->Next->Prev = Last;
+        }
+        PlatformHeader->FreeBlocks = First;
+        PlatformHeader->NumDirtyBlocks += NumBlocks;
+        if (Arena->PurgeDecayNs)
+        {
+            PlatformHeader->LastFreeTimeNs = MemoryGetTimeNs();
+        }
+
+        if (WasFull)
+        {
+            // NOTE: Platform block was full so it isn't in the free list yet
+            PlatformBlockNodeAddFree(ArenaNode, PlatformHeader);
+        }
+    }
 }
 
-inline platform_block_arena PlatformBlockArenaCreate(mm PlatformBlockSize, mm NumBlocks)
+inline void PlatformBlockArenaFree(platform_block_arena* Arena, block* Block)
 {
-    platform_block_arena Result = {};
-    Result.PlatformBlockSize = PlatformBlockSize;
-    Result.BlockSize = (PlatformBlockSize - sizeof(platform_block_header)) / NumBlocks;
-
-    return Result;
+    if (Arena->ArenaFlags & PlatformBlockArenaFlag_Concurrent)
+    {
+        PlatformBlockArenaFreeConcurrent(Arena, Block);
+        return;
+    }
+    
+    PlatformBlockArenaFreeRun(Arena, Block, Block, 1);
 }
 
-inline block* PlatformBlockArenaAllocate(platform_block_arena* Arena)
+//
+// NOTE: Bulk allocate/free
+//
+
+/*
+
+  NOTE: Batch versions of allocate/free that do their bookkeeping once per platform block instead of once per block. Allocating takes
+  as many blocks as it can from each platform block before touching the free lists, freeing walks a chain of blocks (like the list of
+  a block_arena) and splices every run of blocks that share a platform block onto it with one list operation. In concurrent mode the
+  runs go straight onto the global stacks with one CAS each, skipping the per thread magazines.
+  
+ */
+
+inline void PlatformBlockArenaAllocateBatchConcurrent(platform_block_arena* Arena, block** Blocks, mm NumBlocks)
 {
-    block* Result = 0;
+    mm NumAllocated = 0;
+    u32 OsNode = 0;
+    u32 Node = PlatformBlockArenaGetNode(Arena, &OsNode);
+    platform_block_node* ArenaNode = Arena->Nodes + Node;
+    platform_block_magazine* Magazine = PlatformBlockArenaGetMagazine(Arena, Node);
+
+    while (NumAllocated < NumBlocks && Magazine->NumBlocks)
+    {
+        Blocks[NumAllocated++] = Magazine->Blocks[--Magazine->NumBlocks];
+    }
     
-    if (Arena->FreeList)
+    mm NumPopped = 0;
+    while (NumAllocated < NumBlocks)
     {
-        // NOTE: Free list has space so grab a free block
-        platform_block_header* CurrPlatformHeader = Arena->FreeList;
-        Assert(CurrPlatformHeader->FreeBlocks && CurrPlatformHeader->NumFreeBlocks > 0);
-        CurrPlatformHeader->NumFreeBlocks -= 1;
-        if (CurrPlatformHeader->NumFreeBlocks == 0)
+        block* Block = PlatformBlockStackPop(Arena, Node);
+        if (!Block)
         {
-            // NOTE: Remove the platform block from free list
-            FreeListRemove(Arena->FreeList, CurrPlatformHeader, FreeNext, FreePrev);
+            break;
         }
-
-        // NOTE: Remove the block from the free list
-        Result = CurrPlatformHeader->FreeBlocks;
-        FreeListRemove(CurrPlatformHeader->FreeBlocks, Result, Next, Prev);
-        *Result = {};
-        Result->ParentBlock = CurrPlatformHeader;
+        Blocks[NumAllocated++] = Block;
+        NumPopped += 1;
     }
-    else
+    AtomicAddU64(&ArenaNode->NumStackBlocks, u64(0) - NumPopped);
+
+    if (NumAllocated < NumBlocks)
     {
-        // NOTE: Free list is empty so allocate a new platform block
-        platform_block_header* PlatformHeader = (platform_block_header*)MemoryAllocate(Arena->PlatformBlockSize);
-        *PlatformHeader = {};
-        PlatformHeader->NumFreeBlocks = PlatformBlockArenaNumBlocks(Arena) - 1;
+        // NOTE: Carve the rest under one lock, mapping as many platform blocks as we need
+        SpinLockAcquire(&Arena->Lock);
 
-        // NOTE: Chain header to our list of headers
-        DoubleListAppend(Arena, PlatformHeader, Next, Prev);
-        
-        // NOTE: Grab first block for our result (its next and prev will get linked by block arena)
-        mm BlockId = 0;
-        Result = (block*)(PlatformHeader + 1);
-        Result->ParentBlock = PlatformHeader;
-        BlockId += 1;
-        
-        // NOTE: Add all blocks except first to free list
-        if (BlockId < PlatformBlockArenaNumBlocks(Arena))
-        {
-            // NOTE: Chain header to our list of headers with free space
-            // TODO: Make this a macro
-            PlatformHeader->FreeNext = Arena->FreeList;
-            PlatformHeader->FreePrev = 0;
-            if (PlatformHeader->FreeNext)
+        mm NumBlocksPerPlatform = PlatformBlockArenaNumBlocks(Arena);
+        while (NumAllocated < NumBlocks)
+        {
+            platform_block_header* PlatformHeader = ArenaNode->CarveHeader;
+            if (!PlatformHeader || PlatformHeader->NumCarvedBlocks == NumBlocksPerPlatform)
+            {
+                PlatformHeader = PlatformBlockArenaMapHeader(Arena, Node, OsNode);
+                DoubleListAppend(Arena, PlatformHeader, Next, Prev);
+                ArenaNode->CarveHeader = PlatformHeader;
+            }
+
+            mm NumCarved = Min(NumBlocksPerPlatform - PlatformHeader->NumCarvedBlocks, NumBlocks - NumAllocated);
+            for (mm BlockId = 0; BlockId < NumCarved; ++BlockId)
             {
-                PlatformHeader->FreeNext->FreePrev = PlatformHeader;
+                block* Block = PlatformBlockArenaGetBlockById(Arena, PlatformHeader, PlatformHeader->NumCarvedBlocks++);
+                Block->ParentBlock = PlatformHeader;
+                Blocks[NumAllocated++] = Block;
             }
-            Arena->FreeList = PlatformHeader;
+        }
+        
+        SpinLockRelease(&Arena->Lock);
+    }
+
+    for (mm BlockId = 0; BlockId < NumBlocks; ++BlockId)
+    {
+        Blocks[BlockId]->Next = 0;
+        Blocks[BlockId]->Prev = 0;
+    }
+}
 
-            u8* StartBlockPointer = (u8*)Result + Arena->BlockSize;
-            PlatformHeader->FreeBlocks = (block*)StartBlockPointer;
-            PlatformHeader->FreeBlocks->Prev = 0;
-            PlatformHeader->FreeBlocks->ParentBlock = PlatformHeader;
-            StartBlockPointer += Arena->BlockSize;
-            BlockId += 1;
+inline void PlatformBlockArenaAllocateBatch(platform_block_arena* Arena, block** Blocks, mm NumBlocks)
+{
+    // NOTE: Fills Blocks with NumBlocks blocks, unlinked like the result of PlatformBlockArenaAllocate
+    if (Arena->ArenaFlags & PlatformBlockArenaFlag_Concurrent)
+    {
+        PlatformBlockArenaAllocateBatchConcurrent(Arena, Blocks, NumBlocks);
+        return;
+    }
+
+    mm NumAllocated = 0;
+    u32 OsNode = 0;
+    platform_block_node* ArenaNode = Arena->Nodes + PlatformBlockArenaGetNode(Arena, &OsNode);
+    while (NumAllocated < NumBlocks)
+    {
+        platform_block_header* PlatformHeader = PlatformBlockArenaGetFreeHeader(Arena, ArenaNode, OsNode);
+        
+        mm NumTaken = Min(PlatformHeader->NumFreeBlocks, NumBlocks - NumAllocated);
+        PlatformHeader->NumFreeBlocks -= NumTaken;
+        if (PlatformHeader->NumFreeBlocks == 0)
+        {
+            PlatformBlockNodeRemoveFree(ArenaNode, PlatformHeader);
+        }
 
-            for (; BlockId < PlatformHeader->NumFreeBlocks; ++BlockId, StartBlockPointer += Arena->BlockSize)
+        for (mm BlockId = 0; BlockId < NumTaken; ++BlockId)
+        {
+            Blocks[NumAllocated++] = PlatformBlockHeaderTakeBlock(Arena, PlatformHeader);
+        }
+    }
+}
+
+inline mm PlatformBlockArenaFreeChain(platform_block_arena* Arena, block* First)
+{
+    // NOTE: Frees First and every block after it through Next, returns how many blocks got freed
+    mm Result = 0;
+    b32 Concurrent = Arena->ArenaFlags & PlatformBlockArenaFlag_Concurrent;
+    
+    block* Block = First;
+    while (Block)
+    {
+        // NOTE: Concurrent runs only have to share a node, others have to share a platform block
+        platform_block_header* PlatformHeader = Block->ParentBlock;
+        u32 Node = PlatformHeader->Node;
+        
+        block* RunFirst = Block;
+        block* RunLast = Block;
+        mm NumRunBlocks = 1;
+        for (Block = Block->Next; Block; Block = Block->Next)
+        {
+            if (Concurrent ? Block->ParentBlock->Node != Node : Block->ParentBlock != PlatformHeader)
             {
-                block* CurrFreeBlock = (block*)StartBlockPointer;
-                CurrFreeBlock->ParentBlock = PlatformHeader;
-                CurrFreeBlock->Next = (block*)(StartBlockPointer + Arena->BlockSize);
-                CurrFreeBlock->Prev = (block*)(StartBlockPointer - Arena->BlockSize);
-                CurrFreeBlock->Prev->Next = CurrFreeBlock;
+                break;
             }
+            Block->Prev = RunLast;
+            RunLast = Block;
+            NumRunBlocks += 1;
+        }
+        Result += NumRunBlocks;
 
-            block* CurrFreeBlock = (block*)StartBlockPointer;
-            CurrFreeBlock->ParentBlock = PlatformHeader;
-            CurrFreeBlock->Next = 0;
-            CurrFreeBlock->Prev = (block*)(StartBlockPointer - Arena->BlockSize);
-            CurrFreeBlock->Prev->Next = CurrFreeBlock;
-        }        
+        if (Concurrent)
+        {
+            PlatformBlockStackPushChain(Arena, Node, RunFirst, RunLast, NumRunBlocks);
+        }
+        else
+        {
+            PlatformBlockArenaFreeRun(Arena, RunFirst, RunLast, NumRunBlocks);
+        }
     }
 
     return Result;
 }
 
-inline void PlatformBlockArenaFree(platform_block_arena* Arena, block* Block)
+//
+// NOTE: Decay purging
+//
+
+/*
+
+  NOTE: Platform blocks only go back to the OS once all of their blocks are free, so a few long lived blocks can pin a lot of memory
+  after a spike. With a decay time set, PlatformBlockArenaPurge gives the pages of free blocks back to the OS (MemoryPurge) once they
+  sat unused for that long, while keeping the mapping so they can be reused without another system call. The block struct at the
+  start of a block has to stay around, so only blocks spanning whole pages past it give anything back.
+
+  Decay is tracked per platform block (per node stack in concurrent mode): all dirty blocks of a platform block get purged once it
+  went DecayNs without a free, so platform blocks that keep churning never get purged. Each platform block keeps its dirty blocks in
+  front of its purged ones and allocations take from the front, so warm blocks get reused first.
+
+  Purge is incremental, each call gives back at most MaxPurgeSize bytes and continues where the last one stopped. For non concurrent
+  arenas it has to run on the thread that owns the arena, concurrent arenas can purge from any thread (a background thread calling
+  it every now and then works well), the purger pops a whole node stack, purges it and pushes it back. Blocks sitting in per thread
+  magazines don't get purged.
+  
+ */
+
+inline void PlatformBlockArenaSetDecay(platform_block_arena* Arena, u64 DecayNs, b32 Lazy = false)
 {
-    platform_block_header* PlatformHeader = Block->ParentBlock;
+    // NOTE: DecayNs = 0 turns purging off, Lazy uses MADV_FREE / MEM_RESET which is cheaper but only lowers RSS under memory pressure
+    Arena->PurgeDecayNs = DecayNs;
+    Arena->PurgeLazy = Lazy;
+}
 
-    PlatformHeader->NumFreeBlocks += 1;
-    if (PlatformHeader->NumFreeBlocks == PlatformBlockArenaNumBlocks(Arena))
+inline mm PlatformBlockArenaPurgeConcurrent(platform_block_arena* Arena, u64 NowNs, mm MaxPurgeSize)
+{
+    mm Result = 0;
+    for (u32 NodeId = 0; NodeId < Arena->NumNodes && Result < MaxPurgeSize; ++NodeId)
     {
-        // NOTE: This platform block is completely empty so we can free it
+        platform_block_node* ArenaNode = Arena->Nodes + NodeId;
+        if (AtomicLoadU64(&ArenaNode->NumStackBlocks) == 0 || NowNs - AtomicLoadU64(&ArenaNode->LastFreeTimeNs) < Arena->PurgeDecayNs)
+        {
+            continue;
+        }
 
-        // NOTE: Unlink from list of platform blocks
-        DoubleListRemove(Arena, PlatformHeader, Next, Prev);
-#if 0
-        // TODO: Make this a macro
-        if (PlatformHeader->Prev)
+        // NOTE: Take the whole stack so no other thread can reuse a block while we purge it
+        u64 OldHead = AtomicLoadU64(&ArenaNode->FreeStack);
+        while (OldHead & PLATFORM_BLOCK_PTR_MASK)
         {
-            PlatformHeader->Prev->Next = PlatformHeader->Next;
+            u64 NewTag = ((OldHead >> PLATFORM_BLOCK_TAG_SHIFT) + 1) << PLATFORM_BLOCK_TAG_SHIFT;
+            u64 PrevHead = AtomicCompareExchangeU64(&ArenaNode->FreeStack, OldHead, NewTag);
+            if (PrevHead == OldHead)
+            {
+                break;
+            }
+            OldHead = PrevHead;
         }
-        else
+
+        block* First = (block*)(OldHead & PLATFORM_BLOCK_PTR_MASK);
+        if (!First)
         {
-            Arena->Prev = 0;
+            continue;
         }
-        
-        if (PlatformHeader->Next)
+
+        block* Last = 0;
+        mm NumBlocks = 0;
+        for (block* Block = First; Block; Block = Block->Next)
         {
-            PlatformHeader->Next->Prev = PlatformHeader->Prev;
+            if (Block->Prev != PLATFORM_BLOCK_PURGED && Result < MaxPurgeSize)
+            {
+                u8* PurgeStart = 0;
+                mm PurgeSize = PlatformBlockGetPurgeRange(Arena, Block, &PurgeStart);
+                if (PurgeSize)
+                {
+                    MemoryPurge(PurgeStart, PurgeSize, Arena->PurgeLazy);
+                }
+                Block->Prev = PLATFORM_BLOCK_PURGED;
+                AtomicAddU64(&Arena->NumPurgedBlocks, 1);
+                AtomicAddU64(&Arena->PurgedSize, PurgeSize);
+                Result += PurgeSize;
+            }
+            
+            Last = Block;
+            NumBlocks += 1;
         }
-        else
+
+        AtomicAddU64(&ArenaNode->NumStackBlocks, u64(0) - NumBlocks);
+        PlatformBlockStackPushChain(Arena, NodeId, First, Last, NumBlocks);
+    }
+
+    return Result;
+}
+
+inline mm PlatformBlockArenaPurge(platform_block_arena* Arena, mm MaxPurgeSize = ~mm(0))
+{
+    // NOTE: Returns how many bytes we gave back to the OS
+    if (!Arena->PurgeDecayNs)
+    {
+        return 0;
+    }
+    
+    u64 NowNs = MemoryGetTimeNs();
+    if (Arena->ArenaFlags & PlatformBlockArenaFlag_Concurrent)
+    {
+        return PlatformBlockArenaPurgeConcurrent(Arena, NowNs, MaxPurgeSize);
+    }
+
+    mm Result = 0;
+    platform_block_header* StartHeader = Arena->PurgeCursor ? Arena->PurgeCursor : Arena->Next;
+    platform_block_header* PlatformHeader = StartHeader;
+    while (PlatformHeader)
+    {
+        if (PlatformHeader->NumDirtyBlocks && NowNs - PlatformHeader->LastFreeTimeNs >= Arena->PurgeDecayNs)
         {
-            Arena->Next = 0;
+            // NOTE: Purge from the last dirty block backwards so the dirty blocks stay in front of the purged ones
+            block* Block = PlatformHeader->FreeBlocks;
+            for (mm BlockId = 1; BlockId < PlatformHeader->NumDirtyBlocks; ++BlockId)
+            {
+                Block = Block->Next;
+            }
+
+            while (PlatformHeader->NumDirtyBlocks && Result < MaxPurgeSize)
+            {
+                u8* PurgeStart = 0;
+                mm PurgeSize = PlatformBlockGetPurgeRange(Arena, Block, &PurgeStart);
+                if (PurgeSize)
+                {
+                    MemoryPurge(PurgeStart, PurgeSize, Arena->PurgeLazy);
+                }
+                PlatformHeader->PurgedSize += PurgeSize;
+                PlatformHeader->NumDirtyBlocks -= 1;
+                Arena->PurgedSize += PurgeSize;
+                Result += PurgeSize;
+                Block = Block->Prev;
+            }
         }
-#endif
-        
-        // NOTE: Unlink from list of platform free blocks
-        if (PlatformHeader->FreeNext)
+
+        if (Result >= MaxPurgeSize)
         {
-            PlatformHeader->FreeNext->FreePrev = PlatformHeader->FreePrev;
+            // NOTE: Out of budget, the next call starts on this platform block since it might still have dirty blocks
+            break;
         }
-        if (!PlatformHeader->Prev)
+
+        // NOTE: Wrap around once so platform blocks in front of the cursor get their turn too
+        PlatformHeader = PlatformHeader->Next ? PlatformHeader->Next : Arena->Next;
+        if (PlatformHeader == StartHeader)
         {
-            Arena->FreeList = PlatformHeader->FreeNext;
+            break;
         }
-        
-        MemoryFree(PlatformHeader);
     }
-    else
+    Arena->PurgeCursor = PlatformHeader;
+
+    return Result;
+}
+
+inline platform_block_arena_stats PlatformBlockArenaGetStats(platform_block_arena* Arena)
+{
+    // NOTE: Concurrent arenas walk their platform blocks under the lock, the numbers are a snapshot while other threads keep going
+    platform_block_arena_stats Result = {};
+    b32 Concurrent = Arena->ArenaFlags & PlatformBlockArenaFlag_Concurrent;
+    
+    if (Concurrent)
+    {
+        SpinLockAcquire(&Arena->Lock);
+    }
+    for (platform_block_header* PlatformHeader = Arena->Next; PlatformHeader; PlatformHeader = PlatformHeader->Next)
     {
-        // NOTE: We still have blocks in use so add to free list
-        // TODO: Make this a macro
-        Block->Next = PlatformHeader->FreeBlocks;
-        if (Block->Next)
+        Result.MappedSize += Arena->PlatformBlockSize;
+        Result.ResidentSize += PlatformBlockArenaGetHeaderSize() + PlatformHeader->NumCarvedBlocks*Arena->BlockSize;
+        Result.DirtySize += PlatformHeader->NumDirtyBlocks*Arena->BlockSize;
+    }
+    if (Concurrent)
+    {
+        SpinLockRelease(&Arena->Lock);
+
+        mm NumStackBlocks = 0;
+        for (u32 NodeId = 0; NodeId < Arena->NumNodes; ++NodeId)
         {
-            Block->Next->Prev = Block;
+            NumStackBlocks += mm(AtomicLoadU64(&Arena->Nodes[NodeId].NumStackBlocks));
         }
-        Block->Prev = 0;
+        mm NumPurgedBlocks = mm(AtomicLoadU64(&Arena->NumPurgedBlocks));
+        Result.DirtySize = NumStackBlocks > NumPurgedBlocks ? (NumStackBlocks - NumPurgedBlocks)*Arena->BlockSize : 0;
     }
+
+    Result.PurgedSize = mm(AtomicLoadU64(&Arena->PurgedSize));
+    Result.ResidentSize -= Min(Result.PurgedSize, Result.ResidentSize);
+    
+    return Result;
 }
 
 inline void ArenaClear(platform_block_arena* Arena)
 {
+    // IMPORTANT: For concurrent arenas, no other thread can be using the arena while we clear it
+    
+    // NOTE: Magazines other threads still hold for us go stale here. Leave the live list before we free anything so a thread evicting
+    // one of them can't flush into us while we clear
+    SpinLockAcquire(&PlatformBlockLiveLock);
+    PlatformBlockArenaRemoveLive(Arena);
+    Arena->Generation = AtomicAddU32(&PlatformBlockArenaGenerationCounter, 1) + 1;
+    SpinLockRelease(&PlatformBlockLiveLock);
+    
     for (platform_block_header* Header = Arena->Next;
          Header;
          )
@@ -173,10 +997,92 @@ inline void ArenaClear(platform_block_arena* Arena)
 
         // NOTE: Remove from linked list
         DoubleListRemove(Arena, CurrHeader, Next, Prev);        
-        MemoryFree(CurrHeader);
+        MemoryFree(CurrHeader, Arena->PlatformBlockSize, Arena->Flags);
+    }
+
+    for (u32 NodeId = 0; NodeId < Arena->NumNodes; ++NodeId)
+    {
+        Arena->Nodes[NodeId] = {};
+    }
+    Arena->PurgeCursor = 0;
+    Arena->NumPurgedBlocks = 0;
+    Arena->PurgedSize = 0;
+}
+
+//
+// NOTE: Block Handles
+//
+
+/*
+
+  NOTE: Long lived block arenas that grow and shrink leave platform blocks with only a few live blocks in them, which keeps the whole
+  platform block mapped. A block arena created with a block_handle_table gets a slot per block, and pushes on it can return a
+  block_handle (slot + offset into the block) instead of a pointer. Since everything goes through the slot, BlockHandleTableCompact
+  can copy live blocks out of sparse platform blocks into dense ones, patch the slot and the arenas block list, and let the emptied
+  platform blocks go back to the OS.
+
+  Raw pointers into a block are only valid until the next compaction, resolve handles again after it. The block arenas have to stay
+  at the same address once they pushed something since the slots point back to them. Only non concurrent platform block arenas can
+  be compacted.
+  
+ */
+
+inline block_handle_table BlockHandleTableCreate(platform_block_arena* PlatformArena, u32 MaxSlots)
+{
+    Assert(!(PlatformArena->ArenaFlags & PlatformBlockArenaFlag_Concurrent));
+    
+    // NOTE: Slot pages only get touched as the table fills up
+    block_handle_table Result = {};
+    Result.PlatformArena = PlatformArena;
+    Result.MaxSlots = MaxSlots + 1;
+    Result.NumSlots = 1;
+    Result.Slots = (block_handle_slot*)MemoryAllocate(sizeof(block_handle_slot)*Result.MaxSlots);
+    Assert(Result.Slots);
+
+    return Result;
+}
+
+inline void BlockHandleTableRelease(block_handle_table* Table)
+{
+    MemoryFree(Table->Slots, sizeof(block_handle_slot)*Table->MaxSlots);
+    *Table = {};
+}
+
+inline u32 BlockHandleTableAdd(block_handle_table* Table, block* Block, block_arena* Arena)
+{
+    u32 Result = Table->FirstFree;
+    if (Result)
+    {
+        Table->FirstFree = Table->Slots[Result].NextFree;
+    }
+    else
+    {
+        Assert(Table->NumSlots < Table->MaxSlots);
+        Result = Table->NumSlots++;
     }
 
-    Arena->FreeList = 0;
+    block_handle_slot* Slot = Table->Slots + Result;
+    Slot->Block = Block;
+    Slot->Arena = Arena;
+    Slot->NextFree = 0;
+    
+    return Result;
+}
+
+inline void BlockHandleTableRemove(block_handle_table* Table, u32 HandleId)
+{
+    block_handle_slot* Slot = Table->Slots + HandleId;
+    Slot->Block = 0;
+    Slot->Arena = 0;
+    Slot->NextFree = Table->FirstFree;
+    Table->FirstFree = HandleId;
+}
+
+inline void* BlockHandleGet(block_handle_table* Table, block_handle Handle)
+{
+    Assert(Handle.HandleId && Handle.HandleId < Table->NumSlots && Table->Slots[Handle.HandleId].Block);
+    void* Result = (u8*)Table->Slots[Handle.HandleId].Block + Handle.Offset;
+    return Result;
 }
 
 //
@@ -207,6 +1113,15 @@ inline block_arena BlockArenaCreate(platform_block_arena* PlatformArena, mm Elem
     return Result;
 }
 
+inline block_arena BlockArenaCreate(platform_block_arena* PlatformArena, block_handle_table* Handles)
+{
+    Assert(Handles->PlatformArena == PlatformArena);
+    block_arena Result = BlockArenaCreate(PlatformArena);
+    Result.Handles = Handles;
+
+    return Result;
+}
+
 inline void* PushSizeAligned(block_arena* Arena, mm Size, mm Alignment = 4)
 {
     Assert(Size <= BlockArenaGetBlockSize(Arena));
@@ -218,34 +1133,188 @@ inline void* PushSizeAligned(block_arena* Arena, mm Size, mm Alignment = 4)
         block* NewBlock = PlatformBlockArenaAllocate(Arena->PlatformArena);
         DoubleListAppend(Arena, NewBlock, Next, Prev);
         Arena->LastBlockUsed = sizeof(block);
+        if (Arena->Handles)
+        {
+            NewBlock->HandleId = BlockHandleTableAdd(Arena->Handles, NewBlock, Arena);
+        }
+        
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordCommit(Arena, DebugArenaType_Block, i64(Arena->PlatformArena->BlockSize));
+#endif
     }
 
+#if DEBUG_MEMORY_PROFILING
+    mm OldUsed = Arena->LastBlockUsed;
+#endif
+    
     void* Result = (void*)AlignAddress((u8*)Arena->Prev + Arena->LastBlockUsed, Alignment);
     Arena->LastBlockUsed = mm(Result) - mm(Arena->Prev) + Size;
+
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordAllocation(Arena, DebugArenaType_Block, Size, Alignment, i64(Arena->LastBlockUsed - OldUsed), DEBUG_MEMORY_CALL_SITE);
+#endif
     
     return Result;
 }
 
-inline void* FreeSize()
-{
-    // TODO: Implement for ECS (not needed for UI)
-}
-
 inline void ArenaClear(block_arena* Arena)
 {
-    // NOTE: Free all allocated blocks (unless platform arena already cleared)
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordClear(Arena, DebugArenaType_Block, DEBUG_MEMORY_CALL_SITE);
+#endif
+    
+    // NOTE: Free all allocated blocks in one go (unless platform arena already cleared)
     if (Arena->PlatformArena->Next)
     {
-        for (block* CurrBlock = Arena->Next; CurrBlock; CurrBlock = Arena->Next)
+        if (Arena->Handles)
         {
-            DoubleListRemove(Arena, CurrBlock, Next, Prev);
-            PlatformBlockArenaFree(Arena->PlatformArena, CurrBlock);
+            for (block* CurrBlock = Arena->Next; CurrBlock; CurrBlock = CurrBlock->Next)
+            {
+                BlockHandleTableRemove(Arena->Handles, CurrBlock->HandleId);
+            }
         }
+        
+#if DEBUG_MEMORY_PROFILING
+        mm NumFreed = PlatformBlockArenaFreeChain(Arena->PlatformArena, Arena->Next);
+        DebugRecordCommit(Arena, DebugArenaType_Block, -i64(NumFreed*Arena->PlatformArena->BlockSize));
+#else
+        PlatformBlockArenaFreeChain(Arena->PlatformArena, Arena->Next);
+#endif
     }
     
     Arena->Next = 0;
     Arena->Prev = 0;
     Arena->LastBlockUsed = 0;
+
+#if DEBUG_MEMORY_PROFILING
+    // NOTE: Block arenas have no release, clearing gives every block back so it ends the arenas stats
+    DebugRecordRelease(Arena);
+#endif
+}
+
+inline block_handle PushSizeHandle(block_arena* Arena, mm Size, mm Alignment = 4)
+{
+    Assert(Arena->Handles);
+    u8* Mem = (u8*)PushSizeAligned(Arena, Size, Alignment);
+    
+    block_handle Result = {};
+    Result.HandleId = Arena->Prev->HandleId;
+    Result.Offset = u32(Mem - (u8*)Arena->Prev);
+
+    return Result;
+}
+
+//
+// NOTE: Block Compaction
+//
+
+inline platform_block_header* PlatformBlockArenaFindDenseHeader(platform_block_arena* Arena, platform_block_header* Source)
+{
+    // NOTE: Fullest platform block on the same node that still has space and holds at least as many live blocks as Source, so
+    // blocks only ever flow towards fuller platform blocks and two sparse ones can't keep trading blocks
+    platform_block_header* Result = 0;
+    mm NumBlocks = PlatformBlockArenaNumBlocks(Arena);
+    mm MinLive = NumBlocks - Source->NumFreeBlocks;
+    mm MaxFree = NumBlocks;
+    for (platform_block_header* PlatformHeader = Arena->Nodes[Source->Node].FreeList;
+         PlatformHeader;
+         PlatformHeader = PlatformHeader->FreeNext)
+    {
+        if (PlatformHeader != Source && NumBlocks - PlatformHeader->NumFreeBlocks >= MinLive && PlatformHeader->NumFreeBlocks < MaxFree)
+        {
+            Result = PlatformHeader;
+            MaxFree = PlatformHeader->NumFreeBlocks;
+        }
+    }
+
+    return Result;
+}
+
+inline void BlockHandleMove(block_handle_table* Table, block_handle_slot* Slot, platform_block_header* Dest)
+{
+    platform_block_arena* PlatformArena = Table->PlatformArena;
+    block_arena* Arena = Slot->Arena;
+    block* OldBlock = Slot->Block;
+
+    platform_block_node* ArenaNode = PlatformArena->Nodes + Dest->Node;
+    Dest->NumFreeBlocks -= 1;
+    if (Dest->NumFreeBlocks == 0)
+    {
+        PlatformBlockNodeRemoveFree(ArenaNode, Dest);
+    }
+    block* NewBlock = PlatformBlockHeaderTakeBlock(PlatformArena, Dest);
+
+    // NOTE: Only the last block of the arena is partially used
+    mm UsedSize = (OldBlock == Arena->Prev ? Arena->LastBlockUsed : sizeof(block) + Arena->BlockSpace) - sizeof(block);
+    Copy(OldBlock + 1, NewBlock + 1, UsedSize);
+    NewBlock->HandleId = OldBlock->HandleId;
+
+    // NOTE: Take the old blocks place in the arenas list
+    NewBlock->Next = OldBlock->Next;
+    NewBlock->Prev = OldBlock->Prev;
+    if (OldBlock->Prev)
+    {
+        OldBlock->Prev->Next = NewBlock;
+    }
+    else
+    {
+        Arena->Next = NewBlock;
+    }
+    if (OldBlock->Next)
+    {
+        OldBlock->Next->Prev = NewBlock;
+    }
+    else
+    {
+        Arena->Prev = NewBlock;
+    }
+    Slot->Block = NewBlock;
+
+    // NOTE: Releases the source platform block once its last live block moved out
+    PlatformBlockArenaFree(PlatformArena, OldBlock);
+}
+
+inline mm BlockHandleTableCompact(block_handle_table* Table, u64 BudgetNs, f32 SparseRatio = 0.25f)
+{
+    /*
+      NOTE: Moves blocks out of platform blocks that have at most SparseRatio of their blocks live, returns how many blocks moved.
+      Each call resumes from where the last one ran out of time, so calling it with a small budget every frame slowly walks the
+      whole table. The time is checked after every move (a block copy) and every 64 slots we skip.
+     */
+    mm Result = 0;
+    platform_block_arena* PlatformArena = Table->PlatformArena;
+    mm NumBlocks = PlatformBlockArenaNumBlocks(PlatformArena);
+    mm SparseLimit = mm(f32(NumBlocks)*SparseRatio);
+    u64 EndNs = MemoryGetTimeNs() + BudgetNs;
+
+    for (u32 NumVisited = 1; NumVisited < Table->NumSlots; ++NumVisited)
+    {
+        Table->CompactCursor = Table->CompactCursor + 1 < Table->NumSlots ? Table->CompactCursor + 1 : 1;
+        block_handle_slot* Slot = Table->Slots + Table->CompactCursor;
+
+        b32 Moved = false;
+        if (Slot->Block)
+        {
+            platform_block_header* Source = Slot->Block->ParentBlock;
+            if (NumBlocks - Source->NumFreeBlocks <= SparseLimit)
+            {
+                platform_block_header* Dest = PlatformBlockArenaFindDenseHeader(PlatformArena, Source);
+                if (Dest)
+                {
+                    BlockHandleMove(Table, Slot, Dest);
+                    Result += 1;
+                    Moved = true;
+                }
+            }
+        }
+
+        if ((Moved || (NumVisited % 64) == 0) && MemoryGetTimeNs() >= EndNs)
+        {
+            break;
+        }
+    }
+
+    return Result;
 }
 
 #define BlockGetData(block, type) (type*)BlockGetData_(block)
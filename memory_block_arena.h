@@ -18,6 +18,11 @@
 // NOTE: Platform Block Arena
 //
 
+// NOTE: Blocks start cache line aligned after the header and their size is rounded down to keep them that way
+#define PLATFORM_BLOCK_ALIGNMENT 64
+// NOTE: Machines with more NUMA nodes share the per node lists (node % PLATFORM_BLOCK_MAX_NODES)
+#define PLATFORM_BLOCK_MAX_NODES 8
+
 struct block;
 struct platform_block_header
 {
@@ -30,7 +35,47 @@ struct platform_block_header
     platform_block_header* FreePrev;
 
     mm NumFreeBlocks;
-    block* FreeBlocks;
+    block* FreeBlocks; // NOTE: Only blocks that got freed, blocks past NumCarvedBlocks were never handed out
+    mm NumCarvedBlocks;
+    u32 Node; // NOTE: Index of the node list we belong to (the bound NUMA node folded by NumNodes), always 0 outside of NUMA mode
+
+    // NOTE: Decay purging, FreeBlocks holds the NumDirtyBlocks still resident blocks first and the purged ones after them
+    mm NumDirtyBlocks;
+    mm PurgedSize;
+    u64 LastFreeTimeNs;
+};
+
+enum platform_block_arena_flags
+{
+    PlatformBlockArenaFlag_None = 0,
+    // NOTE: Lets many threads allocate/free blocks from the same arena (see PlatformBlockArenaAllocate)
+    PlatformBlockArenaFlag_Concurrent = 1 << 0,
+    // NOTE: Maps platform blocks aligned to PlatformBlockSize so any pointer can be mapped back to its block (see PlatformBlockArenaGetBlock)
+    PlatformBlockArenaFlag_Aligned = 1 << 1,
+    // NOTE: Binds each platform block to a NUMA node and keeps free blocks per node, allocations prefer the node of the calling thread
+    PlatformBlockArenaFlag_Numa = 1 << 2,
+};
+
+struct platform_block_node
+{
+    platform_block_header* FreeList;
+
+    // NOTE: Concurrent mode, free blocks live on a tagged stack (pointer in the low 48 bits, ABA tag in the high 16 bits)
+    volatile u64 FreeStack;
+    platform_block_header* CarveHeader; // NOTE: Last mapped platform block, we carve from it under Lock
+    volatile u64 NumStackBlocks;
+    volatile u64 LastFreeTimeNs; // NOTE: Only kept when decay purging is on
+
+    // NOTE: Keeps threads on different nodes from sharing a cache line
+    u8 Padding[PLATFORM_BLOCK_ALIGNMENT - 5*sizeof(u64)];
+};
+
+struct platform_block_arena_stats
+{
+    mm MappedSize; // NOTE: Address space of all platform blocks
+    mm ResidentSize; // NOTE: Headers plus every block we ever handed out minus what got purged, an upper bound on RSS
+    mm DirtySize; // NOTE: Free blocks that are still resident, concurrent arenas only count blocks on the global stacks
+    mm PurgedSize; // NOTE: Free blocks that we gave back to the OS
 };
 
 struct platform_block_arena
@@ -38,10 +83,45 @@ struct platform_block_arena
     platform_block_header* Next;
     platform_block_header* Prev;
 
-    platform_block_header* FreeList;
-    
     mm PlatformBlockSize;
     mm BlockSize;
+    u32 Flags; // NOTE: memory_flags passed to the OS for each platform block
+    u32 ArenaFlags;
+
+    // NOTE: One entry per NUMA node, only Nodes[0] is used outside of NUMA mode
+    u32 NumNodes;
+    platform_block_node Nodes[PLATFORM_BLOCK_MAX_NODES];
+    
+    volatile u32 Lock;
+    u32 Generation;
+
+    // NOTE: Concurrent mode, links on the list of arenas that threads hold magazines for (see PlatformBlockArenaMakeLive)
+    volatile u32 IsLive;
+    platform_block_arena* NextLive;
+    platform_block_arena* PrevLive;
+
+    // NOTE: Decay purging (see PlatformBlockArenaPurge), off when PurgeDecayNs is 0
+    u64 PurgeDecayNs;
+    b32 PurgeLazy;
+    platform_block_header* PurgeCursor;
+    volatile u64 NumPurgedBlocks; // NOTE: Concurrent mode, purged blocks sitting on the global stacks
+    volatile u64 PurgedSize;
+};
+
+//
+// NOTE: Per thread block cache for concurrent platform block arenas
+//
+
+#define PLATFORM_BLOCK_MAGAZINE_SIZE 32
+#define PLATFORM_BLOCK_MAX_MAGAZINES 4
+
+struct platform_block_magazine
+{
+    platform_block_arena* Arena;
+    u32 Generation;
+    u32 Node; // NOTE: All cached blocks come from this node
+    u32 NumBlocks;
+    block* Blocks[PLATFORM_BLOCK_MAGAZINE_SIZE];
 };
 
 //
@@ -53,8 +133,10 @@ struct block
     platform_block_header* ParentBlock;
     block* Next;
     block* Prev;
+    u32 HandleId; // NOTE: Slot of the block in its arenas block_handle_table, 0 if the arena doesn't use handles
 };
 
+struct block_handle_table;
 struct block_arena
 {
     // NOTE: Next/Prev blocks we allocated
@@ -64,45 +146,33 @@ struct block_arena
     mm LastBlockUsed;
     mm BlockSpace; // NOTE: Use this incase we want padding at the end of our block
     platform_block_arena* PlatformArena;
+    block_handle_table* Handles; // NOTE: Optional, lets compaction move our blocks (see BlockHandleTableCompact)
 };
 
 //
-// =======================================================================================================================================
+// NOTE: Block Handles
 //
 
-#if 0
-
-struct block_header
+struct block_handle
 {
-    block_header* Next;
+    u32 HandleId;
+    u32 Offset; // NOTE: From the start of the block
 };
 
-struct block_platform_arena
+struct block_handle_slot
 {
-    mm BlockSize;
-    mm NumBlocks;
-    
-    u8* Mem;
-    block_header* FreeBlockHeaders;
-};
-
-// NOTE: This is a helper to block arena to have a arena where we have a linked list of arrays
-// TODO: Figure out how to make this type safe?
-struct block_list_block
-{
-    u32 NumEntries;
-    void* Data;
-    block_list_block* Next;
-    block_list_block* Prev;
+    block* Block; // NOTE: 0 for free slots
+    block_arena* Arena;
+    u32 NextFree;
 };
 
-struct block_sentinel : public block
+struct block_handle_table
 {
-    union
-    {
-        mm NumBytesInLastBlock;
-        uint NumElementsInLastBlock;
-    };
+    platform_block_arena* PlatformArena;
+    
+    block_handle_slot* Slots; // NOTE: Slot 0 is never used so a 0 HandleId means no handle
+    u32 MaxSlots;
+    u32 NumSlots;
+    u32 FirstFree;
+    u32 CompactCursor;
 };
-
-#endif
@@ -0,0 +1,167 @@
+//
+// NOTE: Block Array
+//
+
+template<typename T>
+inline block_array<T> BlockArrayCreate(platform_block_arena* PlatformArena)
+{
+    block_array<T> Result = {};
+    Result.Arena = BlockArenaCreate(PlatformArena);
+
+    mm Alignment = alignof(T) > BLOCK_ARRAY_DATA_ALIGNMENT ? alignof(T) : BLOCK_ARRAY_DATA_ALIGNMENT;
+    Result.DataOffset = AlignAddress(u64(sizeof(block) + sizeof(block_array_block)), u64(Alignment));
+    Assert(PlatformArena->BlockSize >= Result.DataOffset + sizeof(T));
+    Result.ElementsPerBlock = (PlatformArena->BlockSize - Result.DataOffset) / sizeof(T);
+
+    return Result;
+}
+
+inline block_array_block* BlockArrayGetHeader(block* Block)
+{
+    block_array_block* Result = (block_array_block*)(Block + 1);
+    return Result;
+}
+
+template<typename T>
+inline T* BlockArrayGetElements(block_array<T>* Array, block* Block)
+{
+    T* Result = (T*)((u8*)Block + Array->DataOffset);
+    return Result;
+}
+
+template<typename T>
+inline void BlockArrayGrowDirectory(block_array<T>* Array)
+{
+    mm NewMaxBlocks = Max(2*Array->MaxBlocks, MemoryGetPageSize() / sizeof(block*));
+    block** NewBlocks = (block**)MemoryAllocate(NewMaxBlocks*sizeof(block*));
+    Assert(NewBlocks);
+    
+    if (Array->Blocks)
+    {
+        Copy(Array->Blocks, NewBlocks, Array->NumBlocks*sizeof(block*));
+        MemoryFree(Array->Blocks, Array->MaxBlocks*sizeof(block*));
+    }
+    Array->Blocks = NewBlocks;
+    Array->MaxBlocks = NewMaxBlocks;
+}
+
+template<typename T>
+inline T* BlockArrayPush(block_array<T>* Array)
+{
+    block* Block = Array->Arena.Prev;
+    if (!Block || BlockArrayGetHeader(Block)->NumElements == Array->ElementsPerBlock)
+    {
+        // NOTE: Last block is full, we take whole blocks so we skip PushSize and link the block ourselves
+        if (Array->NumBlocks == Array->MaxBlocks)
+        {
+            BlockArrayGrowDirectory(Array);
+        }
+        
+        Block = PlatformBlockArenaAllocate(Array->Arena.PlatformArena);
+        DoubleListAppend(&Array->Arena, Block, Next, Prev);
+        BlockArrayGetHeader(Block)->NumElements = 0;
+        Array->Blocks[Array->NumBlocks++] = Block;
+        
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordCommit(&Array->Arena, DebugArenaType_Block, i64(Array->Arena.PlatformArena->BlockSize));
+#endif
+    }
+
+    block_array_block* Header = BlockArrayGetHeader(Block);
+    T* Result = BlockArrayGetElements(Array, Block) + Header->NumElements;
+    Header->NumElements += 1;
+    Array->NumElements += 1;
+
+    return Result;
+}
+
+template<typename T>
+inline T* BlockArrayPush(block_array<T>* Array, const T& Value)
+{
+    T* Result = BlockArrayPush(Array);
+    *Result = Value;
+    return Result;
+}
+
+template<typename T>
+inline T BlockArrayPop(block_array<T>* Array)
+{
+    Assert(Array->NumElements > 0);
+
+    block* Block = Array->Arena.Prev;
+    block_array_block* Header = BlockArrayGetHeader(Block);
+    Header->NumElements -= 1;
+    Array->NumElements -= 1;
+    T Result = BlockArrayGetElements(Array, Block)[Header->NumElements];
+
+    if (Header->NumElements == 0)
+    {
+        // NOTE: Give empty blocks back right away so every block but the last stays full
+        DoubleListRemove(&Array->Arena, Block, Next, Prev);
+        PlatformBlockArenaFree(Array->Arena.PlatformArena, Block);
+        Array->NumBlocks -= 1;
+        
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordCommit(&Array->Arena, DebugArenaType_Block, -i64(Array->Arena.PlatformArena->BlockSize));
+#endif
+    }
+
+    return Result;
+}
+
+template<typename T>
+inline T* BlockArrayGet(block_array<T>* Array, mm Index)
+{
+    Assert(Index < Array->NumElements);
+
+    mm BlockId = Index / Array->ElementsPerBlock;
+    T* Result = BlockArrayGetElements(Array, Array->Blocks[BlockId]) + (Index - BlockId*Array->ElementsPerBlock);
+    return Result;
+}
+
+template<typename T, typename func>
+inline void BlockArrayForEachBlock(block_array<T>* Array, func&& Func)
+{
+    // NOTE: Func(T* Elements, mm NumElements) gets called once per block in order
+    for (block* Block = Array->Arena.Next; Block; Block = Block->Next)
+    {
+        if (Block->Next)
+        {
+            // NOTE: Start pulling in the next blocks header and first elements while we process this one
+            u8* NextElements = (u8*)BlockArrayGetElements(Array, Block->Next);
+            MemoryPrefetch(Block->Next);
+            MemoryPrefetch(NextElements);
+            MemoryPrefetch(NextElements + 64);
+        }
+
+        Func(BlockArrayGetElements(Array, Block), BlockArrayGetHeader(Block)->NumElements);
+    }
+}
+
+template<typename T, typename func>
+inline void BlockArrayForEach(block_array<T>* Array, func&& Func)
+{
+    // NOTE: Func(T& Element) for every element in order
+    BlockArrayForEachBlock(Array, [&](T* Elements, mm NumElements)
+    {
+        for (mm ElementId = 0; ElementId < NumElements; ++ElementId)
+        {
+            Func(Elements[ElementId]);
+        }
+    });
+}
+
+template<typename T>
+inline void ArenaClear(block_array<T>* Array)
+{
+    ArenaClear(&Array->Arena);
+    Array->NumElements = 0;
+
+    if (Array->Blocks)
+    {
+        MemoryFree(Array->Blocks, Array->MaxBlocks*sizeof(block*));
+    }
+    Array->Blocks = 0;
+    Array->NumBlocks = 0;
+    Array->MaxBlocks = 0;
+}
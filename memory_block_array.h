@@ -0,0 +1,42 @@
+#pragma once
+
+//
+// NOTE: Block Array
+//
+
+/*
+
+  NOTE: A typed array made out of the blocks of a block arena. Every block holds a small header with its element count followed by
+  a cache line aligned run of elements, so elements never move once pushed (pointers stay valid until they get popped or the array
+  gets cleared) and a scan over a block is a plain loop over contiguous memory that the compiler can vectorize.
+
+  Pushes and pops only happen at the end, so every block except the last one is full and element Index sits in block
+  Index / ElementsPerBlock. Each array keeps a directory of its block pointers in order so indexing is O(1), the directory comes straight
+  from the OS and doubles when it fills up, one page of it covers 512 blocks. Use BlockArrayForEachBlock for scans, it prefetches the
+  start of the next block while the current one gets processed.
+
+  Each array owns its own block_arena so it gets whole blocks to itself, but many arrays can share one platform block arena.
+
+ */
+
+#define BLOCK_ARRAY_DATA_ALIGNMENT 64
+
+struct block_array_block
+{
+    // NOTE: Stored right after the block header of each block
+    mm NumElements;
+};
+
+template<typename T>
+struct block_array
+{
+    block_arena Arena;
+    mm NumElements;
+    mm ElementsPerBlock;
+    mm DataOffset; // NOTE: Offset of the first element from the start of its block
+
+    // NOTE: Our blocks in order, same as the arenas list
+    block** Blocks;
+    mm NumBlocks;
+    mm MaxBlocks;
+};
@@ -0,0 +1,346 @@
+//
+// NOTE: Debug Memory Profiling
+//
+
+#include <stdio.h>
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(_MSC_VER)
+#include <x86intrin.h>
+#endif
+
+static debug_memory_state DebugMemoryState;
+
+struct debug_memory_thread
+{
+    debug_memory_ring* Ring;
+
+    ~debug_memory_thread()
+    {
+        // NOTE: Hand the ring back on thread exit, its events stay exportable until another thread reuses it
+        if (Ring)
+        {
+            AtomicStoreU32(&Ring->IsFree, 1);
+        }
+    }
+};
+
+static thread_local debug_memory_thread DebugMemoryThread;
+static thread_local debug_arena_stats* DebugMemoryLastStats;
+
+// NOTE: Key of slots whose arena got released, probes walk past them and the next new arena on the probe path takes them over
+#define DEBUG_MEMORY_RELEASED_SLOT 1
+
+inline u64 DebugMemoryGetTicks()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    u64 Result = __rdtsc();
+#elif defined(__aarch64__)
+    u64 Result;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(Result));
+#else
+    u64 Result = MemoryGetTimeNs();
+#endif
+    return Result;
+}
+
+inline debug_arena_stats* DebugMemoryGetStats(void* Arena, u32 ArenaType)
+{
+    // NOTE: Linear probe on the arena pointer, slots get claimed with a CAS and released by DebugRecordRelease
+    u64 Key = u64(Arena);
+    debug_arena_stats* Result = DebugMemoryLastStats;
+    if (Result && Result->Arena == Key)
+    {
+        return Result;
+    }
+    Result = 0;
+    
+    u64 Hash = (Key >> 4) * 0x9E3779B97F4A7C15ull;
+    debug_arena_stats* ReleasedSlot = 0;
+    for (u32 ProbeId = 0; ProbeId < DEBUG_MEMORY_MAX_ARENAS; ++ProbeId)
+    {
+        debug_arena_stats* Stats = DebugMemoryState.Arenas + ((Hash >> 40) + ProbeId) % DEBUG_MEMORY_MAX_ARENAS;
+        u64 SlotKey = AtomicLoadU64(&Stats->Arena);
+        if (SlotKey == Key)
+        {
+            Result = Stats;
+            break;
+        }
+        if (SlotKey == DEBUG_MEMORY_RELEASED_SLOT && !ReleasedSlot)
+        {
+            ReleasedSlot = Stats;
+        }
+        if (SlotKey == 0)
+        {
+            // NOTE: We aren't in the table, take the first released slot we walked past or else this empty one
+            debug_arena_stats* NewSlot = ReleasedSlot ? ReleasedSlot : Stats;
+            u64 OldKey = ReleasedSlot ? DEBUG_MEMORY_RELEASED_SLOT : 0;
+            SlotKey = AtomicCompareExchangeU64(&NewSlot->Arena, OldKey, Key);
+            if (SlotKey == OldKey)
+            {
+                NewSlot->ArenaType = ArenaType;
+            }
+            if (SlotKey == OldKey || SlotKey == Key)
+            {
+                Result = NewSlot;
+                break;
+            }
+            if (ReleasedSlot)
+            {
+                // NOTE: Another arena took the released slot, look at this empty one again
+                ReleasedSlot = 0;
+                ProbeId -= 1;
+            }
+        }
+    }
+
+    DebugMemoryLastStats = Result;
+    return Result;
+}
+
+inline void DebugMemoryAtomicMax(volatile u64* Dest, u64 Value)
+{
+    u64 OldValue = AtomicLoadU64(Dest);
+    while (OldValue < Value)
+    {
+        u64 PrevValue = AtomicCompareExchangeU64(Dest, OldValue, Value);
+        if (PrevValue == OldValue)
+        {
+            break;
+        }
+        OldValue = PrevValue;
+    }
+}
+
+inline debug_memory_ring* DebugMemoryGetRing()
+{
+    if (!DebugMemoryThread.Ring)
+    {
+        // NOTE: Reuse a ring from a thread that exited before mapping a new one
+        debug_memory_ring* Ring = 0;
+        for (debug_memory_ring* FreeRing = (debug_memory_ring*)AtomicLoadU64(&DebugMemoryState.Rings); FreeRing; FreeRing = FreeRing->Next)
+        {
+            if (AtomicLoadU32(&FreeRing->IsFree) && AtomicCompareExchangeU32(&FreeRing->IsFree, 1, 0) == 1)
+            {
+                Ring = FreeRing;
+                Ring->ThreadId = AtomicAddU32(&DebugMemoryState.NextThreadId, 1);
+                AtomicStoreU64(&Ring->WriteIndex, 0);
+                break;
+            }
+        }
+
+        if (!Ring)
+        {
+            Ring = (debug_memory_ring*)MemoryAllocate(sizeof(debug_memory_ring), MemoryFlag_Untracked);
+            if (!Ring)
+            {
+                // NOTE: Out of memory, events get dropped and we try again on the next one. The per arena counters still work
+                return 0;
+            }
+            
+            Ring->ThreadId = AtomicAddU32(&DebugMemoryState.NextThreadId, 1);
+            if (Ring->ThreadId == 0)
+            {
+                // NOTE: Benign race, the first few events might use a slightly later start time
+                DebugMemoryState.StartTicks = DebugMemoryGetTicks();
+                DebugMemoryState.StartTimeNs = MemoryGetTimeNs();
+            }
+
+            u64 OldHead = AtomicLoadU64(&DebugMemoryState.Rings);
+            for (;;)
+            {
+                Ring->Next = (debug_memory_ring*)OldHead;
+                u64 PrevHead = AtomicCompareExchangeU64(&DebugMemoryState.Rings, OldHead, u64(Ring));
+                if (PrevHead == OldHead)
+                {
+                    break;
+                }
+                OldHead = PrevHead;
+            }
+        }
+
+        DebugMemoryThread.Ring = Ring;
+    }
+
+    return DebugMemoryThread.Ring;
+}
+
+inline void DebugMemoryRecord(u32 Type, void* Arena, u32 ArenaType, mm Size, mm Alignment, i64 UsedDelta, i64 CommittedDelta,
+                              void* CallSite)
+{
+    debug_arena_stats* Stats = DebugMemoryGetStats(Arena, ArenaType);
+    u64 Used = 0;
+    u64 Committed = 0;
+    if (Stats)
+    {
+        // NOTE: Concurrent arenas record from several threads at once, so every counter update is atomic
+        if (Type == DebugMemoryEvent_Alloc)
+        {
+            AtomicAddU64(&Stats->NumAllocs, 1);
+            AtomicAddU64(&Stats->NumBytes, Size);
+        }
+
+        if (Type == DebugMemoryEvent_Clear)
+        {
+            AtomicStoreU64(&Stats->Used, 0);
+        }
+        else
+        {
+            Used = UsedDelta ? AtomicAddU64(&Stats->Used, u64(UsedDelta)) + u64(UsedDelta) : AtomicLoadU64(&Stats->Used);
+            DebugMemoryAtomicMax(&Stats->HighWater, Used);
+        }
+
+        Committed = CommittedDelta ? AtomicAddU64(&Stats->Committed, u64(CommittedDelta)) + u64(CommittedDelta) : AtomicLoadU64(&Stats->Committed);
+        DebugMemoryAtomicMax(&Stats->CommittedHighWater, Committed);
+    }
+    
+    debug_memory_ring* Ring = DebugMemoryGetRing();
+    if (!Ring)
+    {
+        return;
+    }
+    
+    u64 WriteIndex = Ring->WriteIndex;
+    debug_memory_event* Event = Ring->Events + (WriteIndex % DEBUG_MEMORY_RING_SIZE);
+    Event->Ticks = DebugMemoryGetTicks();
+    Event->Arena = Arena;
+    Event->CallSite = CallSite;
+    Event->Size = Size;
+    Event->Used = Used;
+    Event->Committed = Committed;
+    Event->Alignment = u32(Alignment);
+    Event->Type = u16(Type);
+    Event->ArenaType = u16(ArenaType);
+    AtomicStoreU64(&Ring->WriteIndex, WriteIndex + 1);
+}
+
+//
+// NOTE: Hooks called by the arenas
+//
+
+inline void DebugRecordAllocation(void* Arena, u32 ArenaType, mm Size, mm Alignment, i64 UsedDelta, void* CallSite)
+{
+    DebugMemoryRecord(DebugMemoryEvent_Alloc, Arena, ArenaType, Size, Alignment, UsedDelta, 0, CallSite);
+}
+
+inline void DebugRecordFree(void* Arena, u32 ArenaType, mm Size, void* CallSite)
+{
+    DebugMemoryRecord(DebugMemoryEvent_Free, Arena, ArenaType, Size, 0, -i64(Size), 0, CallSite);
+}
+
+inline void DebugRecordClear(void* Arena, u32 ArenaType, void* CallSite)
+{
+    // NOTE: Arena used drops to 0, committed memory is reported separately through DebugRecordCommit
+    DebugMemoryRecord(DebugMemoryEvent_Clear, Arena, ArenaType, 0, 0, 0, 0, CallSite);
+}
+
+inline void DebugRecordCommit(void* Arena, u32 ArenaType, i64 CommittedDelta)
+{
+    DebugMemoryRecord(DebugMemoryEvent_Commit, Arena, ArenaType, CommittedDelta < 0 ? mm(-CommittedDelta) : mm(CommittedDelta), 0, 0,
+                      CommittedDelta, 0);
+}
+
+inline void DebugRecordRelease(void* Arena)
+{
+    // NOTE: Arena gave all of its memory back, zero its counters and give up the slot so an arena created at the same address later
+    // starts from scratch instead of inheriting them. Its events stay in the rings
+    u64 Key = u64(Arena);
+    u64 Hash = (Key >> 4) * 0x9E3779B97F4A7C15ull;
+    for (u32 ProbeId = 0; ProbeId < DEBUG_MEMORY_MAX_ARENAS; ++ProbeId)
+    {
+        debug_arena_stats* Stats = DebugMemoryState.Arenas + ((Hash >> 40) + ProbeId) % DEBUG_MEMORY_MAX_ARENAS;
+        u64 SlotKey = AtomicLoadU64(&Stats->Arena);
+        if (SlotKey == 0)
+        {
+            break;
+        }
+        
+        if (SlotKey == Key)
+        {
+            AtomicStoreU64(&Stats->NumAllocs, 0);
+            AtomicStoreU64(&Stats->NumBytes, 0);
+            AtomicStoreU64(&Stats->Used, 0);
+            AtomicStoreU64(&Stats->HighWater, 0);
+            AtomicStoreU64(&Stats->Committed, 0);
+            AtomicStoreU64(&Stats->CommittedHighWater, 0);
+            AtomicStoreU64(&Stats->Arena, DEBUG_MEMORY_RELEASED_SLOT);
+            if (DebugMemoryLastStats == Stats)
+            {
+                DebugMemoryLastStats = 0;
+            }
+            break;
+        }
+    }
+}
+
+//
+// NOTE: Export
+//
+
+inline const char* DebugArenaTypeName(u32 ArenaType)
+{
+    const char* Names[] = { "linear", "dynamic", "block", "slab", "tlsf" };
+    const char* Result = ArenaType < ArrayCount(Names) ? Names[ArenaType] : "unknown";
+    return Result;
+}
+
+inline b32 DebugMemoryExportChromeTrace(const char* FileName)
+{
+    FILE* File = fopen(FileName, "wb");
+    if (!File)
+    {
+        return false;
+    }
+
+    const char* EventNames[] = { "alloc", "free", "clear", "commit" };
+
+    // NOTE: Calibrate ticks against the OS clock over the whole profiled run
+    u64 EndTicks = DebugMemoryGetTicks();
+    u64 EndTimeNs = MemoryGetTimeNs();
+    f64 NsPerTick = 1.0;
+    if (EndTicks > DebugMemoryState.StartTicks)
+    {
+        NsPerTick = f64(EndTimeNs - DebugMemoryState.StartTimeNs) / f64(EndTicks - DebugMemoryState.StartTicks);
+    }
+    
+    fprintf(File, "{\"traceEvents\": [\n");
+    b32 First = true;
+    for (debug_memory_ring* Ring = (debug_memory_ring*)AtomicLoadU64(&DebugMemoryState.Rings); Ring; Ring = Ring->Next)
+    {
+        u64 WriteIndex = AtomicLoadU64(&Ring->WriteIndex);
+        u64 StartIndex = WriteIndex > DEBUG_MEMORY_RING_SIZE ? WriteIndex - DEBUG_MEMORY_RING_SIZE : 0;
+        for (u64 EventIndex = StartIndex; EventIndex < WriteIndex; ++EventIndex)
+        {
+            debug_memory_event* Event = Ring->Events + (EventIndex % DEBUG_MEMORY_RING_SIZE);
+            f64 TimeUs = f64(i64(Event->Ticks - DebugMemoryState.StartTicks)) * NsPerTick / 1000.0;
+            
+            fprintf(File, "%s{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %.3f, \"pid\": 1, \"tid\": %u, "
+                    "\"args\": {\"arena\": \"%p\", \"size\": %llu, \"alignment\": %u, \"call_site\": \"%p\"}}",
+                    First ? "" : ",\n", EventNames[Event->Type], DebugArenaTypeName(Event->ArenaType), TimeUs, Ring->ThreadId,
+                    Event->Arena, (unsigned long long)Event->Size, Event->Alignment, Event->CallSite);
+            First = false;
+
+            fprintf(File, ",\n{\"name\": \"%s arena %p\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, "
+                    "\"args\": {\"used\": %llu, \"committed\": %llu}}",
+                    DebugArenaTypeName(Event->ArenaType), Event->Arena, TimeUs, (unsigned long long)Event->Used,
+                    (unsigned long long)Event->Committed);
+        }
+    }
+    fprintf(File, "\n]}\n");
+    
+    fclose(File);
+    return true;
+}
+
+inline void DebugMemoryPrintSummary(FILE* File = stdout)
+{
+    fprintf(File, "%-8s %-18s %12s %14s %14s %14s %14s\n", "type", "arena", "allocs", "bytes", "used", "high water", "committed");
+    for (u32 ArenaId = 0; ArenaId < DEBUG_MEMORY_MAX_ARENAS; ++ArenaId)
+    {
+        debug_arena_stats* Stats = DebugMemoryState.Arenas + ArenaId;
+        if (Stats->Arena > DEBUG_MEMORY_RELEASED_SLOT)
+        {
+            fprintf(File, "%-8s %-18p %12llu %14llu %14llu %14llu %14llu\n", DebugArenaTypeName(Stats->ArenaType), (void*)Stats->Arena,
+                    (unsigned long long)Stats->NumAllocs, (unsigned long long)Stats->NumBytes, (unsigned long long)Stats->Used,
+                    (unsigned long long)Stats->HighWater, (unsigned long long)Stats->Committed);
+        }
+    }
+}
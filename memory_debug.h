@@ -0,0 +1,102 @@
+#pragma once
+
+//
+// NOTE: Debug Memory Profiling
+//
+
+/*
+
+  NOTE: With DEBUG_MEMORY_PROFILING on, every arena reports pushes, frees/clears and commits here. Events go into a per thread ring
+  buffer (only its own thread writes it, so recording is a handful of stores) and per arena used/high water/committed counters live
+  in a fixed open addressed table. An arena gives its slot back when it gets released (block, slab and tlsf arenas have no release,
+  so for them when they get cleared) and a new arena at the same address starts with fresh counters. Rings overwrite their oldest
+  events once full. Rings are mapped with MemoryFlag_Untracked so they don't show up in MemoryOsStats, and a thread hands its ring
+  back when it exits. The ring keeps its events until a new thread picks it up, so the rings only grow with the number of threads
+  alive at once, not with thread churn. If mapping a ring fails, that threads events get dropped.
+
+  To keep this cheap enough for staging, events are stamped with the cycle counter instead of the OS clock (converted to ns at
+  export) and each thread caches the stats slot of the last arena it touched. The per arena counters are updated with atomic adds
+  (high water marks with a CAS max) since the concurrent linear/dynamic/block arenas record from several threads at once.
+
+  DebugMemoryExportChromeTrace writes everything that is still in the rings as a chrome://tracing / perfetto JSON file (instant events
+  per push plus a used/committed counter track per arena), DebugMemoryPrintSummary prints the per arena table. Both expect the
+  arenas to be quiet while they run since they read other threads rings.
+
+  Call sites are return addresses of the arena function, so they point at the function that pushed unless the push got inlined
+  into it, then it is that functions caller.
+  
+ */
+
+#ifndef DEBUG_MEMORY_RING_SIZE
+#define DEBUG_MEMORY_RING_SIZE (1 << 16)
+#endif
+
+#ifndef DEBUG_MEMORY_MAX_ARENAS
+#define DEBUG_MEMORY_MAX_ARENAS 4096
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define DEBUG_MEMORY_CALL_SITE _ReturnAddress()
+#else
+#define DEBUG_MEMORY_CALL_SITE __builtin_return_address(0)
+#endif
+
+enum debug_arena_type
+{
+    DebugArenaType_Linear,
+    DebugArenaType_Dynamic,
+    DebugArenaType_Block,
+    DebugArenaType_Slab,
+    DebugArenaType_Tlsf,
+};
+
+enum debug_memory_event_type
+{
+    DebugMemoryEvent_Alloc,
+    DebugMemoryEvent_Free,
+    DebugMemoryEvent_Clear,
+    DebugMemoryEvent_Commit,
+};
+
+struct debug_memory_event
+{
+    u64 Ticks;
+    void* Arena;
+    void* CallSite;
+    u64 Size;
+    u64 Used; // NOTE: Arena used/committed after this event
+    u64 Committed;
+    u32 Alignment;
+    u16 Type;
+    u16 ArenaType;
+};
+
+struct debug_memory_ring
+{
+    debug_memory_ring* Next;
+    u32 ThreadId;
+    volatile u32 IsFree; // NOTE: Set when the owning thread exits, the next new thread claims it with a CAS
+    volatile u64 WriteIndex;
+    debug_memory_event Events[DEBUG_MEMORY_RING_SIZE];
+};
+
+struct debug_arena_stats
+{
+    volatile u64 Arena; // NOTE: 0 if the slot is empty
+    u32 ArenaType;
+    volatile u64 NumAllocs;
+    volatile u64 NumBytes;
+    volatile u64 Used;
+    volatile u64 HighWater;
+    volatile u64 Committed;
+    volatile u64 CommittedHighWater;
+};
+
+struct debug_memory_state
+{
+    volatile u64 Rings; // NOTE: debug_memory_ring*, pushed with a CAS
+    volatile u32 NextThreadId;
+    u64 StartTicks;
+    u64 StartTimeNs;
+    debug_arena_stats Arenas[DEBUG_MEMORY_MAX_ARENAS];
+};
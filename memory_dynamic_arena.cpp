@@ -3,39 +3,196 @@
 // NOTE: Dynamic Arena
 //
 
-inline mm DynamicArenaGetBlockSize(mm AllocSize)
+inline mm DynamicArenaGetBlockSize(mm AllocSize, u32 Flags)
 {
-    // NOTE: We allocate to nearest page size, so +1 to fit the header
-    // TODO: Get page size on other platforms here
-    mm PageSize = KiloBytes(4);
-    mm NumPages = mm(CeilF32(f32(AllocSize) / f32(PageSize))) + 1;
-    mm Result = PageSize * NumPages;
+    // NOTE: AllocSize includes the header, we round up to what the OS maps anyways
+    mm Result = MemoryGetAllocSize(AllocSize, Flags);
+    return Result;
+}
+
+inline dynamic_arena DynamicArenaCreate(mm MinBlockSize, u32 Flags = 0, mm MaxBlockSize = DYNAMIC_ARENA_DEFAULT_MAX_BLOCK_SIZE,
+                                        mm MaxRetainedSize = DYNAMIC_ARENA_DEFAULT_MAX_RETAINED_SIZE, u32 ArenaFlags = 0)
+{
+    dynamic_arena Result = {};
+    Result.ArenaFlags = ArenaFlags;
+    Result.MinBlockSize = MinBlockSize;
+    Result.MaxBlockSize = Max(MaxBlockSize, MinBlockSize);
+    Result.NextBlockSize = MinBlockSize;
+    Result.Flags = Flags;
+    Result.MaxRetainedSize = MaxRetainedSize;
 
     return Result;
 }
 
-inline dynamic_arena_header* DynamicArenaAllocHeader(mm Size)
+inline u32 DynamicArenaGetBucketId(mm Size)
 {
-    mm AllocSize = DynamicArenaGetBlockSize(Size);
-    dynamic_arena_header* Result = (dynamic_arena_header*)MemoryAllocate(AllocSize);
-    Result->Used = sizeof(dynamic_arena_header);
-    Result->Size = AllocSize;
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long Log = 0;
+    _BitScanReverse64(&Log, u64(Size));
+#else
+    u32 Log = 63 - u32(__builtin_clzll(u64(Size)));
+#endif
+    u32 Result = Log <= DYNAMIC_ARENA_MIN_BUCKET_LOG2 ? 0 : u32(Log) - DYNAMIC_ARENA_MIN_BUCKET_LOG2;
+    Result = Min(Result, u32(DYNAMIC_ARENA_NUM_BUCKETS - 1));
+    
+    return Result;
+}
+
+inline dynamic_arena_header* DynamicArenaGetRetainedHeader(dynamic_arena* Arena, mm AllocSize)
+{
+    // NOTE: First fit in the bucket AllocSize falls in, after that anything in a bigger bucket is big enough
+    dynamic_arena_header* Result = 0;
+    u32 StartBucketId = DynamicArenaGetBucketId(AllocSize);
+    for (u32 BucketId = StartBucketId; BucketId < DYNAMIC_ARENA_NUM_BUCKETS && !Result; ++BucketId)
+    {
+        dynamic_arena_header* Prev = 0;
+        for (dynamic_arena_header* Header = Arena->FreeBuckets[BucketId]; Header; Prev = Header, Header = Header->Next)
+        {
+            if (Header->Size >= AllocSize)
+            {
+                if (Prev)
+                {
+                    Prev->Next = Header->Next;
+                }
+                else
+                {
+                    Arena->FreeBuckets[BucketId] = Header->Next;
+                }
+
+                Arena->RetainedSize -= Header->Size;
+                Result = Header;
+                break;
+            }
+        }
+    }
 
     return Result;
 }
 
-inline dynamic_arena DynamicArenaCreate(mm MinBlockSize)
+inline dynamic_arena_header* DynamicArenaGetRetainedLargeHeader(dynamic_arena* Arena, mm AllocSize)
 {
-    dynamic_arena Result = {};
-    Result.MinBlockSize = MinBlockSize;
+    // NOTE: First fit, but skip blocks more than twice the size so a small large push doesn't pin a huge mapping
+    dynamic_arena_header* Result = 0;
+    dynamic_arena_header* Prev = 0;
+    for (dynamic_arena_header* Header = Arena->FreeLargeBlocks; Header; Prev = Header, Header = Header->Next)
+    {
+        if (Header->Size >= AllocSize && Header->Size <= 2 * AllocSize)
+        {
+            if (Prev)
+            {
+                Prev->Next = Header->Next;
+            }
+            else
+            {
+                Arena->FreeLargeBlocks = Header->Next;
+            }
+
+            Arena->RetainedSize -= Header->Size;
+            Result = Header;
+            break;
+        }
+    }
 
     return Result;
 }
 
+inline dynamic_arena_header* DynamicArenaAllocHeader(dynamic_arena* Arena, mm NeededSize, mm BlockSize, b32 Large = false)
+{
+    // NOTE: Prefer a retained block of the size we want so temp mem loops line up, then any retained block that fits. Large pushes
+    // only look at the retained large blocks. Returns 0 if the OS is out of memory
+    dynamic_arena_header* Result = 0;
+    if (Large)
+    {
+        Result = DynamicArenaGetRetainedLargeHeader(Arena, BlockSize);
+    }
+    else
+    {
+        Result = DynamicArenaGetRetainedHeader(Arena, BlockSize);
+        if (!Result && NeededSize < BlockSize)
+        {
+            Result = DynamicArenaGetRetainedHeader(Arena, NeededSize);
+        }
+    }
+
+    if (Result)
+    {
+        BlockSize = Result->Size;
+        *Result = {};
+    }
+    else
+    {
+        Result = (dynamic_arena_header*)MemoryAllocate(BlockSize, Arena->Flags);
+        if (!Result)
+        {
+            return 0;
+        }
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordCommit(Arena, DebugArenaType_Dynamic, i64(BlockSize));
+#endif
+    }
+    
+    Result->Used = sizeof(dynamic_arena_header);
+    Result->Size = BlockSize;
+
+    return Result;
+}
+
+inline void DynamicArenaFreeHeader(dynamic_arena* Arena, dynamic_arena_header* Header, b32 Large = false)
+{
+    if (Arena->RetainedSize + Header->Size <= Arena->MaxRetainedSize)
+    {
+        // NOTE: Keep the block around for the next push, large blocks on their own list so bump blocks never land in one
+        dynamic_arena_header** FreeList = Large ? &Arena->FreeLargeBlocks : &Arena->FreeBuckets[DynamicArenaGetBucketId(Header->Size)];
+        Header->Prev = 0;
+        Header->Next = *FreeList;
+        *FreeList = Header;
+        Arena->RetainedSize += Header->Size;
+    }
+    else
+    {
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordCommit(Arena, DebugArenaType_Dynamic, -i64(Header->Size));
+#endif
+        MemoryFree(Header, Header->Size, Arena->Flags);
+    }
+}
+
+inline void DynamicArenaTrim(dynamic_arena* Arena, mm KeepSize = 0)
+{
+    // NOTE: Gives retained blocks back to the OS until we hold at most KeepSize bytes, biggest blocks go first
+    while (Arena->FreeLargeBlocks && Arena->RetainedSize > KeepSize)
+    {
+        dynamic_arena_header* Header = Arena->FreeLargeBlocks;
+        Arena->FreeLargeBlocks = Header->Next;
+        Arena->RetainedSize -= Header->Size;
+            
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordCommit(Arena, DebugArenaType_Dynamic, -i64(Header->Size));
+#endif
+        MemoryFree(Header, Header->Size, Arena->Flags);
+    }
+    
+    for (i32 BucketId = DYNAMIC_ARENA_NUM_BUCKETS - 1; BucketId >= 0 && Arena->RetainedSize > KeepSize; --BucketId)
+    {
+        while (Arena->FreeBuckets[BucketId] && Arena->RetainedSize > KeepSize)
+        {
+            dynamic_arena_header* Header = Arena->FreeBuckets[BucketId];
+            Arena->FreeBuckets[BucketId] = Header->Next;
+            Arena->RetainedSize -= Header->Size;
+            
+#if DEBUG_MEMORY_PROFILING
+            DebugRecordCommit(Arena, DebugArenaType_Dynamic, -i64(Header->Size));
+#endif
+            MemoryFree(Header, Header->Size, Arena->Flags);
+        }
+    }
+}
+
 // TODO: Make size/used be hidden? Or just don't use push to put the header, it complicates eveyrthing
 inline mm DynamicArenaHeaderGetSize(dynamic_arena_header* Header)
 {
-    mm Result = Header->Used - sizeof(*Header);
+    // NOTE: Concurrent pushes that overflowed a block leave Used past its Size
+    mm Result = Min(Header->Used, Header->Size) - sizeof(*Header);
     return Result;
 }
 
@@ -46,8 +203,135 @@ inline void* DynamicArenaHeaderGetData(dynamic_arena_header* Header)
     return Result;
 }
 
+/*
+
+  NOTE: In concurrent mode many threads can push onto the same arena. A push is a single atomic add on the current blocks Used that
+  reserves Size plus the worst case alignment padding. When that runs past the end of the block, the thread grabs a new block, does
+  its push in it before anyone else can see it, and tries to swap it in as the current block with a compare exchange. If another
+  thread got there first the block goes back to the retained cache and we retry on the winners block. Only getting the memory for a
+  block takes the arena lock (the retained cache isn't thread safe), pushes that fit never wait on it.
+
+  Large blocks are pushed onto their list with a compare exchange as well. Temp mem, clear, trim and release don't synchronize with
+  pushes, call them once the producers are done. Blocks that overflowed keep a Used past their Size, so don't read Used directly.
+  
+ */
+
+inline dynamic_arena_header* DynamicArenaAllocHeaderLocked(dynamic_arena* Arena, mm NeededSize, mm BlockSize, b32 Large = false)
+{
+    SpinLockAcquire(&Arena->Lock);
+    dynamic_arena_header* Result = DynamicArenaAllocHeader(Arena, NeededSize, BlockSize, Large);
+    SpinLockRelease(&Arena->Lock);
+
+    return Result;
+}
+
+inline void* PushSizeAlignedConcurrent(dynamic_arena* Arena, mm Size, mm Alignment)
+{
+    void* Result = 0;
+    mm PaddedSize = Size + Alignment - 1;
+    mm NeededSize = AlignAddress(mm(sizeof(dynamic_arena_header)), Alignment) + Size;
+    
+    mm LargeNextBlockSize = mm(AtomicLoadU64((volatile u64*)&Arena->NextBlockSize));
+    if (NeededSize > DYNAMIC_ARENA_LARGE_PUSH_FACTOR * LargeNextBlockSize)
+    {
+        // NOTE: Too big for our blocks, give it its own mapping and link it in
+        dynamic_arena_header* LargeHeader = DynamicArenaAllocHeaderLocked(Arena, NeededSize,
+                                                                          DynamicArenaGetBlockSize(NeededSize, Arena->Flags), true);
+        if (!LargeHeader)
+        {
+            return 0;
+        }
+        AtomicCompareExchangeU64((volatile u64*)&Arena->NextBlockSize, LargeNextBlockSize,
+                                 Min(LargeNextBlockSize * 2, Arena->MaxBlockSize));
+        
+        mm AlignedOffset = AlignAddress(LargeHeader->Used, Alignment);
+        Result = (u8*)LargeHeader + AlignedOffset;
+        LargeHeader->Used = AlignedOffset + Size;
+
+        u64 OldHead = AtomicLoadU64((volatile u64*)&Arena->LargeBlocks);
+        while (true)
+        {
+            LargeHeader->Next = (dynamic_arena_header*)OldHead;
+            u64 SeenHead = AtomicCompareExchangeU64((volatile u64*)&Arena->LargeBlocks, OldHead, u64(LargeHeader));
+            if (SeenHead == OldHead)
+            {
+                break;
+            }
+            OldHead = SeenHead;
+        }
+        
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordAllocation(Arena, DebugArenaType_Dynamic, Size, Alignment, i64(DynamicArenaHeaderGetSize(LargeHeader)),
+                              DEBUG_MEMORY_CALL_SITE);
+#endif
+        return Result;
+    }
+
+    while (!Result)
+    {
+        dynamic_arena_header* Header = (dynamic_arena_header*)AtomicLoadU64((volatile u64*)&Arena->Prev);
+        if (Header)
+        {
+            mm Offset = mm(AtomicAddU64((volatile u64*)&Header->Used, PaddedSize));
+            if (Offset + PaddedSize <= Header->Size)
+            {
+                Result = (u8*)Header + AlignAddress(Offset, Alignment);
+                break;
+            }
+        }
+
+        // NOTE: Header is full, push into a new block and try to make it the current one
+        mm NextBlockSize = mm(AtomicLoadU64((volatile u64*)&Arena->NextBlockSize));
+        mm BlockSize = DynamicArenaGetBlockSize(Max(NextBlockSize, NeededSize), Arena->Flags);
+        dynamic_arena_header* NewHeader = DynamicArenaAllocHeaderLocked(Arena, NeededSize, BlockSize);
+        if (!NewHeader)
+        {
+            return 0;
+        }
+        
+        mm AlignedOffset = AlignAddress(NewHeader->Used, Alignment);
+        NewHeader->Used = AlignedOffset + Size;
+        NewHeader->Prev = Header;
+        NewHeader->Next = 0;
+
+        if (AtomicCompareExchangeU64((volatile u64*)&Arena->Prev, u64(Header), u64(NewHeader)) == u64(Header))
+        {
+            // NOTE: Only the winner links the old block to the new one, nobody walks the list until the producers are done
+            if (Header)
+            {
+                Header->Next = NewHeader;
+            }
+            else
+            {
+                Arena->Next = NewHeader;
+            }
+            AtomicCompareExchangeU64((volatile u64*)&Arena->NextBlockSize, NextBlockSize,
+                                     Min(NextBlockSize * 2, Arena->MaxBlockSize));
+            
+            Result = (u8*)NewHeader + AlignedOffset;
+        }
+        else
+        {
+            SpinLockAcquire(&Arena->Lock);
+            DynamicArenaFreeHeader(Arena, NewHeader);
+            SpinLockRelease(&Arena->Lock);
+        }
+    }
+
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordAllocation(Arena, DebugArenaType_Dynamic, Size, Alignment, i64(PaddedSize), DEBUG_MEMORY_CALL_SITE);
+#endif
+
+    return Result;
+}
+
 inline void* PushSizeAligned(dynamic_arena* Arena, mm Size, mm Alignment = 4)
 {
+    if (Arena->ArenaFlags & DynamicArenaFlag_Concurrent)
+    {
+        return PushSizeAlignedConcurrent(Arena, Size, Alignment);
+    }
+    
     void* Result = 0;
     dynamic_arena_header* Header = Arena->Prev;
     
@@ -55,20 +339,58 @@ inline void* PushSizeAligned(dynamic_arena* Arena, mm Size, mm Alignment = 4)
     mm AlignedOffset = Header ? AlignAddress(Header->Used, Alignment) : 0;
     if (!Header || (AlignedOffset + Size) > Header->Size)
     {
-        // NOTE: Allocate a new block
-        dynamic_arena_header* NewHeader = DynamicArenaAllocHeader(Max(Size, Arena->MinBlockSize));
+        // NOTE: Blocks are page aligned so this covers the worst case alignment padding
+        mm NeededSize = AlignAddress(mm(sizeof(dynamic_arena_header)), Alignment) + Size;
+        if (NeededSize > DYNAMIC_ARENA_LARGE_PUSH_FACTOR * Arena->NextBlockSize)
+        {
+            // NOTE: Too big for our blocks, give it its own mapping and keep bumping the current block. We still grow so pushes
+            // this size end up in bump blocks once the arena is used for them
+            dynamic_arena_header* LargeHeader = DynamicArenaAllocHeader(Arena, NeededSize, DynamicArenaGetBlockSize(NeededSize, Arena->Flags),
+                                                                        true);
+            if (!LargeHeader)
+            {
+                // NOTE: Out of memory, leave the arena as it was
+                return 0;
+            }
+            Arena->NextBlockSize = Min(Arena->NextBlockSize * 2, Arena->MaxBlockSize);
+            LargeHeader->Next = Arena->LargeBlocks;
+            Arena->LargeBlocks = LargeHeader;
+
+            AlignedOffset = AlignAddress(LargeHeader->Used, Alignment);
+            Result = (u8*)LargeHeader + AlignedOffset;
+            LargeHeader->Used = AlignedOffset + Size;
+            
+#if DEBUG_MEMORY_PROFILING
+            DebugRecordAllocation(Arena, DebugArenaType_Dynamic, Size, Alignment, i64(DynamicArenaHeaderGetSize(LargeHeader)),
+                                  DEBUG_MEMORY_CALL_SITE);
+#endif
+            return Result;
+        }
+
+        // NOTE: Grab a new block and grow the next one
+        mm BlockSize = DynamicArenaGetBlockSize(Max(Arena->NextBlockSize, NeededSize), Arena->Flags);
+        dynamic_arena_header* NewHeader = DynamicArenaAllocHeader(Arena, NeededSize, BlockSize);
+        if (!NewHeader)
+        {
+            return 0;
+        }
+        Arena->NextBlockSize = Min(Arena->NextBlockSize * 2, Arena->MaxBlockSize);
         DoubleListAppend(Arena, NewHeader, Next, Prev);
         Header = NewHeader;
         AlignedOffset = AlignAddress(Header->Used, Alignment);
     }
 
+#if DEBUG_MEMORY_PROFILING
+    mm OldUsed = Header->Used;
+#endif
+
     // NOTE: Suballocate a page
     u8* BasePtr = (u8*)Header;
     Result = BasePtr + AlignedOffset;
     Header->Used = AlignedOffset + Size;
     
 #if DEBUG_MEMORY_PROFILING
-    DebugRecordAllocation(Arena);
+    DebugRecordAllocation(Arena, DebugArenaType_Dynamic, Size, Alignment, i64(Header->Used - OldUsed), DEBUG_MEMORY_CALL_SITE);
 #endif
 
     return Result;
@@ -76,6 +398,10 @@ inline void* PushSizeAligned(dynamic_arena* Arena, mm Size, mm Alignment = 4)
 
 inline void ArenaClear(dynamic_arena* Arena)
 {
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordClear(Arena, DebugArenaType_Dynamic, DEBUG_MEMORY_CALL_SITE);
+#endif
+    
     for (dynamic_arena_header* Header = Arena->Next;
          Header;
          )
@@ -83,8 +409,27 @@ inline void ArenaClear(dynamic_arena* Arena)
         dynamic_arena_header* CurrHeader = Header;
         Header = Header->Next;
         DoubleListRemove(Arena, CurrHeader, Next, Prev);        
-        MemoryFree(CurrHeader);
+        DynamicArenaFreeHeader(Arena, CurrHeader);
+    }
+
+    while (Arena->LargeBlocks)
+    {
+        dynamic_arena_header* CurrHeader = Arena->LargeBlocks;
+        Arena->LargeBlocks = CurrHeader->Next;
+        DynamicArenaFreeHeader(Arena, CurrHeader, true);
     }
+
+    Arena->NextBlockSize = Arena->MinBlockSize;
+}
+
+inline void DynamicArenaRelease(dynamic_arena* Arena)
+{
+    ArenaClear(Arena);
+    DynamicArenaTrim(Arena, 0);
+    
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordRelease(Arena);
+#endif
 }
 
 inline dynamic_temp_mem BeginTempMem(dynamic_arena* Arena)
@@ -92,7 +437,9 @@ inline dynamic_temp_mem BeginTempMem(dynamic_arena* Arena)
     dynamic_temp_mem Result = {};
     Result.Arena = Arena;
     Result.Header = Arena->Prev;
-    Result.Used = Result.Header ? Result.Header->Used : 0;
+    Result.Used = Result.Header ? Min(Result.Header->Used, Result.Header->Size) : 0;
+    Result.NextBlockSize = Arena->NextBlockSize;
+    Result.LargeBlocks = Arena->LargeBlocks;
 
     return Result;
 };
@@ -105,29 +452,34 @@ inline void EndTempMem(dynamic_temp_mem TempMem)
         dynamic_arena_header* CurrHeader = Header;
         Header = Header->Prev;
 
-        // NOTE: Remove from linked list
-        if (CurrHeader->Prev)
-        {
-            CurrHeader->Prev->Next = CurrHeader->Next;
-        }
-        else
-        {
-            TempMem.Arena->Prev = 0;
-        }
-        if (CurrHeader->Next)
-        {
-            CurrHeader->Next->Prev = CurrHeader->Prev;
-        }
-        else
-        {
-            TempMem.Arena->Next = 0;
-        }
+        DoubleListRemove(TempMem.Arena, CurrHeader, Next, Prev);
 
-        MemoryFree(CurrHeader);
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordFree(TempMem.Arena, DebugArenaType_Dynamic, DynamicArenaHeaderGetSize(CurrHeader), DEBUG_MEMORY_CALL_SITE);
+#endif
+        DynamicArenaFreeHeader(TempMem.Arena, CurrHeader);
     }
 
     if (Header)
     {
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordFree(TempMem.Arena, DebugArenaType_Dynamic, Header->Used - TempMem.Used, DEBUG_MEMORY_CALL_SITE);
+#endif
         Header->Used = TempMem.Used;
     }
+
+    // NOTE: Large blocks are newest first so everything pushed after TempMem sits in front of its head
+    while (TempMem.Arena->LargeBlocks != TempMem.LargeBlocks)
+    {
+        dynamic_arena_header* CurrHeader = TempMem.Arena->LargeBlocks;
+        TempMem.Arena->LargeBlocks = CurrHeader->Next;
+        
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordFree(TempMem.Arena, DebugArenaType_Dynamic, DynamicArenaHeaderGetSize(CurrHeader), DEBUG_MEMORY_CALL_SITE);
+#endif
+        DynamicArenaFreeHeader(TempMem.Arena, CurrHeader, true);
+    }
+
+    // NOTE: Walk the same block sizes next time so we keep hitting the retained blocks
+    TempMem.Arena->NextBlockSize = TempMem.NextBlockSize;
 }
@@ -4,6 +4,49 @@
 // NOTE: Dynamic Arena
 //
 
+/*
+
+  NOTE: Blocks released by EndTempMem/ArenaClear aren't handed back to the OS right away. They go on free lists bucketed by the log2
+  of their size and the next push that needs a block takes one from there, so temp mem loops stop paying for a map/unmap pair plus
+  fresh page faults every iteration. Each arena keeps at most MaxRetainedSize bytes around, anything past that is freed. Call
+  DynamicArenaTrim to give retained blocks back early and DynamicArenaRelease to tear the arena down.
+
+  Blocks grow geometrically: each new block is twice the size of the last one, starting at MinBlockSize and capped at MaxBlockSize
+  (pass MaxBlockSize = MinBlockSize for fixed size blocks). Sizes are rounded to what the OS maps (its page size, or the huge page
+  size for huge page arenas). Temp mem remembers the growth state so a temp mem loop walks the same block sizes every iteration
+  and always hits the retained cache.
+
+  Pushes bigger than DYNAMIC_ARENA_LARGE_PUSH_FACTOR times the next block size don't fit our growth pattern, so they get their own
+  mapping on a separate large block list. The current bump block stays where it is, so we don't throw away the rest of it, and the
+  arena still grows so repeated pushes that size move into bump blocks. Smaller pushes that don't fit just start a new bump block.
+  EndTempMem/ArenaClear retain large blocks on their own list that only large pushes take from, so a bump block never ends up
+  pinning an oversized mapping.
+  
+ */
+
+#ifndef DYNAMIC_ARENA_DEFAULT_MAX_BLOCK_SIZE
+#define DYNAMIC_ARENA_DEFAULT_MAX_BLOCK_SIZE MegaBytes(64)
+#endif
+
+#ifndef DYNAMIC_ARENA_DEFAULT_MAX_RETAINED_SIZE
+#define DYNAMIC_ARENA_DEFAULT_MAX_RETAINED_SIZE MegaBytes(64)
+#endif
+
+#ifndef DYNAMIC_ARENA_LARGE_PUSH_FACTOR
+#define DYNAMIC_ARENA_LARGE_PUSH_FACTOR 4
+#endif
+
+// NOTE: Bucket 0 holds blocks under 8KB, the last bucket holds everything too big for the rest
+#define DYNAMIC_ARENA_MIN_BUCKET_LOG2 12
+#define DYNAMIC_ARENA_NUM_BUCKETS 32
+
+enum dynamic_arena_flags
+{
+    DynamicArenaFlag_None = 0,
+    // NOTE: Lets many threads push at once (see PushSizeAlignedConcurrent)
+    DynamicArenaFlag_Concurrent = 1 << 0,
+};
+
 struct dynamic_arena_header
 {
     // NOTE: Stored at the top of pages
@@ -19,6 +62,21 @@ struct dynamic_arena
     dynamic_arena_header* Prev;
     dynamic_arena_header* Next;
     mm MinBlockSize;
+    mm MaxBlockSize;
+    mm NextBlockSize; // NOTE: Size of the next block we map, doubles until MaxBlockSize
+    u32 Flags; // NOTE: memory_flags passed to the OS for each block
+
+    // NOTE: Blocks for pushes too big for the bump blocks, newest first and linked through Next
+    dynamic_arena_header* LargeBlocks;
+
+    // NOTE: Released blocks we kept around for reuse, linked through Next
+    dynamic_arena_header* FreeBuckets[DYNAMIC_ARENA_NUM_BUCKETS];
+    dynamic_arena_header* FreeLargeBlocks;
+    mm RetainedSize;
+    mm MaxRetainedSize;
+
+    u32 ArenaFlags;
+    volatile u32 Lock; // NOTE: Concurrent mode, guards the retained blocks while we grab a new block
 };
 
 struct dynamic_temp_mem
@@ -26,5 +84,7 @@ struct dynamic_temp_mem
     dynamic_arena* Arena;
     dynamic_arena_header* Header;
     mm Used;
+    mm NextBlockSize;
+    dynamic_arena_header* LargeBlocks;
 };
 
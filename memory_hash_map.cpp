@@ -0,0 +1,366 @@
+//
+// NOTE: Hash Map
+//
+
+#include <string.h>
+
+#if MEMORY_X86 && defined(__AVX2__)
+#define HASH_MAP_GROUP_WIDTH 32
+#else
+#define HASH_MAP_GROUP_WIDTH 16
+#endif
+
+// NOTE: Max load is 7/8 of the slots counting deleted ones
+#define HASH_MAP_MAX_LOAD_NUMERATOR 7
+#define HASH_MAP_MAX_LOAD_DENOMINATOR 8
+
+//
+// NOTE: Hash functions
+//
+
+inline u64 HashMapMix(u64 Value)
+{
+    // NOTE: Murmur3 finalizer, spreads every input bit over the whole output
+    Value ^= Value >> 33;
+    Value *= 0xFF51AFD7ED558CCDull;
+    Value ^= Value >> 33;
+    Value *= 0xC4CEB9FE1A85EC53ull;
+    Value ^= Value >> 33;
+    return Value;
+}
+
+inline u64 HashMapHashBytes(const void* Mem, mm Size)
+{
+    const u8* CurrByte = (const u8*)Mem;
+    u64 Result = 0x9E3779B97F4A7C15ull ^ Size;
+    for (; Size >= 8; Size -= 8, CurrByte += 8)
+    {
+        u64 Chunk;
+        memcpy(&Chunk, CurrByte, 8);
+        Result = HashMapMix(Result ^ Chunk);
+    }
+    if (Size)
+    {
+        u64 Chunk = 0;
+        memcpy(&Chunk, CurrByte, Size);
+        Result = HashMapMix(Result ^ Chunk);
+    }
+
+    return Result;
+}
+
+inline u64 HashMapHash(u32 Key) { return HashMapMix(Key); }
+inline u64 HashMapHash(u64 Key) { return HashMapMix(Key); }
+inline u64 HashMapHash(i32 Key) { return HashMapMix(u64(u32(Key))); }
+inline u64 HashMapHash(i64 Key) { return HashMapMix(u64(Key)); }
+
+template<typename key>
+inline u64 HashMapHash(const key& Key)
+{
+    return HashMapHashBytes(&Key, sizeof(Key));
+}
+
+//
+// NOTE: Control byte groups
+//
+
+inline u32 HashMapTrailingZeros(u32 Value)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long Result = 0;
+    _BitScanForward(&Result, Value);
+    return u32(Result);
+#else
+    return u32(__builtin_ctz(Value));
+#endif
+}
+
+// NOTE: Each returns a bitmask with bit i set if slot i of the group matches
+#if MEMORY_X86 && HASH_MAP_GROUP_WIDTH == 32
+
+inline u32 HashMapGroupMatch(const u8* Ctrl, u8 Hash)
+{
+    __m256i Group = _mm256_load_si256((const __m256i*)Ctrl);
+    return u32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(Group, _mm256_set1_epi8(char(Hash)))));
+}
+
+inline u32 HashMapGroupMatchEmpty(const u8* Ctrl)
+{
+    return HashMapGroupMatch(Ctrl, HASH_MAP_CTRL_EMPTY);
+}
+
+inline u32 HashMapGroupMatchFree(const u8* Ctrl)
+{
+    // NOTE: Empty and deleted both have the top bit set
+    return u32(_mm256_movemask_epi8(_mm256_load_si256((const __m256i*)Ctrl)));
+}
+
+#elif MEMORY_X86
+
+inline u32 HashMapGroupMatch(const u8* Ctrl, u8 Hash)
+{
+    __m128i Group = _mm_load_si128((const __m128i*)Ctrl);
+    return u32(_mm_movemask_epi8(_mm_cmpeq_epi8(Group, _mm_set1_epi8(char(Hash)))));
+}
+
+inline u32 HashMapGroupMatchEmpty(const u8* Ctrl)
+{
+    return HashMapGroupMatch(Ctrl, HASH_MAP_CTRL_EMPTY);
+}
+
+inline u32 HashMapGroupMatchFree(const u8* Ctrl)
+{
+    // NOTE: Empty and deleted both have the top bit set
+    return u32(_mm_movemask_epi8(_mm_load_si128((const __m128i*)Ctrl)));
+}
+
+#elif defined(__aarch64__)
+
+#include <arm_neon.h>
+
+inline u32 HashMapNeonMask_(uint8x16_t Matches)
+{
+    // NOTE: NEON has no movemask, so keep bit (i % 8) of each 0x00/0xFF lane and add up each half (the bits are distinct, no carries)
+    static const u8 LaneBits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t Bits = vandq_u8(Matches, vld1q_u8(LaneBits));
+    u32 Result = u32(vaddv_u8(vget_low_u8(Bits))) | (u32(vaddv_u8(vget_high_u8(Bits))) << 8);
+    return Result;
+}
+
+inline u32 HashMapGroupMatch(const u8* Ctrl, u8 Hash)
+{
+    return HashMapNeonMask_(vceqq_u8(vld1q_u8(Ctrl), vdupq_n_u8(Hash)));
+}
+
+inline u32 HashMapGroupMatchEmpty(const u8* Ctrl)
+{
+    return HashMapGroupMatch(Ctrl, HASH_MAP_CTRL_EMPTY);
+}
+
+inline u32 HashMapGroupMatchFree(const u8* Ctrl)
+{
+    // NOTE: Empty and deleted both have the top bit set, the arithmetic shift spreads it over the lane
+    return HashMapNeonMask_(vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(vld1q_u8(Ctrl)), 7)));
+}
+
+#else
+
+inline u32 HashMapGroupMatch(const u8* Ctrl, u8 Hash)
+{
+    u32 Result = 0;
+    for (u32 SlotId = 0; SlotId < HASH_MAP_GROUP_WIDTH; ++SlotId)
+    {
+        Result |= u32(Ctrl[SlotId] == Hash) << SlotId;
+    }
+    return Result;
+}
+
+inline u32 HashMapGroupMatchEmpty(const u8* Ctrl)
+{
+    return HashMapGroupMatch(Ctrl, HASH_MAP_CTRL_EMPTY);
+}
+
+inline u32 HashMapGroupMatchFree(const u8* Ctrl)
+{
+    u32 Result = 0;
+    for (u32 SlotId = 0; SlotId < HASH_MAP_GROUP_WIDTH; ++SlotId)
+    {
+        Result |= u32(Ctrl[SlotId] >> 7) << SlotId;
+    }
+    return Result;
+}
+
+#endif
+
+//
+// NOTE: Hash Map
+//
+
+template<typename key, typename value, typename arena>
+inline void HashMapAllocate(hash_map<key, value, arena>* Map, mm Capacity)
+{
+    // NOTE: Control bytes, keys and values all come out of one push
+    mm KeysOffset = AlignAddress(u64(Capacity), u64(alignof(key)));
+    mm ValuesOffset = AlignAddress(u64(KeysOffset + sizeof(key)*Capacity), u64(alignof(value)));
+    mm Size = ValuesOffset + sizeof(value)*Capacity;
+    mm Alignment = Max(mm(HASH_MAP_GROUP_WIDTH), Max(mm(alignof(key)), mm(alignof(value))));
+
+    u8* Mem = (u8*)PushSizeAligned(Map->Arena, Size, Alignment);
+    memset(Mem, HASH_MAP_CTRL_EMPTY, Capacity);
+    Map->Ctrl = Mem;
+    Map->Keys = (key*)(Mem + KeysOffset);
+    Map->Values = (value*)(Mem + ValuesOffset);
+    Map->Capacity = Capacity;
+    Map->NumDeleted = 0;
+}
+
+template<typename key, typename value, typename arena>
+inline mm HashMapFindFreeSlot(hash_map<key, value, arena>* Map, u64 Hash)
+{
+    mm NumGroups = Map->Capacity / HASH_MAP_GROUP_WIDTH;
+    mm GroupId = (Hash >> 7) & (NumGroups - 1);
+    for (mm ProbeId = 0;; ++ProbeId)
+    {
+        u32 Free = HashMapGroupMatchFree(Map->Ctrl + GroupId*HASH_MAP_GROUP_WIDTH);
+        if (Free)
+        {
+            mm Result = GroupId*HASH_MAP_GROUP_WIDTH + HashMapTrailingZeros(Free);
+            return Result;
+        }
+        GroupId = (GroupId + ProbeId + 1) & (NumGroups - 1);
+    }
+}
+
+template<typename key, typename value, typename arena>
+inline void HashMapRehash(hash_map<key, value, arena>* Map, mm NewCapacity)
+{
+    hash_map<key, value, arena> OldMap = *Map;
+    HashMapAllocate(Map, NewCapacity);
+
+    for (mm SlotId = 0; SlotId < OldMap.Capacity; ++SlotId)
+    {
+        if (!(OldMap.Ctrl[SlotId] & 0x80))
+        {
+            u64 Hash = HashMapHash(OldMap.Keys[SlotId]);
+            mm NewSlotId = HashMapFindFreeSlot(Map, Hash);
+            Map->Ctrl[NewSlotId] = u8(Hash & 0x7F);
+            Map->Keys[NewSlotId] = OldMap.Keys[SlotId];
+            Map->Values[NewSlotId] = OldMap.Values[SlotId];
+        }
+    }
+}
+
+template<typename key, typename value, typename arena>
+inline hash_map<key, value, arena> HashMapCreate(arena* Arena, mm NumElements = 0)
+{
+    // NOTE: Sized so NumElements fit without growing
+    hash_map<key, value, arena> Result = {};
+    Result.Arena = Arena;
+
+    mm Capacity = HASH_MAP_GROUP_WIDTH;
+    while (Capacity*HASH_MAP_MAX_LOAD_NUMERATOR / HASH_MAP_MAX_LOAD_DENOMINATOR < NumElements)
+    {
+        Capacity *= 2;
+    }
+    HashMapAllocate(&Result, Capacity);
+
+    return Result;
+}
+
+template<typename key, typename value, typename arena>
+inline value* HashMapFind(hash_map<key, value, arena>* Map, const key& Key)
+{
+    value* Result = 0;
+
+    u64 Hash = HashMapHash(Key);
+    u8 Hash7 = u8(Hash & 0x7F);
+    mm NumGroups = Map->Capacity / HASH_MAP_GROUP_WIDTH;
+    mm GroupId = (Hash >> 7) & (NumGroups - 1);
+    for (mm ProbeId = 0; ProbeId < NumGroups; ++ProbeId)
+    {
+        const u8* Ctrl = Map->Ctrl + GroupId*HASH_MAP_GROUP_WIDTH;
+        for (u32 Match = HashMapGroupMatch(Ctrl, Hash7); Match; Match &= Match - 1)
+        {
+            mm SlotId = GroupId*HASH_MAP_GROUP_WIDTH + HashMapTrailingZeros(Match);
+            if (Map->Keys[SlotId] == Key)
+            {
+                Result = Map->Values + SlotId;
+                return Result;
+            }
+        }
+
+        if (HashMapGroupMatchEmpty(Ctrl))
+        {
+            // NOTE: Inserts fill the first free slot on the probe path, so an empty slot ends the search
+            break;
+        }
+        GroupId = (GroupId + ProbeId + 1) & (NumGroups - 1);
+    }
+
+    return Result;
+}
+
+template<typename key, typename value, typename arena>
+inline value* HashMapInsert(hash_map<key, value, arena>* Map, const key& Key, const value& Value)
+{
+    // NOTE: Overwrites the value if the key is already in the map
+    value* Result = HashMapFind(Map, Key);
+    if (Result)
+    {
+        *Result = Value;
+        return Result;
+    }
+
+    if ((Map->NumElements + Map->NumDeleted + 1)*HASH_MAP_MAX_LOAD_DENOMINATOR > Map->Capacity*HASH_MAP_MAX_LOAD_NUMERATOR)
+    {
+        // NOTE: Mostly tombstones means rehashing in place is enough, otherwise double
+        mm NewCapacity = Map->NumDeleted >= Map->NumElements ? Map->Capacity : Map->Capacity*2;
+        HashMapRehash(Map, NewCapacity);
+    }
+
+    u64 Hash = HashMapHash(Key);
+    mm SlotId = HashMapFindFreeSlot(Map, Hash);
+    if (Map->Ctrl[SlotId] == HASH_MAP_CTRL_DELETED)
+    {
+        Map->NumDeleted -= 1;
+    }
+    Map->Ctrl[SlotId] = u8(Hash & 0x7F);
+    Map->Keys[SlotId] = Key;
+    Map->Values[SlotId] = Value;
+    Map->NumElements += 1;
+
+    Result = Map->Values + SlotId;
+    return Result;
+}
+
+template<typename key, typename value, typename arena>
+inline b32 HashMapRemove(hash_map<key, value, arena>* Map, const key& Key)
+{
+    value* Value = HashMapFind(Map, Key);
+    b32 Result = Value != 0;
+    if (Result)
+    {
+        mm SlotId = mm(Value - Map->Values);
+        u8* GroupCtrl = Map->Ctrl + (SlotId & ~mm(HASH_MAP_GROUP_WIDTH - 1));
+        if (HashMapGroupMatchEmpty(GroupCtrl))
+        {
+            // NOTE: Probes stop at this group anyways, so nothing past it can depend on this slot being taken
+            Map->Ctrl[SlotId] = HASH_MAP_CTRL_EMPTY;
+        }
+        else
+        {
+            Map->Ctrl[SlotId] = HASH_MAP_CTRL_DELETED;
+            Map->NumDeleted += 1;
+        }
+        Map->NumElements -= 1;
+    }
+
+    return Result;
+}
+
+template<typename key, typename value, typename arena, typename func>
+inline void HashMapForEach(hash_map<key, value, arena>* Map, func&& Func)
+{
+    // NOTE: Func(const key& Key, value& Value) for every element, in no particular order
+    for (mm GroupStart = 0; GroupStart < Map->Capacity; GroupStart += HASH_MAP_GROUP_WIDTH)
+    {
+        u32 Full = ~HashMapGroupMatchFree(Map->Ctrl + GroupStart);
+#if HASH_MAP_GROUP_WIDTH < 32
+        Full &= (1u << HASH_MAP_GROUP_WIDTH) - 1;
+#endif
+        for (; Full; Full &= Full - 1)
+        {
+            mm SlotId = GroupStart + HashMapTrailingZeros(Full);
+            Func((const key&)Map->Keys[SlotId], Map->Values[SlotId]);
+        }
+    }
+}
+
+template<typename key, typename value, typename arena>
+inline void HashMapClear(hash_map<key, value, arena>* Map)
+{
+    // NOTE: Keeps the table, only empties it
+    memset(Map->Ctrl, HASH_MAP_CTRL_EMPTY, Map->Capacity);
+    Map->NumElements = 0;
+    Map->NumDeleted = 0;
+}
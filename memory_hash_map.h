@@ -0,0 +1,37 @@
+#pragma once
+
+//
+// NOTE: Hash Map
+//
+
+/*
+
+  NOTE: Open addressing hash map in the style of swiss tables. Next to the key and value arrays we keep one control byte per slot: the
+  top bit marks empty/deleted slots and full slots store 7 bits of the hash. Lookups load a whole group of control bytes at once and
+  compare them against the hash bits with SIMD (16 byte SSE2 or NEON groups, 32 byte groups when compiled with AVX2), so we only touch
+  keys that very likely match. Groups are probed with triangular steps which visits every group for power of 2 group counts.
+
+  All storage comes from the arena in one push. Growing pushes a table twice the size and rehashes into it, the old table stays in the
+  arena until it gets cleared, the same as any other arena memory. So a map made inside BeginTempMem/EndTempMem costs nothing to
+  throw away, EndTempMem frees it along with everything else.
+
+  Keys are compared with == and hashed with HashMapHash, overload it for your own key types (the default hashes the raw bytes of the
+  key, so it is only right for keys without padding or pointers to data). Keys and values are moved around with plain assignment.
+
+ */
+
+#define HASH_MAP_CTRL_EMPTY u8(0x80)
+#define HASH_MAP_CTRL_DELETED u8(0xFE)
+
+template<typename key, typename value, typename arena>
+struct hash_map
+{
+    arena* Arena;
+    u8* Ctrl;
+    key* Keys;
+    value* Values;
+
+    mm Capacity; // NOTE: Power of 2, at least one group
+    mm NumElements;
+    mm NumDeleted;
+};
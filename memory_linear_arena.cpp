@@ -3,24 +3,115 @@
 // NOTE: Linear arena
 //
 
-inline linear_arena LinearArenaCreate(void* Mem, mm Size)
+inline linear_arena LinearArenaCreate(void* Mem, mm Size, u32 ArenaFlags = 0)
 {
     linear_arena Result = {};
     Result.Size = Size;
     Result.Used = 0;
     Result.Mem = (u8*)Mem;
+    Result.ArenaFlags = ArenaFlags;
     
     return Result;
 }
 
+/*
+
+  NOTE: A reserved linear arena grabs a large range of address space up front and only commits pages as Used grows past Size. Memory
+  never moves and never gets chained so pointers stay stable and everything is contiguous. If DecommitThreshold is set, clearing or
+  ending a temp mem gives pages back to the OS once more than DecommitThreshold bytes are committed past Used.
+  
+ */
+
+inline linear_arena LinearArenaReserve(mm ReservedSize, mm CommitSize = KiloBytes(64), mm DecommitThreshold = 0, u32 Flags = 0,
+                                       u32 ArenaFlags = 0)
+{
+    linear_arena Result = {};
+    Result.Flags = Flags;
+    Result.ArenaFlags = ArenaFlags;
+    Result.ReservedSize = MemoryGetAllocSize(ReservedSize, Flags);
+    Result.CommitSize = MemoryGetAllocSize(CommitSize, Flags);
+    Result.DecommitThreshold = DecommitThreshold;
+    Result.Mem = (u8*)MemoryReserve(Result.ReservedSize, Flags);
+    Assert(Result.Mem);
+    
+    return Result;
+}
+
+inline void LinearArenaRelease(linear_arena* Arena)
+{
+    // NOTE: File backed arenas get closed with LinearArenaFileClose
+    Assert(Arena->ReservedSize && !Arena->File);
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordCommit(Arena, DebugArenaType_Linear, -i64(Arena->Size));
+    DebugRecordRelease(Arena);
+#endif
+    MemoryRelease(Arena->Mem, Arena->ReservedSize, Arena->Flags);
+    *Arena = {};
+}
+
+inline b32 LinearArenaCommit(linear_arena* Arena, mm NewUsed)
+{
+    // NOTE: Slow path of push, commit enough chunks to fit NewUsed. Returns false if the arena is out of space (or isn't reserved) or
+    // the OS didn't give us the pages, Size stays what it was
+    if (!Arena->ReservedSize || NewUsed > Arena->ReservedSize)
+    {
+        return false;
+    }
+    
+    mm NewSize = ((NewUsed + Arena->CommitSize - 1) / Arena->CommitSize) * Arena->CommitSize;
+    NewSize = Min(NewSize, Arena->ReservedSize);
+    b32 Committed = false;
+    if (Arena->File)
+    {
+        Committed = MemoryFileSetSize(Arena->File, Arena->FileHeaderSize + NewSize);
+    }
+    else
+    {
+        Committed = MemoryCommit(Arena->Mem + Arena->Size, NewSize - Arena->Size);
+    }
+    if (!Committed)
+    {
+        return false;
+    }
+    
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordCommit(Arena, DebugArenaType_Linear, i64(NewSize - Arena->Size));
+#endif
+    // NOTE: Concurrent pushes check Size without the lock
+    AtomicStoreU64((volatile u64*)&Arena->Size, NewSize);
+
+    return true;
+}
+
+inline void LinearArenaDecommit(linear_arena* Arena)
+{
+    // NOTE: Keep the chunk we are in and give back everything past it. Used can sit past Size after a failed concurrent push
+    if (Arena->DecommitThreshold && Arena->Size > Arena->Used && (Arena->Size - Arena->Used) > Arena->DecommitThreshold)
+    {
+        mm NewSize = ((Arena->Used + Arena->CommitSize - 1) / Arena->CommitSize) * Arena->CommitSize;
+        if (MemoryDecommit(Arena->Mem + NewSize, Arena->Size - NewSize))
+        {
+#if DEBUG_MEMORY_PROFILING
+            DebugRecordCommit(Arena, DebugArenaType_Linear, -i64(Arena->Size - NewSize));
+#endif
+            Arena->Size = NewSize;
+        }
+    }
+}
+
 inline void LinearArenaClear(linear_arena* Arena)
 {
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordClear(Arena, DebugArenaType_Linear, DEBUG_MEMORY_CALL_SITE);
+#endif
     Arena->Used = 0;
+    LinearArenaDecommit(Arena);
 }
 
 inline mm LinearArenaGetRemainingSize(linear_arena* Arena)
 {
-    mm Result = Arena->Size - Arena->Used;
+    mm TotalSize = Arena->ReservedSize ? Arena->ReservedSize : Arena->Size;
+    mm Result = TotalSize - Arena->Used;
     return Result;
 }
 
@@ -37,51 +128,250 @@ inline temp_mem BeginTempMem(linear_arena* Arena)
 
 inline void EndTempMem(temp_mem TempMem)
 {
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordFree(TempMem.Arena, DebugArenaType_Linear, TempMem.Arena->Used - TempMem.Used, DEBUG_MEMORY_CALL_SITE);
+#endif
     TempMem.Arena->Used = TempMem.Used;
+    LinearArenaDecommit(TempMem.Arena);
+}
+
+/*
+
+  NOTE: In concurrent mode many threads can push onto the same arena. A push is a single atomic add on Used that reserves Size plus
+  the worst case alignment padding (so pushes with an Alignment of 1 waste nothing). Reserved arenas commit pages under a spin lock
+  when a push crosses the committed size, pushes below it never wait. Threads pushing lots of small things should reserve private
+  chunks through an arena_producer to stay off the shared counter.
+
+  Temp mem, clear and decommit don't synchronize with pushes, call them once the producers are done.
+  
+ */
+
+inline void* PushSizeAlignedConcurrent(linear_arena* Arena, mm Size, mm Alignment)
+{
+    mm PaddedSize = Size + Alignment - 1;
+    mm Offset = mm(AtomicAddU64((volatile u64*)&Arena->Used, PaddedSize));
+    mm End = Offset + PaddedSize;
+    if (End > mm(AtomicLoadU64((volatile u64*)&Arena->Size)))
+    {
+        SpinLockAcquire(&Arena->Lock);
+        b32 Committed = End <= Arena->Size || LinearArenaCommit(Arena, End);
+        SpinLockRelease(&Arena->Lock);
+
+        if (!Committed)
+        {
+            // NOTE: Give our range back if nobody pushed after us, otherwise it is lost. Either way pull Used back to the end of the
+            // arena, only pushes that are going to fail can own anything past it and clear/decommit expect Used <= the arena size
+            volatile u64* Used = (volatile u64*)&Arena->Used;
+            AtomicCompareExchangeU64(Used, End, Offset);
+            
+            u64 Limit = Arena->ReservedSize ? Arena->ReservedSize : Arena->Size;
+            u64 OldUsed = AtomicLoadU64(Used);
+            while (OldUsed > Limit)
+            {
+                u64 PrevUsed = AtomicCompareExchangeU64(Used, OldUsed, Limit);
+                if (PrevUsed == OldUsed)
+                {
+                    break;
+                }
+                OldUsed = PrevUsed;
+            }
+            return 0;
+        }
+    }
+
+    void* Result = Arena->Mem + AlignAddress(Offset, Alignment);
+
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordAllocation(Arena, DebugArenaType_Linear, Size, Alignment, i64(PaddedSize), DEBUG_MEMORY_CALL_SITE);
+#endif
+    
+    return Result;
 }
 
 inline void* PushSizeAligned(linear_arena* Arena, mm Size, mm Alignment)
 {
+    if (Arena->ArenaFlags & LinearArenaFlag_Concurrent)
+    {
+        return PushSizeAlignedConcurrent(Arena, Size, Alignment);
+    }
+    
     // IMPORTANT: Default Alignment = 4 since ARM requires it
     // IMPORTANT: Its assumed the memory in this allocator is aligned to the highest alignment we will need
     // so we align from the front
+#if DEBUG_MEMORY_PROFILING
+    mm OldUsed = Arena->Used;
+#endif
     mm AlignedOffset = AlignAddress(Arena->Used, Alignment);
+    if ((AlignedOffset + Size) > Arena->Size && !LinearArenaCommit(Arena, AlignedOffset + Size))
+    {
+        // NOTE: Out of reserved space or the OS is out of memory, leave the arena as it was
+        return 0;
+    }
     
-    Assert((AlignedOffset + Size) <= Arena->Size);
     void* Result = Arena->Mem + AlignedOffset;
     Arena->Used = AlignedOffset + Size;
 
 #if DEBUG_MEMORY_PROFILING
-    DebugRecordAllocation(Arena);
+    DebugRecordAllocation(Arena, DebugArenaType_Linear, Size, Alignment, i64(Arena->Used - OldUsed), DEBUG_MEMORY_CALL_SITE);
 #endif
     
     return Result;
 }
 
-#define PushString(Arena, String) PushStringAligned(Arena, String, 1)
-inline char* PushStringAligned(linear_arena* Arena, char* String, mm Alignment)
+/*
+
+  NOTE: A file backed linear arena reserves ReservedSize bytes of a shared mapping of a file and grows the file in CommitSize chunks
+  as we push. Saving is a sync of the dirty pages and opening maps the file again, so a warm start only faults in the pages it ends up
+  reading instead of rebuilding the data. The file can map at a different address each run so everything stored in it has to point
+  through rel_ptr/rel_array (or offsets), never raw pointers. Set a root object with LinearArenaFileSetRoot to find the data again
+  after opening.
+
+  The file starts with a linear_arena_file_header, padded to a page, that stays in front of Mem so clearing the arena never touches it.
+  
+ */
+
+inline linear_arena_file_header* LinearArenaFileGetHeader(linear_arena* Arena)
 {
-    char* Result = 0;
+    Assert(Arena->File);
+    linear_arena_file_header* Result = (linear_arena_file_header*)(Arena->Mem - Arena->FileHeaderSize);
+    return Result;
+}
+
+inline linear_arena LinearArenaFileMap_(u64 File, mm HeaderSize, mm ReservedSize, mm CommitSize)
+{
+    linear_arena Result = {};
+    Result.ReservedSize = MemoryGetAllocSize(ReservedSize, 0);
+    Result.CommitSize = MemoryGetAllocSize(CommitSize, 0);
     
-    mm AlignedOffset = AlignAddress(Arena->Used, Alignment);
-    Assert(AlignedOffset <= Arena->Size);
-    Result = (char*)(Arena->Mem + AlignedOffset);
+    u8* Mem = (u8*)MemoryFileMap(File, HeaderSize + Result.ReservedSize);
+    if (Mem)
+    {
+        Result.Mem = Mem + HeaderSize;
+        Result.File = File;
+        Result.FileHeaderSize = HeaderSize;
+    }
+    else
+    {
+        MemoryFileClose(File);
+    }
+
+    return Result;
+}
 
-    char* SrcChar = String;
-    char* DstChar = Result;
-    while (*SrcChar != 0)
+inline linear_arena LinearArenaFileCreate(const char* Path, mm ReservedSize, mm CommitSize = KiloBytes(64))
+{
+    // NOTE: Creates (or truncates) the file at Path, Result.Mem is 0 if that failed
+    linear_arena Result = {};
+    mm HeaderSize = AlignAddress(u64(sizeof(linear_arena_file_header)), u64(MemoryGetPageSize()));
+    u64 File = MemoryFileOpen(Path, true);
+    if (File && MemoryFileSetSize(File, HeaderSize))
     {
-        *DstChar++ = *SrcChar++;
+        Result = LinearArenaFileMap_(File, HeaderSize, ReservedSize, CommitSize);
+        if (Result.Mem)
+        {
+            linear_arena_file_header* Header = LinearArenaFileGetHeader(&Result);
+            Header->Magic = LINEAR_ARENA_FILE_MAGIC;
+            Header->HeaderSize = HeaderSize;
+        }
     }
-    *DstChar++ = 0;
+    else if (File)
+    {
+        MemoryFileClose(File);
+    }
+
+    return Result;
+}
+
+inline linear_arena LinearArenaFileOpen(const char* Path, mm ReservedSize, mm CommitSize = KiloBytes(64))
+{
+    // NOTE: Maps a file saved with LinearArenaFileSave, Result.Mem is 0 if it is missing or isn't an arena file
+    linear_arena Result = {};
+    u64 File = MemoryFileOpen(Path, false);
+    if (File)
+    {
+        // NOTE: Peek at the header first, we need its size (the page size of the machine that wrote the file) to map the rest
+        mm FileSize = MemoryFileGetSize(File);
+        mm HeaderSize = 0;
+        if (FileSize >= sizeof(linear_arena_file_header))
+        {
+            linear_arena_file_header* Header = (linear_arena_file_header*)MemoryFileMap(File, sizeof(linear_arena_file_header));
+            if (Header)
+            {
+                if (Header->Magic == LINEAR_ARENA_FILE_MAGIC && Header->HeaderSize >= sizeof(linear_arena_file_header) &&
+                    Header->HeaderSize <= FileSize)
+                {
+                    HeaderSize = mm(Header->HeaderSize);
+                }
+                MemoryFileUnmap(Header, sizeof(linear_arena_file_header));
+            }
+        }
+        
+        if (!HeaderSize)
+        {
+            MemoryFileClose(File);
+            return Result;
+        }
+
+        mm Size = FileSize - HeaderSize;
+        Result = LinearArenaFileMap_(File, HeaderSize, Max(ReservedSize, Size), CommitSize);
+        if (Result.Mem)
+        {
+            // NOTE: The pages we just mapped don't get reported to the memory profiler, Result is a local here and would be the wrong
+            // key. LinearArenaFileClose only hands back what the arena reported itself
+            linear_arena_file_header* Header = LinearArenaFileGetHeader(&Result);
+            if (Header->Used <= Size)
+            {
+                Result.Size = Size;
+                Result.Used = Header->Used;
+            }
+            else
+            {
+                MemoryFileUnmap(Header, HeaderSize + Result.ReservedSize);
+                MemoryFileClose(File);
+                Result = {};
+            }
+        }
+    }
+
+    return Result;
+}
 
-    mm StringSize = mm(DstChar - Result);
-    Assert(AlignedOffset + StringSize <= Arena->Size);
-    Arena->Used = AlignedOffset + StringSize;
+inline void LinearArenaFileSetRoot(linear_arena* Arena, void* Root)
+{
+    Assert(!Root || ((u8*)Root >= Arena->Mem && (u8*)Root < Arena->Mem + Arena->Used));
+    LinearArenaFileGetHeader(Arena)->RootOffset = Root ? u64((u8*)Root - Arena->Mem) + 1 : 0;
+}
 
+inline void* LinearArenaFileGetRoot(linear_arena* Arena)
+{
+    u64 RootOffset = LinearArenaFileGetHeader(Arena)->RootOffset;
+    void* Result = RootOffset ? Arena->Mem + (RootOffset - 1) : 0;
     return Result;
 }
 
+inline b32 LinearArenaFileSave(linear_arena* Arena)
+{
+    // NOTE: Everything up to Used (and the root) is on disk once this returns true
+    linear_arena_file_header* Header = LinearArenaFileGetHeader(Arena);
+    Header->Used = Arena->Used;
+    b32 Result = MemoryFileSync(Arena->File, Header, Arena->FileHeaderSize + Arena->Used);
+    return Result;
+}
+
+inline void LinearArenaFileClose(linear_arena* Arena)
+{
+    // NOTE: Doesn't save, pages we dirtied still reach the file eventually but Used in the header only changes on save
+#if DEBUG_MEMORY_PROFILING
+    // NOTE: Opened arenas only reported what they grew by after opening, so give back what the profiler has for us instead of Size
+    debug_arena_stats* Stats = DebugMemoryGetStats(Arena, DebugArenaType_Linear);
+    DebugRecordCommit(Arena, DebugArenaType_Linear, Stats ? -i64(AtomicLoadU64(&Stats->Committed)) : 0);
+    DebugRecordRelease(Arena);
+#endif
+    MemoryFileUnmap(LinearArenaFileGetHeader(Arena), Arena->FileHeaderSize + Arena->ReservedSize);
+    MemoryFileClose(Arena->File);
+    *Arena = {};
+}
+
 inline linear_arena LinearSubArena(linear_arena* Arena, mm Size)
 {
     linear_arena Result = {};
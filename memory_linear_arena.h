@@ -4,11 +4,44 @@
 // NOTE: Linear Arena
 //
 
+enum linear_arena_flags
+{
+    LinearArenaFlag_None = 0,
+    // NOTE: Lets many threads push at once (see PushSizeAlignedConcurrent)
+    LinearArenaFlag_Concurrent = 1 << 0,
+};
+
 struct linear_arena
 {
     mm Size;
     mm Used;
     u8* Mem;
+
+    // NOTE: Only used by reserved arenas, where Size is the committed part of the reservation and grows in CommitSize chunks
+    mm ReservedSize;
+    mm CommitSize;
+    mm DecommitThreshold;
+    u32 Flags;
+
+    // NOTE: Only used by file backed arenas, handle of the file that Mem maps (see LinearArenaFileCreate) and the size of the file
+    // header in front of Mem
+    u64 File;
+    mm FileHeaderSize;
+
+    u32 ArenaFlags;
+    volatile u32 Lock; // NOTE: Concurrent mode, taken to commit more pages
+};
+
+// NOTE: File backed arenas keep this in front of Mem, padded to the page size of the machine that created the file so Mem stays page
+// aligned. The padded size is stored in the header since the file can be opened on a machine with a different page size
+#define LINEAR_ARENA_FILE_MAGIC 0x32414E4552414C4Cull // NOTE: "LLARENA2"
+
+struct linear_arena_file_header
+{
+    u64 Magic;
+    u64 HeaderSize;
+    u64 Used;
+    u64 RootOffset; // NOTE: Offset of the root object from Mem plus one, 0 if no root was set
 };
 
 struct temp_mem
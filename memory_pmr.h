@@ -0,0 +1,225 @@
+#pragma once
+
+//
+// NOTE: Standard Library Adapters
+//
+
+/*
+
+  NOTE: Opt in header, include it after memory.h. It lets standard containers allocate from our arenas, either through
+  std::pmr::memory_resource (arena_memory_resource) or through a classic allocator type (arena_allocator<T, arena>).
+
+  Deallocation is free: if the block being released is the last thing pushed on the arena we rewind the arena over it (so a vector
+  that keeps growing at the top of the arena reuses its old space), otherwise we do nothing and the memory comes back when the arena
+  gets cleared or its temp mem ends. That means containers living inside a BeginTempMem/EndTempMem scope need no destructor calls at
+  all, just make sure nobody touches them after EndTempMem.
+
+  Block arenas can only hand out up to a block at a time, anything bigger goes to the upstream resource (new/delete by default).
+  Linear arenas go upstream once they run out of space, so on release we check whether the address is inside the arena instead of
+  asking again whether the size fits (a fixed arena that filled up since would send arena memory to delete).
+
+ */
+
+#include <memory_resource>
+#include <new>
+
+//
+// NOTE: Rewind helpers, each returns true if Mem was the top allocation of the arena and got released
+//
+
+inline b32 ArenaRewindLast(linear_arena* Arena, void* Mem, mm Size)
+{
+    b32 Result = (u8*)Mem + Size == Arena->Mem + Arena->Used;
+    if (Result)
+    {
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordFree(Arena, DebugArenaType_Linear, Size, DEBUG_MEMORY_CALL_SITE);
+#endif
+        Arena->Used = mm((u8*)Mem - Arena->Mem);
+    }
+
+    return Result;
+}
+
+inline b32 ArenaRewindLast(dynamic_arena* Arena, void* Mem, mm Size)
+{
+    dynamic_arena_header* Header = Arena->Prev;
+    b32 Result = Header && (u8*)Mem + Size == (u8*)Header + Header->Used;
+    if (Result)
+    {
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordFree(Arena, DebugArenaType_Dynamic, Size, DEBUG_MEMORY_CALL_SITE);
+#endif
+        Header->Used = mm((u8*)Mem - (u8*)Header);
+    }
+
+    return Result;
+}
+
+inline b32 ArenaRewindLast(block_arena* Arena, void* Mem, mm Size)
+{
+    block* Block = Arena->Prev;
+    b32 Result = Block && (u8*)Mem + Size == (u8*)Block + Arena->LastBlockUsed;
+    if (Result)
+    {
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordFree(Arena, DebugArenaType_Block, Size, DEBUG_MEMORY_CALL_SITE);
+#endif
+        Arena->LastBlockUsed = mm((u8*)Mem - (u8*)Block);
+    }
+
+    return Result;
+}
+
+inline b32 ArenaCanPush(linear_arena* Arena, mm Size, mm Alignment)
+{
+    // NOTE: Reserved arenas commit on demand, fixed ones can't grow past Size
+    mm Limit = Arena->ReservedSize ? Arena->ReservedSize : Arena->Size;
+    b32 Result = AlignAddress(Arena->Used, Alignment) + Size <= Limit;
+    return Result;
+}
+
+inline b32 ArenaCanPush(dynamic_arena*, mm, mm)
+{
+    return true;
+}
+
+inline b32 ArenaCanPush(block_arena* Arena, mm Size, mm Alignment)
+{
+    // NOTE: Worst case we start a fresh block, which is only aligned to PLATFORM_BLOCK_ALIGNMENT
+    b32 Result = Alignment <= PLATFORM_BLOCK_ALIGNMENT && AlignAddress(u64(sizeof(block)), u64(Alignment)) + Size <= Arena->BlockSpace + sizeof(block);
+    return Result;
+}
+
+//
+// NOTE: Ownership checks for deallocation, true if Mem came from the arena rather than the upstream resource
+//
+
+inline b32 ArenaOwns(linear_arena* Arena, void* Mem, mm, mm)
+{
+    mm Limit = Max(Arena->ReservedSize, Arena->Size);
+    b32 Result = (u8*)Mem >= Arena->Mem && (u8*)Mem < Arena->Mem + Limit;
+    return Result;
+}
+
+inline b32 ArenaOwns(dynamic_arena*, void*, mm, mm)
+{
+    return true;
+}
+
+inline b32 ArenaOwns(block_arena* Arena, void*, mm Size, mm Alignment)
+{
+    // NOTE: Only depends on the block size, so it gives the same answer it gave when we allocated
+    b32 Result = ArenaCanPush(Arena, Size, Alignment);
+    return Result;
+}
+
+//
+// NOTE: std::pmr::memory_resource
+//
+
+template<typename arena>
+class arena_memory_resource : public std::pmr::memory_resource
+{
+public:
+    arena* Arena;
+    std::pmr::memory_resource* Upstream; // NOTE: Gets requests the arena can't serve
+
+    explicit arena_memory_resource(arena* InArena, std::pmr::memory_resource* InUpstream = std::pmr::new_delete_resource())
+        : Arena(InArena), Upstream(InUpstream)
+    {
+    }
+
+protected:
+    void* do_allocate(size_t Bytes, size_t Alignment) override
+    {
+        void* Result = 0;
+        if (ArenaCanPush(Arena, Bytes, Alignment))
+        {
+            Result = PushSizeAligned(Arena, Bytes, Alignment);
+            if (!Result)
+            {
+                // NOTE: The OS couldn't commit more pages
+                throw std::bad_alloc();
+            }
+        }
+        else
+        {
+            Result = Upstream->allocate(Bytes, Alignment);
+        }
+
+        return Result;
+    }
+
+    void do_deallocate(void* Mem, size_t Bytes, size_t Alignment) override
+    {
+        if (ArenaOwns(Arena, Mem, Bytes, Alignment))
+        {
+            ArenaRewindLast(Arena, Mem, Bytes);
+        }
+        else
+        {
+            Upstream->deallocate(Mem, Bytes, Alignment);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& Other) const noexcept override
+    {
+        return this == &Other;
+    }
+};
+
+//
+// NOTE: Classic allocator
+//
+
+template<typename T, typename arena>
+struct arena_allocator
+{
+    using value_type = T;
+
+    arena* Arena;
+
+    arena_allocator(arena* InArena) : Arena(InArena) {}
+
+    template<typename other_type>
+    arena_allocator(const arena_allocator<other_type, arena>& Other) : Arena(Other.Arena) {}
+
+    T* allocate(size_t Count)
+    {
+        mm Size = mm(sizeof(T)*Count);
+        if (!ArenaCanPush(Arena, Size, alignof(T)))
+        {
+            throw std::bad_alloc();
+        }
+        T* Result = (T*)PushSizeAligned(Arena, Size, alignof(T));
+        if (!Result)
+        {
+            throw std::bad_alloc();
+        }
+        return Result;
+    }
+
+    void deallocate(T* Mem, size_t Count)
+    {
+        ArenaRewindLast(Arena, Mem, mm(sizeof(T)*Count));
+    }
+
+    template<typename other_type>
+    struct rebind
+    {
+        using other = arena_allocator<other_type, arena>;
+    };
+};
+
+template<typename T, typename U, typename arena>
+inline bool operator==(const arena_allocator<T, arena>& A, const arena_allocator<U, arena>& B)
+{
+    return A.Arena == B.Arena;
+}
+
+template<typename T, typename U, typename arena>
+inline bool operator!=(const arena_allocator<T, arena>& A, const arena_allocator<U, arena>& B)
+{
+    return A.Arena != B.Arena;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+//
+// NOTE: Relative Pointers
+//
+
+/*
+
+  NOTE: rel_ptr stores the distance from itself to its target instead of an address, so a graph built out of them is position
+  independent and stays valid when the memory holding it gets mapped at a different address (see LinearArenaFileOpen). An offset of
+  0 is the null pointer, which means a zeroed rel_ptr is null and a rel_ptr can't point at itself.
+
+  Since the offset is relative to where the rel_ptr lives, it can't be copied around as raw bytes (Copy, memcpy, hash map rehashes).
+  Assigning one rel_ptr to another re-encodes the target so that is fine. rel_array is a rel_ptr plus a count for arrays.
+
+ */
+
+template<typename T>
+struct rel_ptr
+{
+    i64 Offset;
+
+    rel_ptr() = default;
+    rel_ptr(const rel_ptr& Other) { Set(Other.Get()); }
+    rel_ptr(T* Ptr) { Set(Ptr); }
+
+    inline T* Get() const
+    {
+        T* Result = Offset ? (T*)((u8*)this + Offset) : 0;
+        return Result;
+    }
+
+    inline void Set(T* Ptr)
+    {
+        Offset = Ptr ? i64((u8*)Ptr - (u8*)this) : 0;
+    }
+
+    rel_ptr& operator=(const rel_ptr& Other) { Set(Other.Get()); return *this; }
+    rel_ptr& operator=(T* Ptr) { Set(Ptr); return *this; }
+
+    T* operator->() const { return Get(); }
+    T& operator*() const { return *Get(); }
+    T& operator[](mm Index) const { return Get()[Index]; }
+    operator T*() const { return Get(); }
+};
+
+template<typename T>
+struct rel_array
+{
+    rel_ptr<T> Data;
+    mm Count;
+
+    T& operator[](mm Index) const
+    {
+        Assert(Index < Count);
+        return Data[Index];
+    }
+};
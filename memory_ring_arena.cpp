@@ -0,0 +1,105 @@
+
+//
+// NOTE: Ring Arena
+//
+
+inline ring_arena RingArenaCreate(mm MinSize, u32 ArenaFlags = 0)
+{
+    // NOTE: Rounds up to a power of 2 that the OS can mirror
+    mm Size = MemoryGetMirrorGranularity();
+    while (Size < MinSize)
+    {
+        Size *= 2;
+    }
+
+    ring_arena Result = {};
+    Result.Mem = (u8*)MemoryMapMirrored(Size);
+    Assert(Result.Mem);
+    Result.Size = Size;
+    Result.Mask = Size - 1;
+    Result.ArenaFlags = ArenaFlags;
+
+    return Result;
+}
+
+inline void RingArenaRelease(ring_arena* Arena)
+{
+    MemoryUnmapMirrored(Arena->Mem, Arena->Size);
+    *Arena = {};
+}
+
+inline ring_write RingArenaBeginWrite(ring_arena* Arena, mm Size)
+{
+    Assert(Size <= Arena->Size);
+    ring_write Result = {};
+    Result.Size = Size;
+
+    if (Arena->ArenaFlags & RingArenaFlag_MultiProducer)
+    {
+        u64 Pos = AtomicLoadU64(&Arena->WritePos);
+        while (Pos + Size - AtomicLoadU64(&Arena->ReadPos) <= Arena->Size)
+        {
+            u64 SeenPos = AtomicCompareExchangeU64(&Arena->WritePos, Pos, Pos + Size);
+            if (SeenPos == Pos)
+            {
+                Result.Mem = Arena->Mem + (Pos & Arena->Mask);
+                Result.Pos = Pos;
+                break;
+            }
+            Pos = SeenPos;
+        }
+    }
+    else
+    {
+        // NOTE: Only we write WritePos, the consumer only ever frees up more room
+        u64 Pos = Arena->WritePos;
+        if (Pos + Size - AtomicLoadU64(&Arena->ReadPos) <= Arena->Size)
+        {
+            Arena->WritePos = Pos + Size;
+            Result.Mem = Arena->Mem + (Pos & Arena->Mask);
+            Result.Pos = Pos;
+        }
+    }
+
+    return Result;
+}
+
+inline void RingArenaEndWrite(ring_arena* Arena, ring_write Write)
+{
+    Assert(Write.Mem);
+    u64 EndPos = Write.Pos + Write.Size;
+    if (Arena->ArenaFlags & RingArenaFlag_MultiProducer)
+    {
+        // NOTE: Publish in order, the consumer can't skip over bytes an earlier producer is still writing
+        Assert(EndPos <= AtomicLoadU64(&Arena->WritePos));
+        while (AtomicLoadU64(&Arena->CommitPos) != Write.Pos)
+        {
+            AtomicPause();
+        }
+    }
+    else
+    {
+        // NOTE: Write.Size can shrink between begin and end, give the rest of the reservation back
+        Assert(EndPos <= Arena->WritePos);
+        Arena->WritePos = EndPos;
+    }
+    
+    AtomicStoreU64(&Arena->CommitPos, EndPos);
+}
+
+inline ring_read RingArenaBeginRead(ring_arena* Arena)
+{
+    ring_read Result = {};
+    Result.Pos = Arena->ReadPos;
+    Result.Mem = Arena->Mem + (Result.Pos & Arena->Mask);
+    Result.Size = mm(AtomicLoadU64(&Arena->CommitPos) - Result.Pos);
+
+    return Result;
+}
+
+inline void RingArenaEndRead(ring_arena* Arena, mm ConsumedSize)
+{
+    // NOTE: Consume less than BeginRead returned to keep a partial record around until more of it arrives
+    Assert(ConsumedSize <= AtomicLoadU64(&Arena->CommitPos) - Arena->ReadPos);
+    AtomicStoreU64(&Arena->ReadPos, Arena->ReadPos + ConsumedSize);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+//
+// NOTE: Ring Arena
+//
+
+/*
+
+  NOTE: A FIFO byte buffer for streaming data between a producer and a consumer (reads -> parse -> process). The backing pages are
+  mapped twice back to back (MemoryMapMirrored), so a record that runs past the end of the buffer continues in the mirror and every
+  write and read is one contiguous range. Parsers read records in place, nothing ever gets copied to undo a wrap.
+
+  Positions are absolute byte counts that only grow, the offset into the buffer is Pos & Mask. Producers go BeginWrite -> fill ->
+  EndWrite and the consumer goes BeginRead -> parse -> EndRead. BeginWrite returns a null Mem when the buffer doesn't have room yet
+  and BeginRead returns Size 0 when nothing got committed, callers decide whether to spin, sleep or do other work.
+
+  By default there is one producer and one consumer (SPSC), which only needs a load and a store of each position. In single
+  producer mode EndWrite can commit less than BeginWrite reserved (a socket read that came back short). RingArenaFlag_MultiProducer
+  lets many threads write (MPSC): reserving is a compare exchange on the write position and commits are published in order, so
+  EndWrite waits for producers that reserved before it to commit first. Keep the time between BeginWrite and EndWrite short.
+  
+ */
+
+#define RING_ARENA_CACHE_LINE_SIZE 64
+
+enum ring_arena_flags
+{
+    RingArenaFlag_None = 0,
+    // NOTE: Many producers can write at once (see RingArenaBeginWrite)
+    RingArenaFlag_MultiProducer = 1 << 0,
+};
+
+struct alignas(RING_ARENA_CACHE_LINE_SIZE) ring_arena
+{
+    u8* Mem; // NOTE: Mapped twice, Mem[Size + i] is Mem[i]
+    mm Size; // NOTE: Power of 2
+    mm Mask;
+    u32 ArenaFlags;
+
+    // NOTE: Every position sits on its own cache line. Producers reserving through WritePos don't invalidate the CommitPos line the
+    // consumer polls, and the consumer bumping ReadPos doesn't invalidate either of them
+    alignas(RING_ARENA_CACHE_LINE_SIZE) volatile u64 WritePos; // NOTE: End of the reserved bytes
+    alignas(RING_ARENA_CACHE_LINE_SIZE) volatile u64 CommitPos; // NOTE: End of the bytes the consumer can read
+    alignas(RING_ARENA_CACHE_LINE_SIZE) volatile u64 ReadPos; // NOTE: End of the consumed bytes, producers can't write past ReadPos + Size
+};
+
+struct ring_write
+{
+    u8* Mem; // NOTE: 0 if the buffer was full
+    u64 Pos;
+    mm Size;
+};
+
+struct ring_read
+{
+    u8* Mem;
+    u64 Pos;
+    mm Size; // NOTE: Everything committed that we haven't consumed, 0 if the buffer is empty
+};
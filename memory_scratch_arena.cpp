@@ -0,0 +1,87 @@
+//
+// NOTE: Scratch Arena
+//
+
+static thread_local linear_arena ScratchArenas[MEMORY_SCRATCH_ARENA_COUNT];
+
+inline scratch_mem::scratch_mem(temp_mem InTempMem)
+{
+    Arena = InTempMem.Arena;
+    TempMem = InTempMem;
+}
+
+inline scratch_mem::scratch_mem(scratch_mem&& Other)
+{
+    Arena = Other.Arena;
+    TempMem = Other.TempMem;
+    Other.Arena = 0;
+}
+
+inline scratch_mem::~scratch_mem()
+{
+    if (Arena)
+    {
+        EndTempMem(TempMem);
+    }
+}
+
+inline scratch_mem GetScratch(linear_arena** Conflicts, u32 NumConflicts)
+{
+    linear_arena* Result = 0;
+    for (u32 ArenaId = 0; ArenaId < MEMORY_SCRATCH_ARENA_COUNT && !Result; ++ArenaId)
+    {
+        linear_arena* Arena = ScratchArenas + ArenaId;
+
+        b32 HasConflict = false;
+        for (u32 ConflictId = 0; ConflictId < NumConflicts; ++ConflictId)
+        {
+            if (Conflicts[ConflictId] == Arena)
+            {
+                HasConflict = true;
+                break;
+            }
+        }
+
+        if (!HasConflict)
+        {
+            Result = Arena;
+        }
+    }
+
+    // NOTE: Raise MEMORY_SCRATCH_ARENA_COUNT if a function needs more output arenas than that
+    Assert(Result);
+    if (!Result->Mem)
+    {
+        *Result = LinearArenaReserve(MEMORY_SCRATCH_RESERVE_SIZE);
+    }
+
+    return scratch_mem(BeginTempMem(Result));
+}
+
+inline scratch_mem GetScratch()
+{
+    return GetScratch((linear_arena**)0, u32(0));
+}
+
+inline scratch_mem GetScratch(linear_arena* Conflict)
+{
+    return GetScratch(&Conflict, 1);
+}
+
+inline scratch_mem GetScratch(linear_arena* Conflict0, linear_arena* Conflict1)
+{
+    linear_arena* Conflicts[] = { Conflict0, Conflict1 };
+    return GetScratch(Conflicts, ArrayCount(Conflicts));
+}
+
+inline void ScratchArenasRelease()
+{
+    // NOTE: Call before a thread exits to give its scratch reservations back to the OS
+    for (u32 ArenaId = 0; ArenaId < MEMORY_SCRATCH_ARENA_COUNT; ++ArenaId)
+    {
+        if (ScratchArenas[ArenaId].Mem)
+        {
+            LinearArenaRelease(ScratchArenas + ArenaId);
+        }
+    }
+}
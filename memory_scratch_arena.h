@@ -0,0 +1,38 @@
+#pragma once
+
+//
+// NOTE: Scratch Arena
+//
+
+/*
+
+  NOTE: Every thread gets a small pool of reserved linear arenas for short lived memory. GetScratch takes the arenas the caller is
+  allocating its results into (conflicts) and returns a temp mem on a pool arena that isn't one of them, so a function that gets
+  scratch memory from the same pool as its caller can never free the callers results. The returned scratch_mem ends the temp mem
+  when it goes out of scope.
+
+  Arenas get reserved the first time a thread asks for scratch memory and keep their committed pages afterwards, so in steady state
+  getting scratch memory never calls the OS or takes a lock.
+  
+ */
+
+#ifndef MEMORY_SCRATCH_ARENA_COUNT
+#define MEMORY_SCRATCH_ARENA_COUNT 2
+#endif
+
+#ifndef MEMORY_SCRATCH_RESERVE_SIZE
+#define MEMORY_SCRATCH_RESERVE_SIZE GigaBytes(8)
+#endif
+
+struct scratch_mem
+{
+    linear_arena* Arena;
+    temp_mem TempMem;
+
+    scratch_mem(temp_mem InTempMem);
+    scratch_mem(scratch_mem&& Other);
+    ~scratch_mem();
+    
+    scratch_mem(const scratch_mem&) = delete;
+    scratch_mem& operator=(const scratch_mem&) = delete;
+};
@@ -0,0 +1,257 @@
+//
+// NOTE: Slab Arena
+//
+
+inline mm SlabArenaGetClassSize(u32 ClassId)
+{
+    mm Result = 16;
+    if (ClassId > 0)
+    {
+        // NOTE: Odd classes are 1.5x a power of 2, even classes are the next power of 2
+        mm Log = 4 + (ClassId - 1) / 2;
+        Result = ((ClassId - 1) % 2 == 0) ? (mm(1) << Log) + (mm(1) << (Log - 1)) : (mm(1) << (Log + 1));
+    }
+
+    return Result;
+}
+
+inline u32 SlabArenaGetClassId(mm Size)
+{
+    u32 Result = 0;
+    if (Size > 16)
+    {
+        // NOTE: Log is such that 2^Log < Size <= 2^(Log + 1)
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long Log = 0;
+        _BitScanReverse64(&Log, u64(Size - 1));
+#else
+        u32 Log = 63 - __builtin_clzll(u64(Size - 1));
+#endif
+        mm Half = (mm(1) << Log) + (mm(1) << (Log - 1));
+        Result = 2*(u32(Log) - 4) + 1 + (Size > Half ? 1 : 0);
+    }
+    
+    return Result;
+}
+
+inline mm SlabArenaGetClassAlignment(slab_arena* Arena, u32 ClassId)
+{
+    // NOTE: Objects start on a SLAB_ARENA_DATA_ALIGNMENT boundary so they are aligned to the lowest set bit of their size
+    mm ObjectSize = Arena->Classes[ClassId].ObjectSize;
+    mm Result = Min(ObjectSize & (~ObjectSize + 1), mm(SLAB_ARENA_DATA_ALIGNMENT));
+    return Result;
+}
+
+inline void SlabListRemove(slab_header** List, slab_header* Slab)
+{
+    if (Slab->Prev)
+    {
+        Slab->Prev->Next = Slab->Next;
+    }
+    else
+    {
+        *List = Slab->Next;
+    }
+    if (Slab->Next)
+    {
+        Slab->Next->Prev = Slab->Prev;
+    }
+}
+
+inline void SlabListPush(slab_header** List, slab_header* Slab)
+{
+    Slab->Next = *List;
+    Slab->Prev = 0;
+    if (Slab->Next)
+    {
+        Slab->Next->Prev = Slab;
+    }
+    *List = Slab;
+}
+
+inline slab_arena SlabArenaCreate(platform_block_arena* PlatformArena)
+{
+    Assert(PlatformArena->ArenaFlags & PlatformBlockArenaFlag_Aligned);
+    
+    slab_arena Result = {};
+    Result.PlatformArena = PlatformArena;
+
+    // NOTE: Blocks start on a PLATFORM_BLOCK_ALIGNMENT boundary, so the first object of every slab sits at the same offset right after
+    // the headers rounded up to SLAB_ARENA_DATA_ALIGNMENT
+    static_assert(PLATFORM_BLOCK_ALIGNMENT % SLAB_ARENA_DATA_ALIGNMENT == 0, "Slab data alignment has to divide the block alignment");
+    mm SlabOverhead = AlignAddress(u64(sizeof(block) + sizeof(slab_header)), u64(SLAB_ARENA_DATA_ALIGNMENT));
+    Assert(SlabOverhead < PlatformArena->BlockSize);
+
+    mm SlabSpace = PlatformArena->BlockSize - SlabOverhead;
+    for (u32 ClassId = 0; ClassId < SLAB_ARENA_MAX_CLASSES; ++ClassId)
+    {
+        mm ObjectSize = SlabArenaGetClassSize(ClassId);
+        mm NumObjects = SlabSpace / ObjectSize;
+        if (NumObjects < SLAB_ARENA_MIN_OBJECTS_PER_SLAB)
+        {
+            break;
+        }
+
+        slab_class* Class = Result.Classes + Result.NumClasses++;
+        Class->ObjectSize = ObjectSize;
+        Class->NumObjectsPerSlab = u32(NumObjects);
+    }
+    
+    return Result;
+}
+
+inline mm SlabArenaGetMaxSize(slab_arena* Arena)
+{
+    mm Result = Arena->NumClasses ? Arena->Classes[Arena->NumClasses - 1].ObjectSize : 0;
+    return Result;
+}
+
+inline void* PushSizeAligned(slab_arena* Arena, mm Size, mm Alignment = 4)
+{
+    Assert(Alignment <= SLAB_ARENA_DATA_ALIGNMENT);
+    
+    u32 ClassId = SlabArenaGetClassId(Size);
+    while (ClassId < Arena->NumClasses && SlabArenaGetClassAlignment(Arena, ClassId) < Alignment)
+    {
+        ClassId += 1;
+    }
+    
+    if (ClassId >= Arena->NumClasses)
+    {
+        // NOTE: Bigger than SlabArenaGetMaxSize, these belong in a different arena
+        return 0;
+    }
+
+    slab_class* Class = Arena->Classes + ClassId;
+    slab_header* Slab = Class->PartialSlabs;
+    if (!Slab && Class->EmptySlab)
+    {
+        Slab = Class->EmptySlab;
+        Class->EmptySlab = 0;
+        SlabListPush(&Class->PartialSlabs, Slab);
+    }
+    else if (!Slab)
+    {
+        // NOTE: Grab a new slab, objects get carved lazily so we only touch the pages we hand out
+        block* Block = PlatformBlockArenaAllocate(Arena->PlatformArena);
+        Slab = (slab_header*)(Block + 1);
+        *Slab = {};
+        Slab->NumFree = Class->NumObjectsPerSlab;
+        Slab->ClassId = ClassId;
+        SlabListPush(&Class->PartialSlabs, Slab);
+        
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordCommit(Arena, DebugArenaType_Slab, i64(Arena->PlatformArena->BlockSize));
+#endif
+    }
+
+    void* Result = 0;
+    if (Slab->FreeList)
+    {
+        Result = Slab->FreeList;
+        Slab->FreeList = *(void**)Result;
+    }
+    else
+    {
+        Assert(Slab->NumCarved < Class->NumObjectsPerSlab);
+        u8* Data = (u8*)((block*)Slab - 1) + AlignAddress(u64(sizeof(block) + sizeof(slab_header)), u64(SLAB_ARENA_DATA_ALIGNMENT));
+        Result = Data + Slab->NumCarved*Class->ObjectSize;
+        Slab->NumCarved += 1;
+    }
+    
+    Slab->NumFree -= 1;
+    if (Slab->NumFree == 0)
+    {
+        SlabListRemove(&Class->PartialSlabs, Slab);
+        SlabListPush(&Class->FullSlabs, Slab);
+    }
+
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordAllocation(Arena, DebugArenaType_Slab, Size, Alignment, i64(Class->ObjectSize), DEBUG_MEMORY_CALL_SITE);
+#endif
+
+    return Result;
+}
+
+inline void FreeSize(slab_arena* Arena, void* Mem)
+{
+    if (!Mem)
+    {
+        return;
+    }
+    
+    block* Block = PlatformBlockArenaGetBlock(Arena->PlatformArena, Mem);
+    slab_header* Slab = (slab_header*)(Block + 1);
+    slab_class* Class = Arena->Classes + Slab->ClassId;
+
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordFree(Arena, DebugArenaType_Slab, Class->ObjectSize, DEBUG_MEMORY_CALL_SITE);
+#endif
+    
+    *(void**)Mem = Slab->FreeList;
+    Slab->FreeList = Mem;
+    Slab->NumFree += 1;
+
+    if (Slab->NumFree == Class->NumObjectsPerSlab)
+    {
+        // NOTE: Slab is empty, keep it as the cached slab if we don't have one yet, otherwise give it back to the platform arena
+        SlabListRemove(&Class->PartialSlabs, Slab);
+        if (!Class->EmptySlab)
+        {
+            Slab->Next = 0;
+            Slab->Prev = 0;
+            Class->EmptySlab = Slab;
+        }
+        else
+        {
+            PlatformBlockArenaFree(Arena->PlatformArena, Block);
+        
+#if DEBUG_MEMORY_PROFILING
+            DebugRecordCommit(Arena, DebugArenaType_Slab, -i64(Arena->PlatformArena->BlockSize));
+#endif
+        }
+    }
+    else if (Slab->NumFree == 1)
+    {
+        // NOTE: Slab was full so it goes back on the partial list
+        SlabListRemove(&Class->FullSlabs, Slab);
+        SlabListPush(&Class->PartialSlabs, Slab);
+    }
+}
+
+inline void ArenaClear(slab_arena* Arena)
+{
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordClear(Arena, DebugArenaType_Slab, DEBUG_MEMORY_CALL_SITE);
+#endif
+    
+    // NOTE: Free all our slabs (unless platform arena already cleared)
+    for (u32 ClassId = 0; ClassId < Arena->NumClasses; ++ClassId)
+    {
+        slab_class* Class = Arena->Classes + ClassId;
+        if (Arena->PlatformArena->Next)
+        {
+            slab_header* Lists[] = { Class->PartialSlabs, Class->FullSlabs, Class->EmptySlab };
+            for (u32 ListId = 0; ListId < ArrayCount(Lists); ++ListId)
+            {
+                for (slab_header* Slab = Lists[ListId]; Slab; )
+                {
+                    slab_header* CurrSlab = Slab;
+                    Slab = Slab->Next;
+                    PlatformBlockArenaFree(Arena->PlatformArena, (block*)CurrSlab - 1);
+#if DEBUG_MEMORY_PROFILING
+                    DebugRecordCommit(Arena, DebugArenaType_Slab, -i64(Arena->PlatformArena->BlockSize));
+#endif
+                }
+            }
+        }
+
+        Class->PartialSlabs = 0;
+        Class->FullSlabs = 0;
+        Class->EmptySlab = 0;
+    }
+
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordRelease(Arena);
+#endif
+}
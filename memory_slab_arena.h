@@ -0,0 +1,50 @@
+#pragma once
+
+//
+// NOTE: Slab Arena
+//
+
+/*
+
+  NOTE: Slab arena lets us free individual allocations. Sizes get rounded to a size class (16, 24, 32, 48, 64, 96, ... so every class
+  is a power of 2 or 1.5x one) and every class carves its objects out of blocks (slabs) from a shared platform block arena. Free
+  objects are kept in an intrusive free list per slab so push and free are O(1). Every class keeps its last empty slab around and only
+  gives the next one that empties back to the platform arena, so alloc/free patterns that cross a slab boundary don't trade a block
+  with the platform arena on every call.
+
+  The platform arena has to be created with PlatformBlockArenaFlag_Aligned so that FreeSize can find the slab of a pointer. Pushes
+  bigger than SlabArenaGetMaxSize return 0.
+  
+ */
+
+#define SLAB_ARENA_MAX_CLASSES 48
+#define SLAB_ARENA_MIN_OBJECTS_PER_SLAB 8
+#define SLAB_ARENA_DATA_ALIGNMENT 64
+
+struct slab_header
+{
+    // NOTE: Stored right after the block header, Next/Prev link the slab into its classes partial or full list
+    slab_header* Next;
+    slab_header* Prev;
+
+    void* FreeList;
+    u32 NumFree;
+    u32 NumCarved; // NOTE: Objects past this were never handed out so they aren't on the free list
+    u32 ClassId;
+};
+
+struct slab_class
+{
+    mm ObjectSize;
+    u32 NumObjectsPerSlab;
+    slab_header* PartialSlabs;
+    slab_header* FullSlabs;
+    slab_header* EmptySlab; // NOTE: Cached empty slab, not on either list
+};
+
+struct slab_arena
+{
+    platform_block_arena* PlatformArena;
+    u32 NumClasses;
+    slab_class Classes[SLAB_ARENA_MAX_CLASSES];
+};
@@ -0,0 +1,111 @@
+//
+// NOTE: SoA Array
+//
+
+template<typename... types>
+inline mm SoaGetBlockSize(mm Capacity)
+{
+    mm Result = 0;
+    mm ColumnSizes[] = { AlignAddress(u64(sizeof(types)*Capacity), u64(SOA_ARRAY_COLUMN_ALIGNMENT))... };
+    for (mm ColumnSize : ColumnSizes)
+    {
+        Result += ColumnSize;
+    }
+
+    return Result;
+}
+
+template<typename arena, typename... types>
+inline void SoaReserve(soa_array<arena, types...>* Soa, mm Capacity)
+{
+    if (Capacity <= Soa->Capacity)
+    {
+        return;
+    }
+
+    // NOTE: Carve every column out of a single push, each one padded to keep the next one aligned
+    u8* Block = (u8*)PushSizeAligned(Soa->Arena, SoaGetBlockSize<types...>(Capacity), SOA_ARRAY_COLUMN_ALIGNMENT);
+    mm TypeSizes[] = { sizeof(types)... };
+    for (mm ColumnId = 0; ColumnId < sizeof...(types); ++ColumnId)
+    {
+        if (Soa->NumElements)
+        {
+            Copy(Soa->Columns[ColumnId], Block, TypeSizes[ColumnId]*Soa->NumElements);
+        }
+        Soa->Columns[ColumnId] = Block;
+        Block += AlignAddress(u64(TypeSizes[ColumnId]*Capacity), u64(SOA_ARRAY_COLUMN_ALIGNMENT));
+    }
+    Soa->Capacity = Capacity;
+}
+
+template<typename... types, typename arena>
+inline soa_array<arena, types...> SoaCreate(arena* Arena, mm Capacity = 0)
+{
+    soa_array<arena, types...> Result = {};
+    Result.Arena = Arena;
+    SoaReserve(&Result, Capacity);
+
+    return Result;
+}
+
+template<mm ColumnId, typename arena, typename... types>
+inline typename soa_type_at<ColumnId, types...>::Type* SoaColumn(soa_array<arena, types...>* Soa)
+{
+    // NOTE: Pointer to the first element of a column, always SOA_ARRAY_COLUMN_ALIGNMENT aligned
+    static_assert(ColumnId < sizeof...(types), "SoA column index out of range");
+    auto* Result = (typename soa_type_at<ColumnId, types...>::Type*)Soa->Columns[ColumnId];
+    return Result;
+}
+
+template<mm ColumnId, typename arena, typename... types>
+inline typename soa_type_at<ColumnId, types...>::Type& SoaGet(soa_array<arena, types...>* Soa, mm Index)
+{
+    Assert(Index < Soa->NumElements);
+    return SoaColumn<ColumnId>(Soa)[Index];
+}
+
+template<typename arena, typename... types, mm... ColumnIds>
+inline void SoaStore_(soa_array<arena, types...>* Soa, mm Index, std::index_sequence<ColumnIds...>, const types&... Values)
+{
+    ((((types*)Soa->Columns[ColumnIds])[Index] = Values), ...);
+}
+
+template<typename arena, typename... types>
+inline mm SoaPush(soa_array<arena, types...>* Soa, const types&... Values)
+{
+    // NOTE: Returns the index of the new element
+    if (Soa->NumElements == Soa->Capacity)
+    {
+        SoaReserve(Soa, Soa->Capacity ? Soa->Capacity*2 : 64);
+    }
+
+    mm Result = Soa->NumElements++;
+    SoaStore_(Soa, Result, std::index_sequence_for<types...>{}, Values...);
+
+    return Result;
+}
+
+template<typename arena, typename... types>
+inline void SoaSwapRemove(soa_array<arena, types...>* Soa, mm Index)
+{
+    // NOTE: Moves the last element into Index, doesn't keep the order
+    Assert(Index < Soa->NumElements);
+
+    mm LastIndex = --Soa->NumElements;
+    if (Index != LastIndex)
+    {
+        mm TypeSizes[] = { sizeof(types)... };
+        for (mm ColumnId = 0; ColumnId < sizeof...(types); ++ColumnId)
+        {
+            u8* Column = (u8*)Soa->Columns[ColumnId];
+            Copy(Column + TypeSizes[ColumnId]*LastIndex, Column + TypeSizes[ColumnId]*Index, TypeSizes[ColumnId]);
+        }
+    }
+}
+
+template<typename arena, typename... types>
+inline void SoaClear(soa_array<arena, types...>* Soa)
+{
+    // NOTE: Keeps the columns around for reuse, the memory itself belongs to the arena
+    Soa->NumElements = 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+//
+// NOTE: SoA Array
+//
+
+/*
+
+  NOTE: soa_array<arena, types...> stores one column per type instead of an array of structs, so a loop that reads two fields out of
+  ten only pulls those two columns through the cache. Every column starts on a 64 byte boundary so SIMD kernels can use aligned loads
+  on the column pointers from SoaColumn.
+
+  All columns live in one push from the arena. Growing pushes a new block twice the size and copies the columns over, the old block
+  stays in the arena until it gets cleared (or its temp mem ends), like any other arena memory. Works with any arena that has a
+  PushSizeAligned (linear_arena, dynamic_arena).
+
+  Elements are expected to be trivially copyable since we move them around with Copy.
+
+ */
+
+#include <utility>
+
+#define SOA_ARRAY_COLUMN_ALIGNMENT 64
+
+template<mm Index, typename type, typename... types>
+struct soa_type_at
+{
+    using Type = typename soa_type_at<Index - 1, types...>::Type;
+};
+
+template<typename type, typename... types>
+struct soa_type_at<0, type, types...>
+{
+    using Type = type;
+};
+
+template<typename arena, typename... types>
+struct soa_array
+{
+    static constexpr mm NumColumns = sizeof...(types);
+
+    arena* Arena;
+    void* Columns[sizeof...(types)];
+    mm NumElements;
+    mm Capacity;
+};
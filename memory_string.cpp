@@ -0,0 +1,238 @@
+//
+// NOTE: Strings
+//
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MEMORY_PRINTF_FORMAT(FormatId, ArgsId) __attribute__((format(printf, FormatId, ArgsId)))
+#else
+#define MEMORY_PRINTF_FORMAT(FormatId, ArgsId)
+#endif
+
+inline memory_string MemoryString(const char* Chars, mm Length)
+{
+    memory_string Result = {};
+    Result.Chars = (char*)Chars;
+    Result.Length = Length;
+
+    return Result;
+}
+
+inline memory_string MemoryString(const char* Chars)
+{
+    memory_string Result = MemoryString(Chars, strlen(Chars));
+    return Result;
+}
+
+inline bool operator==(const memory_string& A, const memory_string& B)
+{
+    bool Result = A.Length == B.Length && (A.Chars == B.Chars || memcmp(A.Chars, B.Chars, A.Length) == 0);
+    return Result;
+}
+
+inline bool operator!=(const memory_string& A, const memory_string& B)
+{
+    return !(A == B);
+}
+
+inline u64 HashMapHash(const memory_string& Key)
+{
+    return HashMapHashBytes(Key.Chars, Key.Length);
+}
+
+//
+// NOTE: Push
+//
+
+template<typename arena>
+inline memory_string PushString(arena* Arena, memory_string String)
+{
+    // NOTE: Copies the characters plus a terminating NUL
+    memory_string Result = {};
+    Result.Chars = (char*)PushSizeAligned(Arena, String.Length + 1, 1);
+    Result.Length = String.Length;
+    Copy(String.Chars, Result.Chars, String.Length);
+    Result.Chars[String.Length] = 0;
+
+    return Result;
+}
+
+template<typename arena>
+inline char* PushStringAligned(arena* Arena, const char* String, mm Alignment)
+{
+    mm StringSize = strlen(String) + 1;
+    char* Result = (char*)PushSizeAligned(Arena, StringSize, Alignment);
+    Copy(String, Result, StringSize);
+
+    return Result;
+}
+
+template<typename arena>
+inline char* PushString(arena* Arena, const char* String)
+{
+    return PushStringAligned(Arena, String, 1);
+}
+
+template<typename arena>
+inline char* PushStringPrefixed(arena* Arena, memory_string String)
+{
+    // NOTE: Stores [u32 Length][Chars][NUL] and returns a pointer to Chars, read the length back with StringPrefixedGetLength
+    Assert(String.Length <= 0xFFFFFFFF);
+    u8* Mem = (u8*)PushSizeAligned(Arena, sizeof(u32) + String.Length + 1, alignof(u32));
+    *(u32*)Mem = u32(String.Length);
+    char* Result = (char*)(Mem + sizeof(u32));
+    Copy(String.Chars, Result, String.Length);
+    Result[String.Length] = 0;
+
+    return Result;
+}
+
+inline mm StringPrefixedGetLength(const char* Chars)
+{
+    mm Result = ((const u32*)Chars)[-1];
+    return Result;
+}
+
+inline memory_string StringPrefixedGetString(const char* Chars)
+{
+    memory_string Result = MemoryString(Chars, StringPrefixedGetLength(Chars));
+    return Result;
+}
+
+template<typename arena>
+inline memory_string PushStringFV(arena* Arena, const char* Format, va_list Args)
+{
+    // NOTE: Measure then print, we don't know where the arena will put the string before we push it
+    va_list MeasureArgs;
+    va_copy(MeasureArgs, Args);
+    int Length = vsnprintf(0, 0, Format, MeasureArgs);
+    va_end(MeasureArgs);
+    Assert(Length >= 0);
+
+    memory_string Result = {};
+    Result.Chars = (char*)PushSizeAligned(Arena, mm(Length) + 1, 1);
+    Result.Length = mm(Length);
+    vsnprintf(Result.Chars, mm(Length) + 1, Format, Args);
+
+    return Result;
+}
+
+inline memory_string PushStringFV(linear_arena* Arena, const char* Format, va_list Args)
+{
+    // NOTE: Print straight into the committed tail of the arena, and only measure + push when it didn't fit
+    if (Arena->ArenaFlags & LinearArenaFlag_Concurrent)
+    {
+        // NOTE: Other threads can push into the tail while we print, so measure first like any other arena
+        return PushStringFV<linear_arena>(Arena, Format, Args);
+    }
+
+    memory_string Result = {};
+
+    mm FreeSpace = Arena->Size - Arena->Used;
+    va_list TryArgs;
+    va_copy(TryArgs, Args);
+    int Length = vsnprintf((char*)Arena->Mem + Arena->Used, FreeSpace, Format, TryArgs);
+    va_end(TryArgs);
+    Assert(Length >= 0);
+
+    if (mm(Length) < FreeSpace)
+    {
+        Result.Chars = (char*)PushSizeAligned(Arena, mm(Length) + 1, 1);
+        Result.Length = mm(Length);
+    }
+    else
+    {
+        Result.Chars = (char*)PushSizeAligned(Arena, mm(Length) + 1, 1);
+        Result.Length = mm(Length);
+        vsnprintf(Result.Chars, mm(Length) + 1, Format, Args);
+    }
+
+    return Result;
+}
+
+template<typename arena>
+inline memory_string PushStringF(arena* Arena, const char* Format, ...) MEMORY_PRINTF_FORMAT(2, 3);
+
+template<typename arena>
+inline memory_string PushStringF(arena* Arena, const char* Format, ...)
+{
+    va_list Args;
+    va_start(Args, Format);
+    memory_string Result = PushStringFV(Arena, Format, Args);
+    va_end(Args);
+
+    return Result;
+}
+
+//
+// NOTE: Interning
+//
+
+template<typename arena>
+inline string_intern_table<arena> StringInternTableCreate(arena* Arena, u32 NumStrings = 0)
+{
+    string_intern_table<arena> Result = {};
+    Result.Arena = Arena;
+    Result.Ids = HashMapCreate<memory_string, u32>(Arena, NumStrings);
+    Result.MaxStrings = NumStrings ? NumStrings : 64;
+    Result.Strings = PushArrayAligned(Arena, memory_string, Result.MaxStrings, alignof(memory_string));
+
+    return Result;
+}
+
+template<typename arena>
+inline u32 StringIntern(string_intern_table<arena>* Table, memory_string String)
+{
+    // NOTE: Returns the id of String, copying it into the table the first time we see it
+    u32* Id = HashMapFind(&Table->Ids, String);
+    if (Id)
+    {
+        return *Id;
+    }
+
+    if (Table->NumStrings == Table->MaxStrings)
+    {
+        u32 NewMaxStrings = Table->MaxStrings*2;
+        memory_string* NewStrings = PushArrayAligned(Table->Arena, memory_string, NewMaxStrings, alignof(memory_string));
+        CopyArray(Table->Strings, NewStrings, memory_string, Table->NumStrings);
+        Table->Strings = NewStrings;
+        Table->MaxStrings = NewMaxStrings;
+    }
+
+    u32 Result = Table->NumStrings++;
+    memory_string Interned = PushString(Table->Arena, String);
+    Table->Strings[Result] = Interned;
+    HashMapInsert(&Table->Ids, Interned, Result);
+
+    return Result;
+}
+
+template<typename arena>
+inline u32 StringIntern(string_intern_table<arena>* Table, const char* String)
+{
+    return StringIntern(Table, MemoryString(String));
+}
+
+template<typename arena>
+inline memory_string StringInternGet(string_intern_table<arena>* Table, u32 Id)
+{
+    Assert(Id < Table->NumStrings);
+    memory_string Result = Table->Strings[Id];
+    return Result;
+}
+
+template<typename arena>
+inline b32 StringInternFind(string_intern_table<arena>* Table, memory_string String, u32* Id)
+{
+    // NOTE: Looks up a string without interning it
+    u32* FoundId = HashMapFind(&Table->Ids, String);
+    if (FoundId)
+    {
+        *Id = *FoundId;
+    }
+
+    return FoundId != 0;
+}
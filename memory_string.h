@@ -0,0 +1,35 @@
+#pragma once
+
+//
+// NOTE: Strings
+//
+
+/*
+
+  NOTE: Strings pushed on arenas. memory_string is a view (pointer + length) so copies never have to scan for the terminator and go
+  through the SIMD Copy. Pushed strings still get a NUL after them so they can be handed to C apis. PushStringPrefixed stores the
+  length in front of the characters for places that can only keep a char*.
+
+  string_intern_table hands out one id per distinct string. The first time a string is seen it gets copied into the tables arena,
+  after that interning it again returns the same id and the same characters, so ids and pointers stay valid as long as the arena
+  does and equal strings can be compared by id.
+
+ */
+
+struct memory_string
+{
+    char* Chars;
+    mm Length;
+};
+
+template<typename arena>
+struct string_intern_table
+{
+    arena* Arena;
+    hash_map<memory_string, u32, arena> Ids;
+
+    // NOTE: Interned strings by id, grows by doubling
+    memory_string* Strings;
+    u32 NumStrings;
+    u32 MaxStrings;
+};
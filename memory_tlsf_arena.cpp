@@ -0,0 +1,461 @@
+//
+// NOTE: TLSF Arena
+//
+
+inline u32 TlsfFindLastSet(u64 Value)
+{
+    // NOTE: Index of the highest set bit, Value can't be 0
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long Result = 0;
+    _BitScanReverse64(&Result, Value);
+    return u32(Result);
+#else
+    return 63 - u32(__builtin_clzll(Value));
+#endif
+}
+
+inline u32 TlsfFindFirstSet(u64 Value)
+{
+    // NOTE: Index of the lowest set bit, Value can't be 0
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long Result = 0;
+    _BitScanForward64(&Result, Value);
+    return u32(Result);
+#else
+    return u32(__builtin_ctzll(Value));
+#endif
+}
+
+//
+// NOTE: Block helpers
+//
+
+inline mm TlsfBlockGetSize(tlsf_block* Block)
+{
+    mm Result = Block->Size & TLSF_BLOCK_SIZE_MASK;
+    return Result;
+}
+
+inline void TlsfBlockSetSize(tlsf_block* Block, mm Size)
+{
+    Block->Size = Size | (Block->Size & ~TLSF_BLOCK_SIZE_MASK);
+}
+
+inline void* TlsfBlockGetPayload(tlsf_block* Block)
+{
+    void* Result = (u8*)Block + TLSF_BLOCK_OVERHEAD;
+    return Result;
+}
+
+inline tlsf_block* TlsfBlockFromPayload(void* Mem)
+{
+    tlsf_block* Result = (tlsf_block*)((u8*)Mem - TLSF_BLOCK_OVERHEAD);
+    return Result;
+}
+
+inline tlsf_block* TlsfBlockGetNext(tlsf_block* Block)
+{
+    tlsf_block* Result = (tlsf_block*)((u8*)TlsfBlockGetPayload(Block) + TlsfBlockGetSize(Block));
+    return Result;
+}
+
+inline void TlsfBlockMarkFree(tlsf_block* Block)
+{
+    Block->Size |= TLSF_BLOCK_FREE;
+    tlsf_block* Next = TlsfBlockGetNext(Block);
+    Next->PrevPhysical = Block;
+    Next->Size |= TLSF_BLOCK_PREV_FREE;
+}
+
+inline void TlsfBlockMarkUsed(tlsf_block* Block)
+{
+    Block->Size &= ~mm(TLSF_BLOCK_FREE);
+    TlsfBlockGetNext(Block)->Size &= ~mm(TLSF_BLOCK_PREV_FREE);
+}
+
+//
+// NOTE: Free lists
+//
+
+inline void TlsfMappingInsert(mm Size, u32* Fl, u32* Sl)
+{
+    if (Size < TLSF_SMALL_BLOCK_SIZE)
+    {
+        *Fl = 0;
+        *Sl = u32(Size / (TLSF_SMALL_BLOCK_SIZE / TLSF_SL_COUNT));
+    }
+    else
+    {
+        u32 Log = TlsfFindLastSet(Size);
+        *Sl = u32(Size >> (Log - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT;
+        *Fl = Log - (TLSF_FL_SHIFT - 1);
+    }
+}
+
+inline void TlsfMappingSearch(mm Size, u32* Fl, u32* Sl)
+{
+    // NOTE: Round up to the next list so that any block we find in it is big enough
+    if (Size >= TLSF_SMALL_BLOCK_SIZE)
+    {
+        Size += (mm(1) << (TlsfFindLastSet(Size) - TLSF_SL_LOG2)) - 1;
+    }
+    TlsfMappingInsert(Size, Fl, Sl);
+}
+
+inline void TlsfInsertFreeBlock(tlsf_arena* Arena, tlsf_block* Block)
+{
+    u32 Fl, Sl;
+    TlsfMappingInsert(TlsfBlockGetSize(Block), &Fl, &Sl);
+    Assert(Fl < TLSF_FL_COUNT);
+
+    tlsf_block* Head = Arena->FreeLists[Fl][Sl];
+    Block->NextFree = Head;
+    Block->PrevFree = 0;
+    if (Head)
+    {
+        Head->PrevFree = Block;
+    }
+    Arena->FreeLists[Fl][Sl] = Block;
+    Arena->FlBitmap |= u64(1) << Fl;
+    Arena->SlBitmaps[Fl] |= 1u << Sl;
+}
+
+inline void TlsfRemoveFreeBlock(tlsf_arena* Arena, tlsf_block* Block)
+{
+    u32 Fl, Sl;
+    TlsfMappingInsert(TlsfBlockGetSize(Block), &Fl, &Sl);
+
+    if (Block->NextFree)
+    {
+        Block->NextFree->PrevFree = Block->PrevFree;
+    }
+    if (Block->PrevFree)
+    {
+        Block->PrevFree->NextFree = Block->NextFree;
+    }
+    else
+    {
+        Arena->FreeLists[Fl][Sl] = Block->NextFree;
+        if (!Block->NextFree)
+        {
+            Arena->SlBitmaps[Fl] &= ~(1u << Sl);
+            if (!Arena->SlBitmaps[Fl])
+            {
+                Arena->FlBitmap &= ~(u64(1) << Fl);
+            }
+        }
+    }
+}
+
+inline tlsf_block* TlsfFindFreeBlock(tlsf_arena* Arena, mm Size)
+{
+    tlsf_block* Result = 0;
+    
+    u32 Fl, Sl;
+    TlsfMappingSearch(Size, &Fl, &Sl);
+    if (Fl < TLSF_FL_COUNT)
+    {
+        u32 SlMap = Arena->SlBitmaps[Fl] & (~0u << Sl);
+        if (!SlMap)
+        {
+            // NOTE: Nothing big enough in this first level, take the smallest non empty one above it
+            u64 FlMap = (Fl + 1 < 64) ? Arena->FlBitmap & (~u64(0) << (Fl + 1)) : 0;
+            if (FlMap)
+            {
+                Fl = TlsfFindFirstSet(FlMap);
+                SlMap = Arena->SlBitmaps[Fl];
+            }
+        }
+
+        if (SlMap)
+        {
+            Sl = TlsfFindFirstSet(SlMap);
+            Result = Arena->FreeLists[Fl][Sl];
+            TlsfRemoveFreeBlock(Arena, Result);
+        }
+    }
+    
+    return Result;
+}
+
+//
+// NOTE: Split/Merge
+//
+
+inline void TlsfSplitBlock(tlsf_arena* Arena, tlsf_block* Block, mm Size)
+{
+    // NOTE: Gives the part of Block past Size back to the free lists if it can hold a block
+    mm BlockSize = TlsfBlockGetSize(Block);
+    if (BlockSize >= Size + sizeof(tlsf_block))
+    {
+        tlsf_block* Remaining = (tlsf_block*)((u8*)TlsfBlockGetPayload(Block) + Size);
+        Remaining->Size = BlockSize - Size - TLSF_BLOCK_OVERHEAD;
+        Remaining->PrevPhysical = Block;
+        TlsfBlockSetSize(Block, Size);
+
+        // NOTE: Remaining can have a free neighbour when we shrink in place
+        tlsf_block* Next = TlsfBlockGetNext(Remaining);
+        if (Next->Size & TLSF_BLOCK_FREE)
+        {
+            TlsfRemoveFreeBlock(Arena, Next);
+            TlsfBlockSetSize(Remaining, TlsfBlockGetSize(Remaining) + TLSF_BLOCK_OVERHEAD + TlsfBlockGetSize(Next));
+        }
+        
+        TlsfBlockMarkFree(Remaining);
+        TlsfInsertFreeBlock(Arena, Remaining);
+    }
+}
+
+inline tlsf_block* TlsfMergeBlock(tlsf_arena* Arena, tlsf_block* Block)
+{
+    // NOTE: Merges Block with its free physical neighbours, returns the merged block (not in any free list)
+    if (Block->Size & TLSF_BLOCK_PREV_FREE)
+    {
+        tlsf_block* Prev = Block->PrevPhysical;
+        TlsfRemoveFreeBlock(Arena, Prev);
+        TlsfBlockSetSize(Prev, TlsfBlockGetSize(Prev) + TLSF_BLOCK_OVERHEAD + TlsfBlockGetSize(Block));
+        Block = Prev;
+    }
+
+    tlsf_block* Next = TlsfBlockGetNext(Block);
+    if (Next->Size & TLSF_BLOCK_FREE)
+    {
+        TlsfRemoveFreeBlock(Arena, Next);
+        TlsfBlockSetSize(Block, TlsfBlockGetSize(Block) + TLSF_BLOCK_OVERHEAD + TlsfBlockGetSize(Next));
+    }
+
+    TlsfBlockGetNext(Block)->PrevPhysical = Block;
+    return Block;
+}
+
+//
+// NOTE: Pools
+//
+
+inline void TlsfArenaInitPool(tlsf_arena* Arena, tlsf_pool* Pool)
+{
+    // NOTE: Pool is laid out as [pool header][one free block][sentinel block with no payload that is always used]
+    mm PoolHeaderSize = AlignAddress(u64(sizeof(tlsf_pool)), u64(TLSF_ALIGNMENT));
+    mm BlockSize = ((Pool->Size - PoolHeaderSize - 2*TLSF_BLOCK_OVERHEAD) & TLSF_BLOCK_SIZE_MASK);
+    Assert(BlockSize >= TLSF_MIN_BLOCK_SIZE);
+    
+    tlsf_block* Block = (tlsf_block*)((u8*)Pool + PoolHeaderSize);
+    Block->PrevPhysical = 0;
+    Block->Size = BlockSize;
+
+    tlsf_block* Sentinel = TlsfBlockGetNext(Block);
+    Sentinel->Size = 0;
+    
+    TlsfBlockMarkFree(Block);
+    TlsfInsertFreeBlock(Arena, Block);
+}
+
+inline void TlsfArenaAddPool(tlsf_arena* Arena, void* Mem, mm Size, b32 FromOS = false)
+{
+    Assert(GetAlignOffset(Mem, TLSF_ALIGNMENT) == 0);
+    
+    tlsf_pool* Pool = (tlsf_pool*)Mem;
+    Pool->Size = Size;
+    Pool->FromOS = FromOS;
+    Pool->Next = Arena->Pools;
+    Arena->Pools = Pool;
+
+    TlsfArenaInitPool(Arena, Pool);
+}
+
+inline tlsf_arena TlsfArenaCreate(mm PoolSize, u32 Flags = 0)
+{
+    // NOTE: OS backed arena, maps pools of at least PoolSize whenever it runs out of space
+    tlsf_arena Result = {};
+    Result.PoolSize = MemoryGetAllocSize(PoolSize, Flags);
+    Result.Flags = Flags;
+
+    return Result;
+}
+
+inline tlsf_arena TlsfArenaCreate(linear_arena* Arena, mm Size)
+{
+    // NOTE: Fixed size arena that lives in a range of a (possibly reserved) linear arena. If the linear arena is full we get an
+    // arena without pools and every push returns 0
+    tlsf_arena Result = {};
+    void* Mem = PushSizeAligned(Arena, Size, TLSF_ALIGNMENT);
+    if (Mem)
+    {
+        TlsfArenaAddPool(&Result, Mem, Size);
+    }
+
+    return Result;
+}
+
+inline mm TlsfArenaGetAllocSize(mm Size)
+{
+    mm Result = Max(AlignAddress(u64(Size), u64(TLSF_ALIGNMENT)), u64(TLSF_MIN_BLOCK_SIZE));
+    return Result;
+}
+
+inline void* PushSizeAligned(tlsf_arena* Arena, mm Size, mm Alignment = 4)
+{
+    mm AllocSize = TlsfArenaGetAllocSize(Size);
+    
+    // NOTE: For big alignments we ask for enough space to skip ahead to an aligned spot and free the gap
+    mm SearchSize = AllocSize;
+    if (Alignment > TLSF_ALIGNMENT)
+    {
+        SearchSize += Alignment + sizeof(tlsf_block);
+    }
+    
+    tlsf_block* Block = TlsfFindFreeBlock(Arena, SearchSize);
+    if (!Block && Arena->PoolSize)
+    {
+        // NOTE: Out of space, map another pool that fits the allocation
+        mm PoolOverhead = AlignAddress(u64(sizeof(tlsf_pool)), u64(TLSF_ALIGNMENT)) + 2*TLSF_BLOCK_OVERHEAD;
+        mm NewPoolSize = MemoryGetAllocSize(Max(Arena->PoolSize, SearchSize*2 + PoolOverhead), Arena->Flags);
+        void* Mem = MemoryAllocate(NewPoolSize, Arena->Flags);
+        if (Mem)
+        {
+            TlsfArenaAddPool(Arena, Mem, NewPoolSize, true);
+        
+#if DEBUG_MEMORY_PROFILING
+            DebugRecordCommit(Arena, DebugArenaType_Tlsf, i64(NewPoolSize));
+#endif
+            Block = TlsfFindFreeBlock(Arena, SearchSize);
+        }
+    }
+    
+    if (!Block)
+    {
+        // NOTE: Fixed arena is full or the OS is out of memory
+        return 0;
+    }
+
+    if (Alignment > TLSF_ALIGNMENT)
+    {
+        u8* Payload = (u8*)TlsfBlockGetPayload(Block);
+        mm Gap = GetAlignOffset(Payload, Alignment);
+        if (Gap && Gap < sizeof(tlsf_block))
+        {
+            // NOTE: Gap is too small to hold a free block, skip to the next aligned spot
+            Gap += AlignAddress(u64(sizeof(tlsf_block) - Gap), u64(Alignment));
+        }
+
+        if (Gap)
+        {
+            // NOTE: Split the gap off the front, it becomes its own free block
+            mm BlockSize = TlsfBlockGetSize(Block);
+            tlsf_block* Aligned = (tlsf_block*)(Payload + Gap - TLSF_BLOCK_OVERHEAD);
+            Aligned->Size = BlockSize - Gap;
+            Aligned->PrevPhysical = Block;
+            TlsfBlockSetSize(Block, Gap - TLSF_BLOCK_OVERHEAD);
+            TlsfBlockMarkFree(Block);
+            TlsfInsertFreeBlock(Arena, Block);
+            Block = Aligned;
+        }
+    }
+
+    TlsfSplitBlock(Arena, Block, AllocSize);
+    TlsfBlockMarkUsed(Block);
+
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordAllocation(Arena, DebugArenaType_Tlsf, Size, Alignment, i64(TlsfBlockGetSize(Block)), DEBUG_MEMORY_CALL_SITE);
+#endif
+    
+    void* Result = TlsfBlockGetPayload(Block);
+    return Result;
+}
+
+inline void FreeSize(tlsf_arena* Arena, void* Mem)
+{
+    if (Mem)
+    {
+        tlsf_block* Block = TlsfBlockFromPayload(Mem);
+        Assert(!(Block->Size & TLSF_BLOCK_FREE));
+        
+#if DEBUG_MEMORY_PROFILING
+        DebugRecordFree(Arena, DebugArenaType_Tlsf, TlsfBlockGetSize(Block), DEBUG_MEMORY_CALL_SITE);
+#endif
+
+        Block = TlsfMergeBlock(Arena, Block);
+        TlsfBlockMarkFree(Block);
+        TlsfInsertFreeBlock(Arena, Block);
+    }
+}
+
+inline void* ReallocSize(tlsf_arena* Arena, void* Mem, mm NewSize, mm Alignment = 4)
+{
+    void* Result = 0;
+    if (!Mem)
+    {
+        Result = PushSizeAligned(Arena, NewSize, Alignment);
+    }
+    else
+    {
+        tlsf_block* Block = TlsfBlockFromPayload(Mem);
+        tlsf_block* Next = TlsfBlockGetNext(Block);
+        mm CurrSize = TlsfBlockGetSize(Block);
+        mm AllocSize = TlsfArenaGetAllocSize(NewSize);
+        mm CombinedSize = CurrSize + ((Next->Size & TLSF_BLOCK_FREE) ? TLSF_BLOCK_OVERHEAD + TlsfBlockGetSize(Next) : 0);
+
+        if (AllocSize <= CombinedSize)
+        {
+            // NOTE: Grow into our free neighbour (or shrink) in place
+            if (AllocSize > CurrSize)
+            {
+                TlsfRemoveFreeBlock(Arena, Next);
+                TlsfBlockSetSize(Block, CombinedSize);
+                TlsfBlockMarkUsed(Block);
+            }
+            TlsfSplitBlock(Arena, Block, AllocSize);
+            Result = Mem;
+        }
+        else
+        {
+            // NOTE: Like realloc, Mem stays valid if we can't move it
+            Result = PushSizeAligned(Arena, NewSize, Alignment);
+            if (Result)
+            {
+                Copy(Mem, Result, CurrSize);
+                FreeSize(Arena, Mem);
+            }
+        }
+    }
+
+    return Result;
+}
+
+inline void ArenaClear(tlsf_arena* Arena)
+{
+    // NOTE: Pools we mapped go back to the OS, pools given to us become one big free block again
+    tlsf_pool* Pools = Arena->Pools;
+    
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordClear(Arena, DebugArenaType_Tlsf, DEBUG_MEMORY_CALL_SITE);
+#endif
+    
+    Arena->FlBitmap = 0;
+    ZeroMem(Arena->SlBitmaps, sizeof(Arena->SlBitmaps));
+    ZeroMem(Arena->FreeLists, sizeof(Arena->FreeLists));
+    Arena->Pools = 0;
+
+    for (tlsf_pool* Pool = Pools; Pool; )
+    {
+        tlsf_pool* CurrPool = Pool;
+        Pool = Pool->Next;
+        if (CurrPool->FromOS)
+        {
+#if DEBUG_MEMORY_PROFILING
+            DebugRecordCommit(Arena, DebugArenaType_Tlsf, -i64(CurrPool->Size));
+#endif
+            MemoryFree(CurrPool, CurrPool->Size, Arena->Flags);
+        }
+        else
+        {
+            CurrPool->Next = Arena->Pools;
+            Arena->Pools = CurrPool;
+            TlsfArenaInitPool(Arena, CurrPool);
+        }
+    }
+
+#if DEBUG_MEMORY_PROFILING
+    DebugRecordRelease(Arena);
+#endif
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+//
+// NOTE: TLSF Arena
+//
+
+/*
+
+  NOTE: Two Level Segregated Fit arena for variable sized allocations that get freed individually. Free blocks are kept in lists
+  indexed by the log2 of their size (first level) and a linear split of that range (second level). Bitmaps of non empty lists let us
+  find a fitting block with two bit scans, and freed blocks get merged with their free neighbours right away, so push, free and
+  realloc are all O(1) with no searching.
+
+  Memory comes in pools, either mapped from the OS (and more get mapped when we run out) or carved out of a linear arena (fixed size).
+  Every allocation has a 16 byte header in front of it. Pushes return 0 once a fixed arena is full or the OS is out of memory, and a
+  failed ReallocSize leaves the old allocation as it was.
+  
+ */
+
+#define TLSF_SL_LOG2 5
+#define TLSF_SL_COUNT (1 << TLSF_SL_LOG2)
+#define TLSF_ALIGN_LOG2 4
+#define TLSF_ALIGNMENT (1 << TLSF_ALIGN_LOG2)
+#define TLSF_FL_SHIFT (TLSF_SL_LOG2 + TLSF_ALIGN_LOG2)
+#define TLSF_SMALL_BLOCK_SIZE (1 << TLSF_FL_SHIFT)
+#define TLSF_FL_COUNT 40
+
+#define TLSF_BLOCK_FREE 0x1
+#define TLSF_BLOCK_PREV_FREE 0x2
+#define TLSF_BLOCK_SIZE_MASK (~mm(TLSF_ALIGNMENT - 1))
+
+struct tlsf_block
+{
+    tlsf_block* PrevPhysical;
+    mm Size; // NOTE: Payload size, the low bits store the TLSF_BLOCK_ flags
+
+    // NOTE: Only valid while the block is free, overlaps the payload otherwise
+    tlsf_block* NextFree;
+    tlsf_block* PrevFree;
+};
+
+#define TLSF_BLOCK_OVERHEAD (2*sizeof(void*))
+#define TLSF_MIN_BLOCK_SIZE (sizeof(tlsf_block) - TLSF_BLOCK_OVERHEAD)
+
+struct tlsf_pool
+{
+    tlsf_pool* Next;
+    mm Size;
+    b32 FromOS;
+};
+
+struct tlsf_arena
+{
+    u64 FlBitmap;
+    u32 SlBitmaps[TLSF_FL_COUNT];
+    tlsf_block* FreeLists[TLSF_FL_COUNT][TLSF_SL_COUNT];
+
+    tlsf_pool* Pools;
+    mm PoolSize; // NOTE: 0 if we can't map more pools
+    u32 Flags;
+};
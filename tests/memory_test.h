@@ -0,0 +1,36 @@
+#pragma once
+
+//
+// NOTE: Test Helpers
+//
+
+/*
+
+  NOTE: Each test is its own executable built from the unity build, main returns 0 if every Check passed. Check doesn't compile
+  away with NDEBUG like Assert does, so the tests mean the same thing in Release builds and under the sanitizers.
+
+ */
+
+#include "math/types.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define Check(Expression)                                                                   \
+    do                                                                                      \
+    {                                                                                       \
+        if (!(Expression))                                                                  \
+        {                                                                                   \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #Expression);  \
+            abort();                                                                        \
+        }                                                                                   \
+    } while (0)
+
+// NOTE: Deterministic so failures reproduce, the tests don't need a good generator
+inline u32 TestRandom(u32* State)
+{
+    *State = *State * 1664525u + 1013904223u;
+    u32 Result = *State >> 8;
+    return Result;
+}
@@ -0,0 +1,102 @@
+#include "memory_test.h"
+
+#include <vector>
+
+struct test_component
+{
+    f32 X, Y, Z;
+    u32 Id;
+};
+
+int main()
+{
+    platform_block_arena PlatformArena = PlatformBlockArenaCreate(KiloBytes(64), 16);
+    block_array<test_component> Array = BlockArrayCreate<test_component>(&PlatformArena);
+    block_array<u64> Numbers = BlockArrayCreate<u64>(&PlatformArena);
+
+    // NOTE: Random push/pop/get against a std::vector, pointers have to stay put while the array grows over many blocks
+    std::vector<test_component> Expected;
+    std::vector<test_component*> Pointers;
+    u32 RandomState = 5;
+    u64 ExpectedSum = 0;
+    for (u32 Step = 0; Step < 100000; ++Step)
+    {
+        u32 Op = TestRandom(&RandomState) % 10;
+        if (Op < 6 || Expected.empty())
+        {
+            test_component Component = { f32(Step), 0, 0, Step };
+            test_component* Pushed = BlockArrayPush(&Array, Component);
+            Check((mm(Pushed) & (alignof(test_component) - 1)) == 0);
+            Expected.push_back(Component);
+            Pointers.push_back(Pushed);
+            
+            BlockArrayPush(&Numbers, u64(Step));
+            ExpectedSum += Step;
+        }
+        else if (Op < 8)
+        {
+            test_component Popped = BlockArrayPop(&Array);
+            Check(Popped.Id == Expected.back().Id);
+            Expected.pop_back();
+            Pointers.pop_back();
+        }
+        else
+        {
+            mm Index = TestRandom(&RandomState) % Expected.size();
+            test_component* Component = BlockArrayGet(&Array, Index);
+            Check(Component == Pointers[Index] && Component->Id == Expected[Index].Id);
+        }
+    }
+    Check(Array.NumElements == Expected.size());
+    Check(Array.NumElements > Array.ElementsPerBlock);
+
+    mm Count = 0;
+    BlockArrayForEach(&Array, [&](test_component& Component)
+    {
+        Check(Component.Id == Expected[Count].Id);
+        Count += 1;
+    });
+    Check(Count == Expected.size());
+
+    u64 Sum = 0;
+    BlockArrayForEachBlock(&Numbers, [&](u64* Elements, mm NumElements)
+    {
+        Check((mm(Elements) & (BLOCK_ARRAY_DATA_ALIGNMENT - 1)) == 0);
+        for (mm ElementId = 0; ElementId < NumElements; ++ElementId)
+        {
+            Sum += Elements[ElementId];
+        }
+    });
+    Check(Sum == ExpectedSum);
+
+    // NOTE: The block directory grows past its first page and stays in the same order as the block list
+    while (Numbers.NumBlocks <= 1024)
+    {
+        u64 Index = Numbers.NumElements;
+        BlockArrayPush(&Numbers, Index);
+    }
+    Check(Numbers.MaxBlocks > 1024);
+    mm BlockId = 0;
+    for (block* Block = Numbers.Arena.Next; Block; Block = Block->Next)
+    {
+        Check(Numbers.Blocks[BlockId++] == Block);
+    }
+    Check(BlockId == Numbers.NumBlocks);
+    for (mm Index = Numbers.NumElements - 1; Index > Numbers.NumElements - 100000; Index -= 997)
+    {
+        Check(*BlockArrayGet(&Numbers, Index) == Index);
+    }
+
+    // NOTE: Popping everything hands the blocks back, clearing the other array leaves the platform arena empty
+    while (Array.NumElements)
+    {
+        BlockArrayPop(&Array);
+    }
+    Check(!Array.Arena.Next && !Array.NumBlocks);
+    ArenaClear(&Numbers);
+    Check(!Numbers.Blocks && !Numbers.NumBlocks);
+    Check(!PlatformArena.Next);
+
+    ArenaClear(&PlatformArena);
+    return 0;
+}
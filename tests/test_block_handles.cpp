@@ -0,0 +1,113 @@
+#include "memory_test.h"
+
+#include <vector>
+
+struct test_item
+{
+    block_handle Handle;
+    u32 ArenaId;
+    u32 Value;
+};
+
+inline u32 TestCountPlatformBlocks(platform_block_arena* Arena)
+{
+    u32 Result = 0;
+    for (platform_block_header* Header = Arena->Next; Header; Header = Header->Next)
+    {
+        Result += 1;
+    }
+    return Result;
+}
+
+#define TEST_NUM_ARENAS 64
+
+int main()
+{
+    platform_block_arena PlatformArena = PlatformBlockArenaCreate(KiloBytes(256), 16);
+    block_handle_table Table = BlockHandleTableCreate(&PlatformArena, 100000);
+    block_arena Arenas[TEST_NUM_ARENAS];
+    for (u32 ArenaId = 0; ArenaId < TEST_NUM_ARENAS; ++ArenaId)
+    {
+        Arenas[ArenaId] = BlockArenaCreate(&PlatformArena, &Table);
+    }
+
+    // NOTE: Interleave pushes over all arenas so their blocks share platform blocks
+    std::vector<test_item> Items;
+    u32 RandomState = 7;
+    for (u32 ItemId = 0; ItemId < 20000; ++ItemId)
+    {
+        test_item Item = {};
+        Item.ArenaId = TestRandom(&RandomState) % TEST_NUM_ARENAS;
+        Item.Value = TestRandom(&RandomState);
+        Item.Handle = PushSizeHandle(&Arenas[Item.ArenaId], 200, 8);
+        *(u32*)BlockHandleGet(&Table, Item.Handle) = Item.Value;
+        Items.push_back(Item);
+    }
+
+    // NOTE: Clearing most arenas leaves the platform blocks sparse
+    std::vector<test_item> Kept;
+    for (u32 ArenaId = 0; ArenaId < TEST_NUM_ARENAS; ++ArenaId)
+    {
+        if (ArenaId % 8)
+        {
+            ArenaClear(&Arenas[ArenaId]);
+        }
+    }
+    for (test_item& Item : Items)
+    {
+        if (Item.ArenaId % 8 == 0)
+        {
+            Kept.push_back(Item);
+        }
+    }
+    u32 NumBefore = TestCountPlatformBlocks(&PlatformArena);
+
+    // NOTE: Compact in small budgets until nothing moves
+    mm NumMoved = 0;
+    for (u32 CallId = 0; CallId < 100000; ++CallId)
+    {
+        mm NumMovedNow = BlockHandleTableCompact(&Table, 20000);
+        NumMoved += NumMovedNow;
+        if (!NumMovedNow && CallId > 3)
+        {
+            break;
+        }
+    }
+    u32 NumAfter = TestCountPlatformBlocks(&PlatformArena);
+    Check(NumMoved > 0 && NumAfter < NumBefore);
+    for (test_item& Item : Kept)
+    {
+        Check(*(u32*)BlockHandleGet(&Table, Item.Handle) == Item.Value);
+    }
+
+    // NOTE: The arenas block lists and handles still line up after moves, and pushing keeps working
+    for (u32 ArenaId = 0; ArenaId < TEST_NUM_ARENAS; ArenaId += 8)
+    {
+        block_arena* Arena = Arenas + ArenaId;
+        block* Prev = 0;
+        for (block* Block = Arena->Next; Block; Block = Block->Next)
+        {
+            Check(Block->Prev == Prev && Table.Slots[Block->HandleId].Block == Block);
+            Prev = Block;
+        }
+        Check(Arena->Prev == Prev);
+        
+        block_handle Handle = PushSizeHandle(Arena, 300, 8);
+        *(u32*)BlockHandleGet(&Table, Handle) = 5;
+        Check(*(u32*)BlockHandleGet(&Table, Handle) == 5);
+    }
+    for (test_item& Item : Kept)
+    {
+        Check(*(u32*)BlockHandleGet(&Table, Item.Handle) == Item.Value);
+    }
+
+    for (u32 ArenaId = 0; ArenaId < TEST_NUM_ARENAS; ++ArenaId)
+    {
+        ArenaClear(&Arenas[ArenaId]);
+    }
+    Check(TestCountPlatformBlocks(&PlatformArena) == 0 && Table.FirstFree);
+    BlockHandleTableRelease(&Table);
+    ArenaClear(&PlatformArena);
+    
+    return 0;
+}
@@ -0,0 +1,223 @@
+#include "memory_test.h"
+
+#include <thread>
+#include <vector>
+
+#define TEST_NUM_THREADS 4
+#define TEST_PUSHES_PER_THREAD 5000
+
+inline mm TestPushSize(u32 PushId)
+{
+    mm Result = PushId % 1000 == 0 ? KiloBytes(300) : 8 + (PushId % 7)*8;
+    return Result;
+}
+
+inline u64 TestPushValue(u32 ThreadId, u32 PushId)
+{
+    u64 Result = (u64(ThreadId) << 32) | PushId;
+    return Result;
+}
+
+template<typename arena>
+static void TestConcurrentPushes(arena* Arena, b32 UseProducer)
+{
+    // NOTE: Every thread fills its pushes with a tag, any overlap between threads shows up as a wrong tag afterwards
+    std::vector<u64*> Pushes[TEST_NUM_THREADS];
+    std::vector<std::thread> Threads;
+    for (u32 ThreadId = 0; ThreadId < TEST_NUM_THREADS; ++ThreadId)
+    {
+        Threads.emplace_back([&, ThreadId]()
+        {
+            arena_producer<arena> Producer = ArenaProducerCreate(Arena, KiloBytes(4));
+            for (u32 PushId = 0; PushId < TEST_PUSHES_PER_THREAD; ++PushId)
+            {
+                mm Size = TestPushSize(PushId);
+                mm Alignment = PushId % 3 == 0 ? 64 : 8;
+                u64* Mem = (u64*)(UseProducer ? PushSizeAligned(&Producer, Size, Alignment) : PushSizeAligned(Arena, Size, Alignment));
+                Check(Mem && (mm(Mem) & (Alignment - 1)) == 0);
+                for (mm WordId = 0; WordId < Size / 8; ++WordId)
+                {
+                    Mem[WordId] = TestPushValue(ThreadId, PushId);
+                }
+                Pushes[ThreadId].push_back(Mem);
+                
+                if (PushId % 256 == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    for (u32 ThreadId = 0; ThreadId < TEST_NUM_THREADS; ++ThreadId)
+    {
+        for (u32 PushId = 0; PushId < TEST_PUSHES_PER_THREAD; ++PushId)
+        {
+            u64* Mem = Pushes[ThreadId][PushId];
+            for (mm WordId = 0; WordId < TestPushSize(PushId) / 8; ++WordId)
+            {
+                Check(Mem[WordId] == TestPushValue(ThreadId, PushId));
+            }
+        }
+    }
+}
+
+static platform_block_arena SharedPlatformArena;
+static volatile u64 SharedBlocks[TEST_NUM_THREADS][8];
+
+inline block* TestExchangeBlock(volatile u64* Slot, block* New)
+{
+    u64 Old = AtomicLoadU64(Slot);
+    for (;;)
+    {
+        u64 Prev = AtomicCompareExchangeU64(Slot, Old, u64(New));
+        if (Prev == Old)
+        {
+            break;
+        }
+        Old = Prev;
+    }
+    return (block*)Old;
+}
+
+static void TestPlatformBlockWorker(u32 ThreadId)
+{
+    // NOTE: Block arenas per thread on one shared platform arena, plus blocks freed by a different thread than allocated them
+    for (u32 Round = 0; Round < 200; ++Round)
+    {
+        block_arena Arena = BlockArenaCreate(&SharedPlatformArena);
+        for (u32 PushId = 0; PushId < 100; ++PushId)
+        {
+            u8* Mem = (u8*)PushSize(&Arena, 1000);
+            Mem[0] = u8(ThreadId);
+            Mem[999] = u8(ThreadId);
+        }
+        for (block* Block = Arena.Next; Block; Block = Block->Next)
+        {
+            Check(((u8*)(Block + 1))[0] == u8(ThreadId));
+        }
+        ArenaClear(&Arena);
+
+        for (u32 SlotId = 0; SlotId < 8; ++SlotId)
+        {
+            block* Old = TestExchangeBlock(&SharedBlocks[ThreadId][SlotId], PlatformBlockArenaAllocate(&SharedPlatformArena));
+            if (Old)
+            {
+                PlatformBlockArenaFree(&SharedPlatformArena, Old);
+            }
+        }
+        for (u32 SlotId = 0; SlotId < 8; ++SlotId)
+        {
+            block* Other = TestExchangeBlock(&SharedBlocks[(ThreadId + 1) % TEST_NUM_THREADS][SlotId], 0);
+            if (Other)
+            {
+                PlatformBlockArenaFree(&SharedPlatformArena, Other);
+            }
+        }
+        std::this_thread::yield();
+    }
+    PlatformBlockArenaFlushThreadCache(&SharedPlatformArena);
+}
+
+int main()
+{
+    linear_arena LinearArena = LinearArenaReserve(GigaBytes(1), KiloBytes(64), 0, 0, LinearArenaFlag_Concurrent);
+    temp_mem TempMem = BeginTempMem(&LinearArena);
+    TestConcurrentPushes(&LinearArena, false);
+    EndTempMem(TempMem);
+    TestConcurrentPushes(&LinearArena, true);
+    LinearArenaRelease(&LinearArena);
+
+    dynamic_arena DynamicArena = DynamicArenaCreate(KiloBytes(4), 0, MegaBytes(1), MegaBytes(64), DynamicArenaFlag_Concurrent);
+    dynamic_temp_mem DynamicTempMem = BeginTempMem(&DynamicArena);
+    TestConcurrentPushes(&DynamicArena, false);
+    EndTempMem(DynamicTempMem);
+    TestConcurrentPushes(&DynamicArena, false);
+    ArenaClear(&DynamicArena);
+    TestConcurrentPushes(&DynamicArena, true);
+    DynamicArenaRelease(&DynamicArena);
+
+    SharedPlatformArena = PlatformBlockArenaCreate(MegaBytes(1), 64, 0, PlatformBlockArenaFlag_Concurrent);
+    std::vector<std::thread> Threads;
+    for (u32 ThreadId = 0; ThreadId < TEST_NUM_THREADS; ++ThreadId)
+    {
+        Threads.emplace_back(TestPlatformBlockWorker, ThreadId);
+    }
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+    ArenaClear(&SharedPlatformArena);
+
+    // NOTE: More concurrent arenas than magazine slots, one gets cleared and freed while this thread still holds its magazine.
+    // Evicting that magazine later must not touch the freed arena
+    platform_block_arena* Arenas[PLATFORM_BLOCK_MAX_MAGAZINES + 2];
+    for (u32 ArenaId = 0; ArenaId < ArrayCount(Arenas); ++ArenaId)
+    {
+        Arenas[ArenaId] = (platform_block_arena*)malloc(sizeof(platform_block_arena));
+        *Arenas[ArenaId] = PlatformBlockArenaCreate(KiloBytes(64), 16, 0, PlatformBlockArenaFlag_Concurrent);
+    }
+    for (u32 Round = 0; Round < 20; ++Round)
+    {
+        for (u32 ArenaId = 0; ArenaId < ArrayCount(Arenas); ++ArenaId)
+        {
+            if (!Arenas[ArenaId])
+            {
+                continue;
+            }
+            
+            block* Blocks[8];
+            for (u32 BlockId = 0; BlockId < ArrayCount(Blocks); ++BlockId)
+            {
+                Blocks[BlockId] = PlatformBlockArenaAllocate(Arenas[ArenaId]);
+            }
+            for (u32 BlockId = 0; BlockId < ArrayCount(Blocks); ++BlockId)
+            {
+                PlatformBlockArenaFree(Arenas[ArenaId], Blocks[BlockId]);
+            }
+            
+            if (Round == 3 && ArenaId == 0)
+            {
+                ArenaClear(Arenas[0]);
+                free(Arenas[0]);
+                Arenas[0] = 0;
+            }
+        }
+    }
+    for (u32 ArenaId = 1; ArenaId < ArrayCount(Arenas); ++ArenaId)
+    {
+        ArenaClear(Arenas[ArenaId]);
+        free(Arenas[ArenaId]);
+    }
+
+    // NOTE: A thread that exits without flushing gives its cached blocks back to the global stack
+    SharedPlatformArena = PlatformBlockArenaCreate(MegaBytes(1), 64, 0, PlatformBlockArenaFlag_Concurrent);
+    std::thread ExitingThread([]()
+    {
+        block* Blocks[8];
+        for (u32 BlockId = 0; BlockId < ArrayCount(Blocks); ++BlockId)
+        {
+            Blocks[BlockId] = PlatformBlockArenaAllocate(&SharedPlatformArena);
+        }
+        for (u32 BlockId = 0; BlockId < ArrayCount(Blocks); ++BlockId)
+        {
+            PlatformBlockArenaFree(&SharedPlatformArena, Blocks[BlockId]);
+        }
+    });
+    ExitingThread.join();
+
+    mm NumCarved = 0;
+    for (platform_block_header* Header = SharedPlatformArena.Next; Header; Header = Header->Next)
+    {
+        NumCarved += Header->NumCarvedBlocks;
+    }
+    Check(NumCarved >= 8);
+    Check(SharedPlatformArena.Nodes[0].NumStackBlocks == NumCarved);
+    ArenaClear(&SharedPlatformArena);
+
+    return 0;
+}
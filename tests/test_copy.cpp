@@ -0,0 +1,153 @@
+// NOTE: Use our kernels even where the CRT would be picked so they get tested on every platform
+#define MEMORY_SIMD_COPY 1
+#include "memory_test.h"
+
+#include <string.h>
+
+#define TEST_BUFFER_SIZE KiloBytes(160)
+
+static u8 TestSrc[TEST_BUFFER_SIZE];
+static u8 TestDest[TEST_BUFFER_SIZE];
+static u8 TestExpected[TEST_BUFFER_SIZE];
+
+inline void TestFill(u8* Mem, mm Size, u32 Seed)
+{
+    u32 RandomState = Seed;
+    for (mm ByteId = 0; ByteId < Size; ++ByteId)
+    {
+        Mem[ByteId] = u8(TestRandom(&RandomState));
+    }
+}
+
+inline void TestReferenceMove(const u8* Src, u8* Dest, mm Size)
+{
+    if (Dest < Src)
+    {
+        for (mm ByteId = 0; ByteId < Size; ++ByteId)
+        {
+            Dest[ByteId] = Src[ByteId];
+        }
+    }
+    else
+    {
+        for (mm ByteId = Size; ByteId > 0; --ByteId)
+        {
+            Dest[ByteId - 1] = Src[ByteId - 1];
+        }
+    }
+}
+
+inline void TestCheckEqual(u8* A, u8* B, mm Size)
+{
+    for (mm ByteId = 0; ByteId < Size; ++ByteId)
+    {
+        Check(A[ByteId] == B[ByteId]);
+    }
+}
+
+static void TestSizes(mm Size)
+{
+    // NOTE: Heads and tails at every offset within a vector, the bytes around the range must stay untouched. Big sizes only try a
+    // few offsets to keep the sanitizer builds fast
+    mm OffsetStep = Size > 300 ? 29 : 11;
+    for (mm SrcOffset = 0; SrcOffset < 64; SrcOffset += OffsetStep)
+    {
+        for (mm DestOffset = 0; DestOffset < 64; DestOffset += OffsetStep + 2)
+        {
+            TestFill(TestDest, Size + 128, u32(Size + DestOffset));
+            TestFill(TestSrc, Size + 128, u32(Size + SrcOffset + 1000));
+
+            memcpy(TestExpected, TestDest, Size + 128);
+            ZeroMem(TestDest + DestOffset, Size);
+            for (mm ByteId = 0; ByteId < Size; ++ByteId)
+            {
+                TestExpected[DestOffset + ByteId] = 0;
+            }
+            TestCheckEqual(TestDest, TestExpected, Size + 128);
+
+            Copy(TestSrc + SrcOffset, TestDest + DestOffset, Size);
+            TestReferenceMove(TestSrc + SrcOffset, TestExpected + DestOffset, Size);
+            TestCheckEqual(TestDest, TestExpected, Size + 128);
+        }
+    }
+
+    // NOTE: Move with the ranges overlapping by every amount in both directions
+    mm Shifts[] = { 1, 3, 15, 16, 17, 31, 33, 64, 100 };
+    for (u32 ShiftId = 0; ShiftId < ArrayCount(Shifts); ++ShiftId)
+    {
+        mm Shift = Shifts[ShiftId];
+        for (mm Offset = 0; Offset < 8; Offset += (Size > 300 ? 5 : 3))
+        {
+            // NOTE: Dest in front of Src
+            TestFill(TestDest, Size + Shift + 16, u32(Size + Shift + Offset));
+            memcpy(TestExpected, TestDest, Size + Shift + 16);
+            Move(TestDest + Offset + Shift, TestDest + Offset, Size);
+            TestReferenceMove(TestExpected + Offset + Shift, TestExpected + Offset, Size);
+            TestCheckEqual(TestDest, TestExpected, Size + Shift + 16);
+
+            // NOTE: Dest behind Src
+            TestFill(TestDest, Size + Shift + 16, u32(Size + Shift + Offset + 7));
+            memcpy(TestExpected, TestDest, Size + Shift + 16);
+            Move(TestDest + Offset, TestDest + Offset + Shift, Size);
+            TestReferenceMove(TestExpected + Offset, TestExpected + Offset + Shift, Size);
+            TestCheckEqual(TestDest, TestExpected, Size + Shift + 16);
+        }
+    }
+}
+
+static void TestAllSizes()
+{
+    for (mm Size = 0; Size <= 300; Size += (Size < 130 ? 1 : 7))
+    {
+        TestSizes(Size);
+    }
+
+    mm BigSizes[] = { 1000, 4095, 4096, 4097, KiloBytes(64) + 13 };
+    for (u32 SizeId = 0; SizeId < ArrayCount(BigSizes); ++SizeId)
+    {
+        TestSizes(BigSizes[SizeId]);
+    }
+}
+
+int main()
+{
+    TestAllSizes();
+
+#if MEMORY_X86 && MEMORY_SIMD_COPY
+    // NOTE: Every kernel the CPU supports, with the streaming path forced on for sizes past 4KB
+    u32 MaxLevel = MemoryGetSimdLevel();
+    for (u32 Level = MemorySimdLevel_Sse2; Level <= MaxLevel; ++Level)
+    {
+        switch (Level)
+        {
+            case MemorySimdLevel_Avx512:
+            {
+                MemorySimd.Width = 64;
+                MemorySimd.Zero = ZeroMemAvx512_;
+                MemorySimd.Copy = CopyAvx512_;
+            } break;
+
+            case MemorySimdLevel_Avx2:
+            {
+                MemorySimd.Width = 32;
+                MemorySimd.Zero = ZeroMemAvx2_;
+                MemorySimd.Copy = CopyAvx2_;
+            } break;
+
+            default:
+            {
+                MemorySimd.Width = 16;
+                MemorySimd.Zero = ZeroMemSse2_;
+                MemorySimd.Copy = CopySse2_;
+            } break;
+        }
+
+        MemorySimd.NonTemporalThreshold = ~mm(0);
+        TestAllSizes();
+        MemorySimd.NonTemporalThreshold = KiloBytes(4);
+        TestAllSizes();
+    }
+#endif
+
+    return 0;
+}
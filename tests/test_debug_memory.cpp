@@ -0,0 +1,86 @@
+#define DEBUG_MEMORY_PROFILING 1
+#include "memory_test.h"
+
+#include <thread>
+#include <vector>
+
+#define TEST_NUM_THREADS 4
+#define TEST_PUSHES_PER_THREAD 2000
+
+int main()
+{
+    // NOTE: Concurrent pushes record from every thread at once, the per arena counters can't lose updates
+    linear_arena Arena = LinearArenaReserve(MegaBytes(64), KiloBytes(64), 0, 0, LinearArenaFlag_Concurrent);
+    std::vector<std::thread> Threads;
+    for (u32 ThreadId = 0; ThreadId < TEST_NUM_THREADS; ++ThreadId)
+    {
+        Threads.emplace_back([&Arena]()
+        {
+            for (u32 PushId = 0; PushId < TEST_PUSHES_PER_THREAD; ++PushId)
+            {
+                Check(PushSizeAligned(&Arena, 16, 8));
+            }
+        });
+    }
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+    
+    debug_arena_stats* Stats = DebugMemoryGetStats(&Arena, DebugArenaType_Linear);
+    Check(Stats);
+    Check(Stats->NumAllocs == TEST_NUM_THREADS*TEST_PUSHES_PER_THREAD);
+    Check(Stats->NumBytes == TEST_NUM_THREADS*TEST_PUSHES_PER_THREAD*16);
+    Check(Stats->Used == Arena.Used && Stats->HighWater == Arena.Used);
+    Check(Stats->Committed == Arena.Size);
+    LinearArenaRelease(&Arena);
+    Check(Stats->Committed == 0);
+    Check(Stats->Arena != u64(&Arena));
+
+    // NOTE: A new arena at the address of a released one starts with fresh counters
+    Arena = LinearArenaReserve(MegaBytes(1));
+    Check(PushSize(&Arena, 32));
+    Stats = DebugMemoryGetStats(&Arena, DebugArenaType_Linear);
+    Check(Stats->NumAllocs == 1 && Stats->NumBytes == 32);
+    Check(Stats->HighWater == Arena.Used && Stats->Committed == Arena.Size);
+    LinearArenaRelease(&Arena);
+
+    // NOTE: Block arenas end their stats on clear, even when their platform arena got cleared first
+    {
+        platform_block_arena PlatformArena = PlatformBlockArenaCreate(KiloBytes(64), 16);
+        block_arena BlockArena = BlockArenaCreate(&PlatformArena);
+        Check(PushSize(&BlockArena, 100));
+        ArenaClear(&PlatformArena);
+        ArenaClear(&BlockArena);
+
+        BlockArena = BlockArenaCreate(&PlatformArena);
+        Check(PushSize(&BlockArena, 100));
+        debug_arena_stats* BlockStats = DebugMemoryGetStats(&BlockArena, DebugArenaType_Block);
+        Check(BlockStats->NumAllocs == 1 && BlockStats->Committed == PlatformArena.BlockSize);
+        ArenaClear(&BlockArena);
+        ArenaClear(&PlatformArena);
+    }
+
+    // NOTE: Rings of exited threads get reused and never show up in the OS call counts
+    u64 NumReserves = MemoryOsStats.NumReserves;
+    for (u32 ThreadId = 0; ThreadId < 16; ++ThreadId)
+    {
+        std::thread Thread([]()
+        {
+            linear_arena ThreadArena = LinearArenaReserve(MegaBytes(1));
+            PushSize(&ThreadArena, 64);
+            LinearArenaRelease(&ThreadArena);
+        });
+        Thread.join();
+    }
+    Check(MemoryOsStats.NumReserves - NumReserves == 16);
+
+    u32 NumRings = 0;
+    for (debug_memory_ring* Ring = (debug_memory_ring*)DebugMemoryState.Rings; Ring; Ring = Ring->Next)
+    {
+        NumRings += 1;
+    }
+    Check(NumRings <= TEST_NUM_THREADS + 1);
+
+    return 0;
+}
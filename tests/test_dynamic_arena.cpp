@@ -0,0 +1,168 @@
+#include "memory_test.h"
+
+inline u32 TestCountBlocks(dynamic_arena* Arena)
+{
+    u32 Result = 0;
+    for (dynamic_arena_header* Header = Arena->Next; Header; Header = Header->Next)
+    {
+        Result += 1;
+    }
+    return Result;
+}
+
+int main()
+{
+    // NOTE: Temp mem loops land on the retained blocks after the first iteration and stop mapping
+    {
+        dynamic_arena Arena = DynamicArenaCreate(KiloBytes(4));
+        u64 NumReserves = 0;
+        for (u32 Iteration = 0; Iteration < 8; ++Iteration)
+        {
+            dynamic_temp_mem TempMem = BeginTempMem(&Arena);
+            for (u32 PushId = 0; PushId < 64; ++PushId)
+            {
+                u32* Data = PushArray(&Arena, u32, 128);
+                Check(Data);
+                Data[0] = PushId;
+                Data[127] = Iteration;
+            }
+            EndTempMem(TempMem);
+
+            Check(!Arena.Next && !Arena.Prev);
+            Check(Arena.NextBlockSize == Arena.MinBlockSize);
+            Check(Arena.RetainedSize > 0);
+            if (Iteration == 0)
+            {
+                NumReserves = MemoryOsStats.NumReserves;
+            }
+            Check(MemoryOsStats.NumReserves == NumReserves);
+        }
+
+        // NOTE: Trim honors KeepSize and release gives everything back
+        DynamicArenaTrim(&Arena, KiloBytes(16));
+        Check(Arena.RetainedSize <= KiloBytes(16));
+        DynamicArenaRelease(&Arena);
+        Check(Arena.RetainedSize == 0);
+        for (u32 BucketId = 0; BucketId < DYNAMIC_ARENA_NUM_BUCKETS; ++BucketId)
+        {
+            Check(!Arena.FreeBuckets[BucketId]);
+        }
+    }
+
+    // NOTE: Blocks over MaxRetainedSize go straight back to the OS
+    {
+        dynamic_arena Arena = DynamicArenaCreate(KiloBytes(4), 0, KiloBytes(4), KiloBytes(8));
+        for (u32 PushId = 0; PushId < 24; ++PushId)
+        {
+            Check(PushSize(&Arena, KiloBytes(1)));
+        }
+        Check(TestCountBlocks(&Arena) == 8);
+        u64 NumReleases = MemoryOsStats.NumReleases;
+        ArenaClear(&Arena);
+        Check(Arena.RetainedSize == KiloBytes(8));
+        Check(MemoryOsStats.NumReleases - NumReleases == 6);
+        DynamicArenaRelease(&Arena);
+    }
+
+    // NOTE: Pushes a bit over the block size start a new bump block, only pushes well past it get their own mapping
+    {
+        dynamic_arena Arena = DynamicArenaCreate(KiloBytes(4));
+        Check(PushSize(&Arena, KiloBytes(3)));
+        Check(PushSize(&Arena, KiloBytes(3)));
+        Check(!Arena.LargeBlocks);
+        Check(TestCountBlocks(&Arena) == 2);
+        Check(Arena.NextBlockSize == KiloBytes(16));
+
+        dynamic_arena_header* Current = Arena.Prev;
+        Check(PushSize(&Arena, KiloBytes(256)));
+        Check(Arena.LargeBlocks && !Arena.LargeBlocks->Next);
+        Check(Arena.Prev == Current);
+        Check(Arena.NextBlockSize == KiloBytes(32));
+
+        // NOTE: Large blocks are retained apart from the bump blocks
+        ArenaClear(&Arena);
+        Check(Arena.FreeLargeBlocks && !Arena.FreeLargeBlocks->Next);
+        for (u32 BucketId = 0; BucketId < DYNAMIC_ARENA_NUM_BUCKETS; ++BucketId)
+        {
+            for (dynamic_arena_header* Header = Arena.FreeBuckets[BucketId]; Header; Header = Header->Next)
+            {
+                Check(Header->Size < KiloBytes(256));
+            }
+        }
+
+        // NOTE: Normal pushes never take the retained large block, even once the retained bump blocks run out
+        for (u32 PushId = 0; PushId < 16; ++PushId)
+        {
+            Check(PushSize(&Arena, KiloBytes(2)));
+        }
+        Check(Arena.FreeLargeBlocks);
+        for (dynamic_arena_header* Header = Arena.Next; Header; Header = Header->Next)
+        {
+            Check(Header->Size < KiloBytes(256));
+        }
+        ArenaClear(&Arena);
+
+        // NOTE: A large push of the same size reuses it, a much smaller one doesn't pin it
+        Check(PushSize(&Arena, KiloBytes(64)));
+        Check(Arena.FreeLargeBlocks);
+        u64 NumReserves = MemoryOsStats.NumReserves;
+        Check(PushSize(&Arena, KiloBytes(256)));
+        Check(MemoryOsStats.NumReserves == NumReserves);
+        Check(!Arena.FreeLargeBlocks);
+        
+        ArenaClear(&Arena);
+        DynamicArenaRelease(&Arena);
+        Check(Arena.RetainedSize == 0 && !Arena.FreeLargeBlocks);
+    }
+
+    // NOTE: Temp mem gives large blocks back to the large list and repeats without mapping
+    {
+        dynamic_arena Arena = DynamicArenaCreate(KiloBytes(4));
+        Check(PushSize(&Arena, 64));
+        u64 NumReserves = 0;
+        for (u32 Iteration = 0; Iteration < 4; ++Iteration)
+        {
+            dynamic_temp_mem TempMem = BeginTempMem(&Arena);
+            u8* Data = (u8*)PushSize(&Arena, MegaBytes(1));
+            Check(Data);
+            Data[MegaBytes(1) - 1] = 1;
+            Check(Arena.LargeBlocks);
+            EndTempMem(TempMem);
+
+            Check(!Arena.LargeBlocks && Arena.FreeLargeBlocks);
+            if (Iteration == 0)
+            {
+                NumReserves = MemoryOsStats.NumReserves;
+            }
+            Check(MemoryOsStats.NumReserves == NumReserves);
+        }
+        DynamicArenaRelease(&Arena);
+    }
+
+    // NOTE: A push the OS can't back returns 0 and leaves the arena as it was
+    {
+        dynamic_arena Arena = DynamicArenaCreate(KiloBytes(4));
+        Check(PushStruct(&Arena, u32));
+        dynamic_arena_header* Header = Arena.Prev;
+        mm Used = Header->Used;
+        mm NextBlockSize = Arena.NextBlockSize;
+
+        // NOTE: Past the 47 bit address space so the mapping always fails
+        Check(!PushSize(&Arena, mm(1) << 50));
+        Check(Arena.Prev == Header && Arena.Next == Header);
+        Check(Header->Used == Used);
+        Check(Arena.NextBlockSize == NextBlockSize);
+        Check(!Arena.LargeBlocks);
+        Check(PushStruct(&Arena, u32));
+        DynamicArenaRelease(&Arena);
+
+        dynamic_arena Concurrent = DynamicArenaCreate(KiloBytes(4), 0, DYNAMIC_ARENA_DEFAULT_MAX_BLOCK_SIZE,
+                                                      DYNAMIC_ARENA_DEFAULT_MAX_RETAINED_SIZE, DynamicArenaFlag_Concurrent);
+        Check(PushStruct(&Concurrent, u32));
+        Check(!PushSize(&Concurrent, mm(1) << 50));
+        Check(!Concurrent.LargeBlocks);
+        DynamicArenaRelease(&Concurrent);
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include "memory_test.h"
+
+#include <string.h>
+
+struct test_node
+{
+    rel_ptr<test_node> Next;
+    rel_array<u32> Values;
+    u32 Id;
+};
+
+struct test_root
+{
+    rel_ptr<test_node> First;
+    u32 NumNodes;
+    rel_ptr<char> Name;
+};
+
+#define TEST_FILE_PATH "memory_test_file_arena.arena"
+
+int main()
+{
+    // NOTE: Build a linked structure through relative pointers and save it
+    {
+        linear_arena Arena = LinearArenaFileCreate(TEST_FILE_PATH, MegaBytes(64), KiloBytes(64));
+        Check(Arena.Mem && (mm(Arena.Mem) & (MemoryGetPageSize() - 1)) == 0);
+        
+        test_root* Root = PushStructAligned(&Arena, test_root, 8);
+        *Root = {};
+        test_node* Prev = 0;
+        for (u32 NodeId = 0; NodeId < 20000; ++NodeId)
+        {
+            test_node* Node = PushStructAligned(&Arena, test_node, 8);
+            *Node = {};
+            Node->Id = NodeId;
+            Node->Values.Data = PushArrayAligned(&Arena, u32, NodeId % 7, 4);
+            Node->Values.Count = NodeId % 7;
+            for (u32 ValueId = 0; ValueId < NodeId % 7; ++ValueId)
+            {
+                Node->Values[ValueId] = NodeId*10 + ValueId;
+            }
+            
+            if (Prev)
+            {
+                Prev->Next = Node;
+            }
+            else
+            {
+                Root->First = Node;
+            }
+            Prev = Node;
+        }
+        Root->NumNodes = 20000;
+        Root->Name = PushString(&Arena, "snapshot");
+        LinearArenaFileSetRoot(&Arena, Root);
+        Check(LinearArenaFileSave(&Arena));
+
+        // NOTE: Pushes after the save don't change the saved Used
+        PushSize(&Arena, 100);
+        LinearArenaFileClose(&Arena);
+    }
+
+    // NOTE: Open it again at a different address and walk it
+    {
+        void* Shift = MemoryReserve(MegaBytes(80));
+        linear_arena Arena = LinearArenaFileOpen(TEST_FILE_PATH, MegaBytes(64));
+        Check(Arena.Mem);
+        
+        test_root* Root = (test_root*)LinearArenaFileGetRoot(&Arena);
+        Check(Root && strcmp(Root->Name.Get(), "snapshot") == 0);
+        u32 Count = 0;
+        for (test_node* Node = Root->First; Node; Node = Node->Next)
+        {
+            Check(Node->Id == Count && Node->Values.Count == Count % 7);
+            for (u32 ValueId = 0; ValueId < Node->Values.Count; ++ValueId)
+            {
+                Check(Node->Values[ValueId] == Count*10 + ValueId);
+            }
+            Count += 1;
+        }
+        Check(Count == Root->NumNodes);
+
+        // NOTE: Keeps growing after open, clearing leaves the header (and root) alone
+        u8* Mem = (u8*)PushSize(&Arena, MegaBytes(1));
+        Mem[MegaBytes(1) - 1] = 1;
+        LinearArenaClear(&Arena);
+        Check(LinearArenaFileGetRoot(&Arena) == Root);
+        LinearArenaFileClose(&Arena);
+        MemoryRelease(Shift, MegaBytes(80));
+    }
+
+    // NOTE: A file written on a machine with 64KB pages keeps its header size
+    {
+        mm HeaderSize = KiloBytes(64);
+        FILE* File = fopen(TEST_FILE_PATH, "wb");
+        Check(File);
+        u8* Contents = (u8*)calloc(1, HeaderSize + 16);
+        linear_arena_file_header Header = {};
+        Header.Magic = LINEAR_ARENA_FILE_MAGIC;
+        Header.HeaderSize = HeaderSize;
+        Header.Used = 8;
+        memcpy(Contents, &Header, sizeof(Header));
+        memcpy(Contents + HeaderSize, "payload", 8);
+        Check(fwrite(Contents, 1, HeaderSize + 16, File) == HeaderSize + 16);
+        fclose(File);
+        free(Contents);
+
+        linear_arena Arena = LinearArenaFileOpen(TEST_FILE_PATH, MegaBytes(1));
+        Check(Arena.Mem && Arena.FileHeaderSize == HeaderSize && Arena.Used == 8);
+        Check(strcmp((char*)Arena.Mem, "payload") == 0);
+        LinearArenaFileClose(&Arena);
+    }
+
+    // NOTE: Files that are missing or aren't arenas don't open
+    {
+        FILE* File = fopen(TEST_FILE_PATH, "wb");
+        Check(File);
+        fputs("not an arena file, just some text that is longer than the header struct", File);
+        fclose(File);
+        linear_arena Arena = LinearArenaFileOpen(TEST_FILE_PATH, MegaBytes(1));
+        Check(!Arena.Mem);
+    }
+    remove(TEST_FILE_PATH);
+    
+    linear_arena Missing = LinearArenaFileOpen(TEST_FILE_PATH, MegaBytes(1));
+    Check(!Missing.Mem);
+
+    rel_ptr<int> Null = {};
+    Check(!Null);
+    
+    return 0;
+}
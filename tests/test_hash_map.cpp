@@ -0,0 +1,85 @@
+#include "memory_test.h"
+
+#include <unordered_map>
+
+struct test_key
+{
+    i32 X, Y;
+
+    bool operator==(const test_key& Other) const
+    {
+        return X == Other.X && Y == Other.Y;
+    }
+};
+
+int main()
+{
+    linear_arena LinearArena = LinearArenaReserve(GigaBytes(1));
+    
+    // NOTE: Random insert/remove/find against std::unordered_map, small key ranges churn deleted slots, the big one forces rehashes
+    u32 RandomState = 9;
+    u64 KeyRanges[] = { 100, 5000, 1000000 };
+    for (u64 Range : KeyRanges)
+    {
+        temp_mem TempMem = BeginTempMem(&LinearArena);
+        auto Map = HashMapCreate<u64, u64>(&LinearArena);
+        std::unordered_map<u64, u64> Expected;
+        for (u32 Step = 0; Step < 100000; ++Step)
+        {
+            u64 Key = TestRandom(&RandomState) % Range;
+            u32 Op = TestRandom(&RandomState) % 4;
+            if (Op == 0)
+            {
+                HashMapInsert(&Map, Key, u64(Step));
+                Expected[Key] = Step;
+            }
+            else if (Op == 1)
+            {
+                b32 Removed = HashMapRemove(&Map, Key);
+                Check(Removed == b32(Expected.erase(Key)));
+            }
+            else
+            {
+                u64* Value = HashMapFind(&Map, Key);
+                auto It = Expected.find(Key);
+                Check((Value != 0) == (It != Expected.end()));
+                Check(!Value || *Value == It->second);
+            }
+            Check(Map.NumElements == Expected.size());
+        }
+
+        mm Count = 0;
+        HashMapForEach(&Map, [&](const u64& Key, u64& Value)
+        {
+            Check(Expected[Key] == Value);
+            Count += 1;
+        });
+        Check(Count == Expected.size());
+        Check(Map.NumElements + Map.NumDeleted <= Map.Capacity*HASH_MAP_MAX_LOAD_NUMERATOR/HASH_MAP_MAX_LOAD_DENOMINATOR);
+
+        // NOTE: The map and every table it outgrew go away with the temp mem
+        EndTempMem(TempMem);
+        Check(LinearArena.Used == 0);
+    }
+    LinearArenaRelease(&LinearArena);
+
+    // NOTE: Struct keys go through the byte hash
+    dynamic_arena DynamicArena = DynamicArenaCreate(KiloBytes(64));
+    auto Map = HashMapCreate<test_key, f32>(&DynamicArena, 1000);
+    for (i32 Id = 0; Id < 1000; ++Id)
+    {
+        HashMapInsert(&Map, test_key{Id, -Id}, f32(Id));
+    }
+    for (i32 Id = 0; Id < 1000; ++Id)
+    {
+        f32* Value = HashMapFind(&Map, test_key{Id, -Id});
+        Check(Value && *Value == f32(Id));
+    }
+    Check(!HashMapFind(&Map, test_key{1, 1}));
+    
+    HashMapClear(&Map);
+    Check(Map.NumElements == 0 && !HashMapFind(&Map, test_key{5, -5}));
+    DynamicArenaRelease(&DynamicArena);
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "memory_test.h"
+
+#include <thread>
+#include <vector>
+
+#define TEST_NUM_THREADS 4
+
+int main()
+{
+    // NOTE: Pushes past the reservation fail without touching the arena, smaller ones still fit afterwards
+    linear_arena Arena = LinearArenaReserve(KiloBytes(256), KiloBytes(64), KiloBytes(64));
+    Check(PushSizeAligned(&Arena, KiloBytes(100), 8));
+    mm Used = Arena.Used;
+    mm Size = Arena.Size;
+    Check(!PushSizeAligned(&Arena, KiloBytes(200), 8));
+    Check(Arena.Used == Used && Arena.Size == Size);
+    Check(PushSizeAligned(&Arena, KiloBytes(100), 8));
+    Check(Arena.Size <= Arena.ReservedSize);
+
+    // NOTE: Clearing gives back the pages past the decommit threshold
+    LinearArenaClear(&Arena);
+    Check(Arena.Used == 0 && Arena.Size <= KiloBytes(64));
+    LinearArenaRelease(&Arena);
+
+    // NOTE: Fixed arenas can't grow at all
+    alignas(16) static u8 Buffer[KiloBytes(4)];
+    linear_arena FixedArena = LinearArenaCreate(Buffer, sizeof(Buffer));
+    Check(PushSizeAligned(&FixedArena, 4000, 8));
+    Check(!PushSizeAligned(&FixedArena, 200, 8) && FixedArena.Used == 4000);
+
+    // NOTE: Concurrent pushes that run out of reserve must leave Used inside the arena, a later clear/decommit depends on it
+    linear_arena ConcurrentArena = LinearArenaReserve(MegaBytes(1), KiloBytes(64), KiloBytes(64), 0, LinearArenaFlag_Concurrent);
+    for (u32 Round = 0; Round < 4; ++Round)
+    {
+        volatile u64 NumPushed = 0;
+        std::vector<std::thread> Threads;
+        for (u32 ThreadId = 0; ThreadId < TEST_NUM_THREADS; ++ThreadId)
+        {
+            Threads.emplace_back([&ConcurrentArena, &NumPushed]()
+            {
+                for (u32 PushId = 0; PushId < 1000; ++PushId)
+                {
+                    if (PushSizeAligned(&ConcurrentArena, KiloBytes(1), 8))
+                    {
+                        AtomicAddU64(&NumPushed, 1);
+                    }
+                }
+            });
+        }
+        for (std::thread& Thread : Threads)
+        {
+            Thread.join();
+        }
+        
+        Check(ConcurrentArena.Used <= ConcurrentArena.ReservedSize);
+        Check(NumPushed > 0 && NumPushed < TEST_NUM_THREADS*1000);
+        Check(!PushSizeAligned(&ConcurrentArena, KiloBytes(1), 8));
+        
+        LinearArenaClear(&ConcurrentArena);
+        Check(ConcurrentArena.Used == 0 && ConcurrentArena.Size <= KiloBytes(64));
+    }
+    LinearArenaRelease(&ConcurrentArena);
+
+    return 0;
+}
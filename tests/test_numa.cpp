@@ -0,0 +1,139 @@
+#include "memory_test.h"
+
+#include <thread>
+#include <vector>
+
+#define TEST_NUM_THREADS 4
+#define TEST_NUM_SLOTS 8
+
+static platform_block_arena SharedArena;
+static volatile u64 SharedBlocks[TEST_NUM_THREADS][TEST_NUM_SLOTS];
+
+inline block* TestExchangeBlock(volatile u64* Slot, block* New)
+{
+    u64 Old = AtomicLoadU64(Slot);
+    for (;;)
+    {
+        u64 Prev = AtomicCompareExchangeU64(Slot, Old, u64(New));
+        if (Prev == Old)
+        {
+            break;
+        }
+        Old = Prev;
+    }
+    return (block*)Old;
+}
+
+static void TestNumaWorker(u32 ThreadId)
+{
+    // NOTE: Threads pin themselves to alternating emulated nodes and free blocks the next thread (on the other node) allocated
+    MemoryNumaSetThreadNode(ThreadId);
+    u32 Node = PlatformBlockArenaGetNode(&SharedArena);
+    Check(Node == ThreadId % 2);
+    for (u32 Round = 0; Round < 100; ++Round)
+    {
+        block_arena Arena = BlockArenaCreate(&SharedArena);
+        for (u32 PushId = 0; PushId < 100; ++PushId)
+        {
+            u8* Mem = (u8*)PushSize(&Arena, 1000);
+            Mem[0] = u8(ThreadId);
+        }
+        for (block* Block = Arena.Next; Block; Block = Block->Next)
+        {
+            Check(Block->ParentBlock->Node == Node);
+        }
+        ArenaClear(&Arena);
+
+        for (u32 SlotId = 0; SlotId < TEST_NUM_SLOTS; ++SlotId)
+        {
+            block* New = PlatformBlockArenaAllocate(&SharedArena);
+            Check(New->ParentBlock->Node == Node);
+            block* Old = TestExchangeBlock(&SharedBlocks[ThreadId][SlotId], New);
+            if (Old)
+            {
+                PlatformBlockArenaFree(&SharedArena, Old);
+            }
+        }
+
+        u32 OtherThreadId = (ThreadId + 1) % TEST_NUM_THREADS;
+        for (u32 SlotId = 0; SlotId < TEST_NUM_SLOTS; ++SlotId)
+        {
+            block* Other = TestExchangeBlock(&SharedBlocks[OtherThreadId][SlotId], 0);
+            if (Other)
+            {
+                PlatformBlockArenaFree(&SharedArena, Other);
+            }
+        }
+        std::this_thread::yield();
+    }
+    PlatformBlockArenaFlushThreadCache(&SharedArena);
+}
+
+int main()
+{
+    MemoryNumaSetEmulation(2);
+
+    // NOTE: Single threaded, blocks come from the pinned node and go back to their own node's list
+    SharedArena = PlatformBlockArenaCreate(MegaBytes(1), 64, 0, PlatformBlockArenaFlag_Numa);
+    Check(SharedArena.NumNodes == 2);
+    MemoryNumaSetThreadNode(0);
+    block* Block0 = PlatformBlockArenaAllocate(&SharedArena);
+    MemoryNumaSetThreadNode(1);
+    block* Block1 = PlatformBlockArenaAllocate(&SharedArena);
+    Check(Block0->ParentBlock != Block1->ParentBlock);
+    Check(Block0->ParentBlock->Node == 0 && Block1->ParentBlock->Node == 1);
+    MemoryNumaSetThreadNode(0);
+    PlatformBlockArenaFree(&SharedArena, Block1);
+    PlatformBlockArenaFree(&SharedArena, Block0);
+    Check(!SharedArena.Next);
+    ArenaClear(&SharedArena);
+
+    // NOTE: Concurrent, every block on a node's free stack has to belong to that node afterwards
+    SharedArena = PlatformBlockArenaCreate(MegaBytes(1), 64, 0, PlatformBlockArenaFlag_Numa | PlatformBlockArenaFlag_Concurrent);
+    std::vector<std::thread> Threads;
+    for (u32 ThreadId = 0; ThreadId < TEST_NUM_THREADS; ++ThreadId)
+    {
+        Threads.emplace_back(TestNumaWorker, ThreadId);
+    }
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+    for (u32 ThreadId = 0; ThreadId < TEST_NUM_THREADS; ++ThreadId)
+    {
+        for (u32 SlotId = 0; SlotId < TEST_NUM_SLOTS; ++SlotId)
+        {
+            block* Block = (block*)SharedBlocks[ThreadId][SlotId];
+            if (Block)
+            {
+                PlatformBlockArenaFree(&SharedArena, Block);
+            }
+        }
+    }
+    PlatformBlockArenaFlushThreadCache(&SharedArena);
+    
+    for (u32 Node = 0; Node < 2; ++Node)
+    {
+        for (u64 Head = SharedArena.Nodes[Node].FreeStack & PLATFORM_BLOCK_PTR_MASK; Head; Head = u64(((block*)Head)->Next))
+        {
+            Check(((block*)Head)->ParentBlock->Node == Node);
+        }
+    }
+    ArenaClear(&SharedArena);
+
+    // NOTE: More nodes than lists, the list index folds but the node we bind to stays the real one
+    MemoryNumaSetEmulation(PLATFORM_BLOCK_MAX_NODES + 4);
+    SharedArena = PlatformBlockArenaCreate(MegaBytes(1), 64, 0, PlatformBlockArenaFlag_Numa);
+    Check(SharedArena.NumNodes == PLATFORM_BLOCK_MAX_NODES);
+    MemoryNumaSetThreadNode(PLATFORM_BLOCK_MAX_NODES + 2);
+    u32 OsNode = 0;
+    Check(PlatformBlockArenaGetNode(&SharedArena, &OsNode) == 2);
+    Check(OsNode == PLATFORM_BLOCK_MAX_NODES + 2);
+    block* FoldedBlock = PlatformBlockArenaAllocate(&SharedArena);
+    Check(FoldedBlock->ParentBlock->Node == 2);
+    PlatformBlockArenaFree(&SharedArena, FoldedBlock);
+    ArenaClear(&SharedArena);
+    MemoryNumaSetEmulation(0);
+    
+    return 0;
+}
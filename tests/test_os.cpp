@@ -0,0 +1,123 @@
+#include "memory_test.h"
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+#if !defined(_WIN32)
+inline b32 TestIsMapped(void* Mem, mm Size)
+{
+    // NOTE: mincore fails with ENOMEM on ranges that aren't mapped
+    unsigned char Residency[64] = {};
+    Assert(Size / MemoryGetPageSize() <= ArrayCount(Residency));
+    b32 Result = mincore(Mem, Size, Residency) == 0;
+    return Result;
+}
+#endif
+
+int main()
+{
+    mm PageSize = MemoryGetPageSize();
+
+    // NOTE: Reserve, commit, decommit and commit again, every call shows up in the stats
+    {
+        memory_os_stats Stats = MemoryOsStats;
+        u8* Mem = (u8*)MemoryReserve(16*PageSize);
+        Check(Mem);
+        Check(MemoryOsStats.NumReserves - Stats.NumReserves == 1);
+
+        Check(MemoryCommit(Mem, 4*PageSize));
+        Check(MemoryOsStats.NumCommits - Stats.NumCommits == 1);
+        for (mm ByteId = 0; ByteId < 4*PageSize; ByteId += 64)
+        {
+            Mem[ByteId] = 0xAB;
+        }
+
+        Check(MemoryDecommit(Mem + 2*PageSize, 2*PageSize));
+        Check(MemoryOsStats.NumDecommits - Stats.NumDecommits == 1);
+        Check(Mem[0] == 0xAB);
+
+        // NOTE: Decommitted pages come back zeroed
+        Check(MemoryCommit(Mem + 2*PageSize, 2*PageSize));
+        for (mm ByteId = 2*PageSize; ByteId < 4*PageSize; ByteId += 64)
+        {
+            Check(Mem[ByteId] == 0);
+        }
+
+        // NOTE: A failed decommit returns false instead of asserting and the pages stay usable
+        Check(!MemoryDecommit(Mem + 1, PageSize));
+        Mem[1] = 0xCD;
+        Check(Mem[1] == 0xCD);
+
+        MemoryRelease(Mem, 16*PageSize);
+        Check(MemoryOsStats.NumReleases - Stats.NumReleases == 1);
+    }
+
+    // NOTE: Purged pages stay usable, an eager purge reads back zeroes right away
+    {
+        u8* Mem = (u8*)MemoryAllocate(8*PageSize);
+        Check(Mem);
+        for (mm ByteId = 0; ByteId < 8*PageSize; ++ByteId)
+        {
+            Mem[ByteId] = 0x5A;
+        }
+
+        u64 NumPurges = MemoryOsStats.NumPurges;
+        Check(MemoryPurge(Mem, 4*PageSize));
+        Check(MemoryOsStats.NumPurges - NumPurges == 1);
+        for (mm ByteId = 0; ByteId < 4*PageSize; ByteId += 64)
+        {
+            Check(Mem[ByteId] == 0);
+        }
+        Check(Mem[4*PageSize] == 0x5A);
+
+        // NOTE: Lazy purges may keep the old contents, all we can check is that the pages still work
+        Check(MemoryPurge(Mem + 4*PageSize, 4*PageSize, true));
+        Mem[4*PageSize] = 1;
+        Check(Mem[4*PageSize] == 1);
+
+        MemoryFree(Mem, 8*PageSize);
+    }
+
+    // NOTE: Sized free takes the size we allocated with, not the rounded one, and unmaps all of it
+    {
+        mm Size = 3*PageSize + 100;
+        u8* Mem = (u8*)MemoryAllocate(Size);
+        Check(Mem);
+        Check(MemoryGetAllocSize(Size, 0) == 4*PageSize);
+        Mem[4*PageSize - 1] = 1;
+
+        u64 NumReleases = MemoryOsStats.NumReleases;
+        MemoryFree(Mem, Size);
+        Check(MemoryOsStats.NumReleases - NumReleases == 1);
+#if !defined(_WIN32)
+        Check(!TestIsMapped(Mem, 4*PageSize));
+#endif
+    }
+
+    // NOTE: Aligned reservations, and untracked calls stay out of the stats
+    {
+        memory_os_stats Stats = MemoryOsStats;
+        void* Aligned = MemoryAllocateAligned(KiloBytes(64), MegaBytes(2));
+        Check(Aligned && GetAlignOffset(Aligned, MegaBytes(2)) == 0);
+        Check(MemoryOsStats.NumReserves - Stats.NumReserves == 1);
+        MemoryFree(Aligned, KiloBytes(64));
+
+        Stats = MemoryOsStats;
+        void* Reserved = MemoryReserve(KiloBytes(64), MemoryFlag_Untracked);
+        void* ReservedAligned = MemoryReserveAligned(KiloBytes(64), MegaBytes(2), MemoryFlag_Untracked);
+        void* Allocated = MemoryAllocate(KiloBytes(64), MemoryFlag_Untracked);
+        void* AllocatedAligned = MemoryAllocateAligned(KiloBytes(64), MegaBytes(2), MemoryFlag_Untracked);
+        Check(Reserved && ReservedAligned && Allocated && AllocatedAligned);
+        Check(GetAlignOffset(ReservedAligned, MegaBytes(2)) == 0);
+        MemoryRelease(Reserved, KiloBytes(64), MemoryFlag_Untracked);
+        MemoryRelease(ReservedAligned, KiloBytes(64), MemoryFlag_Untracked);
+        MemoryFree(Allocated, KiloBytes(64), MemoryFlag_Untracked);
+        MemoryFree(AllocatedAligned, KiloBytes(64), MemoryFlag_Untracked);
+        Check(MemoryOsStats.NumReserves == Stats.NumReserves);
+        Check(MemoryOsStats.NumCommits == Stats.NumCommits);
+        Check(MemoryOsStats.NumReleases == Stats.NumReleases);
+    }
+
+    return 0;
+}
@@ -0,0 +1,374 @@
+#include "memory_test.h"
+
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+inline mm TestCountResidentPages(void* Mem, mm Size)
+{
+    // NOTE: Platform blocks in these tests are 1MB so THP never backs them with a huge page behind our back
+    mm Result = 0;
+#if !defined(_WIN32)
+    mm PageSize = MemoryGetPageSize();
+    u8* Start = (u8*)(mm(Mem) & ~(PageSize - 1));
+    mm NumPages = (mm((u8*)Mem + Size) - mm(Start) + PageSize - 1) / PageSize;
+
+    unsigned char Residency[1024] = {};
+    Assert(NumPages <= ArrayCount(Residency));
+    Check(mincore(Start, NumPages*PageSize, Residency) == 0);
+    for (mm PageId = 0; PageId < NumPages; ++PageId)
+    {
+        Result += Residency[PageId] & 1;
+    }
+#endif
+    return Result;
+}
+
+inline mm TestUntouchedSize(platform_block_arena* Arena, platform_block_header* Header)
+{
+    // NOTE: Space past the last carved block, the first page of it may hold the tail of the last carved block
+    mm PageSize = MemoryGetPageSize();
+    u8* Start = (u8*)PlatformBlockArenaGetBlockById(Arena, Header, Header->NumCarvedBlocks);
+    Start = (u8*)AlignAddress(u64(Start), u64(PageSize));
+    mm Result = (u8*)Header + Arena->PlatformBlockSize - Start;
+    return Result;
+}
+
+inline block* TestLinkChain(block** Blocks, mm NumBlocks)
+{
+    for (mm BlockId = 0; BlockId < NumBlocks; ++BlockId)
+    {
+        Blocks[BlockId]->Prev = BlockId > 0 ? Blocks[BlockId - 1] : 0;
+        Blocks[BlockId]->Next = BlockId + 1 < NumBlocks ? Blocks[BlockId + 1] : 0;
+    }
+    return Blocks[0];
+}
+
+inline u32 TestCountPlatformBlocks(platform_block_arena* Arena)
+{
+    u32 Result = 0;
+    for (platform_block_header* Header = Arena->Next; Header; Header = Header->Next)
+    {
+        Result += 1;
+    }
+    return Result;
+}
+
+inline mm TestSumPurgeSize(platform_block_arena* Arena, block** Blocks, mm NumBlocks)
+{
+    // NOTE: Blocks aren't page multiples so each one gives back a slightly different number of whole pages
+    mm Result = 0;
+    for (mm BlockId = 0; BlockId < NumBlocks; ++BlockId)
+    {
+        u8* PurgeStart = 0;
+        Result += PlatformBlockGetPurgeRange(Arena, Blocks[BlockId], &PurgeStart);
+    }
+    return Result;
+}
+
+inline void TestWaitForDecay(u64 DecayNs)
+{
+    u64 StartNs = MemoryGetTimeNs();
+    while (MemoryGetTimeNs() - StartNs <= DecayNs)
+    {
+    }
+}
+
+int main()
+{
+    // NOTE: Mapping a platform block only touches the header and the blocks we carve, freed blocks get reused before carving more
+    {
+        platform_block_arena Arena = PlatformBlockArenaCreate(MegaBytes(1), 16);
+        mm NumBlocks = PlatformBlockArenaNumBlocks(&Arena);
+        Check(NumBlocks == 16);
+
+        block* Blocks[16] = {};
+        Blocks[0] = PlatformBlockArenaAllocate(&Arena);
+        platform_block_header* Header = Arena.Next;
+        Check(Header && Header->NumCarvedBlocks == 1);
+        Check(Blocks[0] == PlatformBlockArenaGetBlockById(&Arena, Header, 0));
+        Check(TestCountResidentPages(Header, Arena.PlatformBlockSize) <= 2);
+
+        for (u32 BlockId = 1; BlockId < 4; ++BlockId)
+        {
+            Blocks[BlockId] = PlatformBlockArenaAllocate(&Arena);
+            Check(Header->NumCarvedBlocks == BlockId + 1);
+        }
+        u8* Untouched = (u8*)Header + Arena.PlatformBlockSize - TestUntouchedSize(&Arena, Header);
+        Check(TestCountResidentPages(Untouched, TestUntouchedSize(&Arena, Header)) == 0);
+
+        // NOTE: Residency only grows with what we write into carved blocks
+        mm Resident = TestCountResidentPages(Header, Arena.PlatformBlockSize);
+        Check(Resident <= 5);
+        memset(BlockGetData(Blocks[2], u8), 1, Arena.BlockSize - sizeof(block));
+        Check(TestCountResidentPages(Header, Arena.PlatformBlockSize) >= Resident + (Arena.BlockSize / MemoryGetPageSize()) - 2);
+        Check(TestCountResidentPages(Untouched, TestUntouchedSize(&Arena, Header)) == 0);
+
+        platform_block_arena_stats Stats = PlatformBlockArenaGetStats(&Arena);
+        Check(Stats.MappedSize == Arena.PlatformBlockSize);
+        Check(Stats.ResidentSize == PlatformBlockArenaGetHeaderSize() + 4*Arena.BlockSize);
+
+        // NOTE: A freed block comes back before we carve a new one
+        PlatformBlockArenaFree(&Arena, Blocks[1]);
+        Check(PlatformBlockArenaAllocate(&Arena) == Blocks[1]);
+        Check(Header->NumCarvedBlocks == 4);
+
+        // NOTE: Carving runs to the end of the platform block, only then does a new one get mapped
+        for (u32 BlockId = 4; BlockId < NumBlocks; ++BlockId)
+        {
+            Blocks[BlockId] = PlatformBlockArenaAllocate(&Arena);
+            Check(Blocks[BlockId] == PlatformBlockArenaGetBlockById(&Arena, Header, BlockId));
+        }
+        Check(Header->NumCarvedBlocks == NumBlocks && Header->NumFreeBlocks == 0);
+        Check(!Arena.Nodes[0].FreeList && !Arena.Next->Next);
+
+        block* Next = PlatformBlockArenaAllocate(&Arena);
+        Check(Next->ParentBlock != Header && Arena.Next->Next);
+        Check(Next->ParentBlock->NumCarvedBlocks == 1);
+
+        ArenaClear(&Arena);
+    }
+
+    // NOTE: Concurrent arenas carve a result plus half a magazine at a time and leave the rest of the platform block untouched
+    {
+        platform_block_arena Arena = PlatformBlockArenaCreate(MegaBytes(1), 64, 0, PlatformBlockArenaFlag_Concurrent);
+        block* First = PlatformBlockArenaAllocate(&Arena);
+        platform_block_header* Header = First->ParentBlock;
+        Check(Header->NumCarvedBlocks == 1 + PLATFORM_BLOCK_MAGAZINE_SIZE / 2);
+
+        u8* Untouched = (u8*)Header + Arena.PlatformBlockSize - TestUntouchedSize(&Arena, Header);
+        Check(TestCountResidentPages(Untouched, TestUntouchedSize(&Arena, Header)) == 0);
+
+        // NOTE: The magazine serves the next allocations without carving
+        for (u32 BlockId = 0; BlockId < PLATFORM_BLOCK_MAGAZINE_SIZE / 2; ++BlockId)
+        {
+            Check(PlatformBlockArenaAllocate(&Arena)->ParentBlock == Header);
+        }
+        Check(Header->NumCarvedBlocks == 1 + PLATFORM_BLOCK_MAGAZINE_SIZE / 2);
+        PlatformBlockArenaAllocate(&Arena);
+        Check(Header->NumCarvedBlocks == 2 + PLATFORM_BLOCK_MAGAZINE_SIZE);
+
+        PlatformBlockArenaFlushThreadCache(&Arena);
+        ArenaClear(&Arena);
+    }
+
+
+    // NOTE: Batches take whole runs from each platform block, chains free a run per platform block and give empty ones back
+    {
+        platform_block_arena Arena = PlatformBlockArenaCreate(MegaBytes(1), 16);
+        block* Blocks[40] = {};
+        PlatformBlockArenaAllocateBatch(&Arena, Blocks, 40);
+        Check(TestCountPlatformBlocks(&Arena) == 3);
+        for (u32 BlockId = 0; BlockId < 40; ++BlockId)
+        {
+            Check(Blocks[BlockId] && !Blocks[BlockId]->Next && !Blocks[BlockId]->Prev);
+            Check(Blocks[BlockId]->ParentBlock->NumCarvedBlocks > (BlockId % 16));
+            for (u32 OtherId = 0; OtherId < BlockId; ++OtherId)
+            {
+                Check(Blocks[OtherId] != Blocks[BlockId]);
+            }
+        }
+        platform_block_header* Full = Blocks[0]->ParentBlock;
+        platform_block_header* Partial = Blocks[39]->ParentBlock;
+        Check(Full->NumFreeBlocks == 0 && Partial->NumFreeBlocks == 8);
+
+        // NOTE: A chain mixing platform blocks, each run lands on its own platform block
+        block* Mixed[] = { Blocks[0], Blocks[1], Blocks[2], Blocks[35], Blocks[36] };
+        Check(PlatformBlockArenaFreeChain(&Arena, TestLinkChain(Mixed, ArrayCount(Mixed))) == ArrayCount(Mixed));
+        Check(Full->NumFreeBlocks == 3 && Full->NumDirtyBlocks == 3);
+        Check(Partial->NumFreeBlocks == 10);
+
+        // NOTE: The refilled platform block went to the front of the free list, the batch drains it before moving to the next one
+        block* Reused[5] = {};
+        PlatformBlockArenaAllocateBatch(&Arena, Reused, 5);
+        Check(TestCountPlatformBlocks(&Arena) == 3);
+        u32 NumFromFull = 0;
+        for (u32 BlockId = 0; BlockId < 5; ++BlockId)
+        {
+            NumFromFull += Reused[BlockId]->ParentBlock == Full ? 1 : 0;
+        }
+        Check(NumFromFull == 3);
+        Check(Full->NumFreeBlocks + Partial->NumFreeBlocks == 8);
+
+        // NOTE: Freeing every block as one chain releases all platform blocks
+        block* All[40] = {};
+        mm NumAll = 0;
+        for (u32 BlockId = 3; BlockId < 40; ++BlockId)
+        {
+            if (BlockId != 35 && BlockId != 36)
+            {
+                All[NumAll++] = Blocks[BlockId];
+            }
+        }
+        for (u32 BlockId = 0; BlockId < 5; ++BlockId)
+        {
+            All[NumAll++] = Reused[BlockId];
+        }
+        Check(NumAll == 40);
+        Check(PlatformBlockArenaFreeChain(&Arena, TestLinkChain(All, NumAll)) == 40);
+        Check(!Arena.Next && !Arena.Nodes[0].FreeList);
+        ArenaClear(&Arena);
+    }
+
+    // NOTE: Clearing a block arena hands its whole chain back through FreeChain
+    {
+        platform_block_arena PlatformArena = PlatformBlockArenaCreate(MegaBytes(1), 16);
+        block_arena Arena = BlockArenaCreate(&PlatformArena);
+        for (u32 PushId = 0; PushId < 100; ++PushId)
+        {
+            Check(PushSize(&Arena, KiloBytes(32)));
+        }
+        Check(TestCountPlatformBlocks(&PlatformArena) >= 4);
+        ArenaClear(&Arena);
+        Check(!Arena.Next && !PlatformArena.Next);
+        ArenaClear(&PlatformArena);
+    }
+
+    // NOTE: Concurrent batches carve under one lock and chains go to the node stack in one push, then come back from it
+    {
+        platform_block_arena Arena = PlatformBlockArenaCreate(MegaBytes(1), 64, 0, PlatformBlockArenaFlag_Concurrent);
+        block* Blocks[40] = {};
+        PlatformBlockArenaAllocateBatch(&Arena, Blocks, 40);
+        platform_block_header* Header = Blocks[0]->ParentBlock;
+        Check(Header->NumCarvedBlocks == 40 && !Header->Next);
+        for (u32 BlockId = 0; BlockId < 40; ++BlockId)
+        {
+            Check(Blocks[BlockId] == PlatformBlockArenaGetBlockById(&Arena, Header, BlockId));
+            Check(!Blocks[BlockId]->Next && !Blocks[BlockId]->Prev);
+        }
+
+        Check(PlatformBlockArenaFreeChain(&Arena, TestLinkChain(Blocks, 40)) == 40);
+        Check(AtomicLoadU64(&Arena.Nodes[0].NumStackBlocks) == 40);
+
+        block* Again[40] = {};
+        PlatformBlockArenaAllocateBatch(&Arena, Again, 40);
+        Check(AtomicLoadU64(&Arena.Nodes[0].NumStackBlocks) == 0);
+        Check(Header->NumCarvedBlocks == 40);
+        for (u32 BlockId = 0; BlockId < 40; ++BlockId)
+        {
+            Check(Again[BlockId]->ParentBlock == Header && !Again[BlockId]->Next && !Again[BlockId]->Prev);
+        }
+
+        PlatformBlockArenaFreeChain(&Arena, TestLinkChain(Again, 40));
+        PlatformBlockArenaFlushThreadCache(&Arena);
+        ArenaClear(&Arena);
+    }
+
+
+    // NOTE: Purging gives back the pages of decayed free blocks, stops at MaxPurgeSize and picks up where it stopped on the next call
+    {
+        platform_block_arena Arena = PlatformBlockArenaCreate(MegaBytes(1), 16);
+        block* Blocks[24] = {};
+        PlatformBlockArenaAllocateBatch(&Arena, Blocks, 24);
+        for (u32 BlockId = 0; BlockId < 24; ++BlockId)
+        {
+            memset(BlockGetData(Blocks[BlockId], u8), 1, Arena.BlockSize - sizeof(block));
+        }
+
+        // NOTE: Free 4 blocks out of each platform block, they stay dirty within the decay time
+        PlatformBlockArenaSetDecay(&Arena, u64(3600)*1000000000);
+        block* Freed[8] = { Blocks[0], Blocks[1], Blocks[2], Blocks[3], Blocks[16], Blocks[17], Blocks[18], Blocks[19] };
+        mm FreedPurgeSize = TestSumPurgeSize(&Arena, Freed, 8);
+        PlatformBlockArenaFreeChain(&Arena, TestLinkChain(Freed, 8));
+        platform_block_arena_stats Stats = PlatformBlockArenaGetStats(&Arena);
+        Check(Stats.MappedSize == 2*Arena.PlatformBlockSize);
+        Check(Stats.DirtySize == 8*Arena.BlockSize && Stats.PurgedSize == 0);
+        Check(Stats.ResidentSize == 2*PlatformBlockArenaGetHeaderSize() + 24*Arena.BlockSize);
+        Check(PlatformBlockArenaPurge(&Arena) == 0);
+
+        // NOTE: Without a decay time nothing gets purged
+        PlatformBlockArenaSetDecay(&Arena, 0);
+        Check(PlatformBlockArenaPurge(&Arena) == 0);
+
+        // NOTE: One block per call with the smallest budget, each call shows up in the stats and drops the blocks pages
+        PlatformBlockArenaSetDecay(&Arena, 1);
+        TestWaitForDecay(1);
+        u64 NumPurges = MemoryOsStats.NumPurges;
+        mm FirstPurgeSize = PlatformBlockArenaPurge(&Arena, 1);
+        Check(FirstPurgeSize > 0 && FirstPurgeSize < Arena.BlockSize);
+        Check(MemoryOsStats.NumPurges == NumPurges + 1);
+        Stats = PlatformBlockArenaGetStats(&Arena);
+        Check(Stats.DirtySize == 7*Arena.BlockSize && Stats.PurgedSize == FirstPurgeSize);
+        Check(Stats.ResidentSize == 2*PlatformBlockArenaGetHeaderSize() + 24*Arena.BlockSize - FirstPurgeSize);
+
+        u32 NumPurgedBlocks = 0;
+        for (u32 FreedId = 0; FreedId < 8; ++FreedId)
+        {
+            u8* PurgeStart = 0;
+            mm PurgeSize = PlatformBlockGetPurgeRange(&Arena, Freed[FreedId], &PurgeStart);
+            NumPurgedBlocks += TestCountResidentPages(PurgeStart, PurgeSize) == 0 ? 1 : 0;
+        }
+        Check(NumPurgedBlocks == 1);
+
+        u32 NumCalls = 1;
+        while (PlatformBlockArenaPurge(&Arena, 1))
+        {
+            NumCalls += 1;
+        }
+        Check(NumCalls == 8);
+        Stats = PlatformBlockArenaGetStats(&Arena);
+        Check(Stats.DirtySize == 0 && Stats.PurgedSize == FreedPurgeSize);
+        Check(PlatformBlockArenaPurge(&Arena) == 0);
+
+        // NOTE: A call that runs out of budget stays on its platform block instead of skipping the rest of its dirty blocks
+        block* Drained[2] = { Blocks[5], Blocks[6] };
+        FreedPurgeSize += TestSumPurgeSize(&Arena, Drained, 2);
+        PlatformBlockArenaFreeChain(&Arena, TestLinkChain(Drained, 2));
+        TestWaitForDecay(1);
+        Check(PlatformBlockArenaPurge(&Arena, 1) > 0);
+        Check(PlatformBlockArenaPurge(&Arena, 1) > 0);
+        Check(PlatformBlockArenaPurge(&Arena, 1) == 0);
+        Check(PlatformBlockArenaGetStats(&Arena).PurgedSize == FreedPurgeSize);
+
+        // NOTE: Dirty blocks get reused before purged ones, taking a purged block takes it out of the stats
+        TestWaitForDecay(1);
+        PlatformBlockArenaFree(&Arena, Blocks[4]);
+        Check(PlatformBlockArenaAllocate(&Arena) == Blocks[4]);
+        block* Reused = PlatformBlockArenaAllocate(&Arena);
+        Check(Reused->ParentBlock == Blocks[0]->ParentBlock || Reused->ParentBlock == Blocks[16]->ParentBlock);
+        Stats = PlatformBlockArenaGetStats(&Arena);
+        Check(Stats.PurgedSize == FreedPurgeSize - TestSumPurgeSize(&Arena, &Reused, 1));
+        
+        ArenaClear(&Arena);
+        Check(PlatformBlockArenaGetStats(&Arena).PurgedSize == 0);
+    }
+
+    // NOTE: Concurrent arenas purge the node stacks, blocks popped off them leave the purged stats
+    {
+        platform_block_arena Arena = PlatformBlockArenaCreate(MegaBytes(1), 64, 0, PlatformBlockArenaFlag_Concurrent);
+        PlatformBlockArenaSetDecay(&Arena, 1);
+        block* Blocks[40] = {};
+        PlatformBlockArenaAllocateBatch(&Arena, Blocks, 40);
+        mm TotalPurgeSize = TestSumPurgeSize(&Arena, Blocks, 40);
+
+        PlatformBlockArenaFreeChain(&Arena, TestLinkChain(Blocks, 40));
+        platform_block_arena_stats Stats = PlatformBlockArenaGetStats(&Arena);
+        Check(Stats.DirtySize == 40*Arena.BlockSize && Stats.PurgedSize == 0);
+
+        TestWaitForDecay(1);
+        mm FirstPurgeSize = PlatformBlockArenaPurge(&Arena, 1);
+        Check(FirstPurgeSize > 0 && FirstPurgeSize < Arena.BlockSize);
+        Stats = PlatformBlockArenaGetStats(&Arena);
+        Check(Stats.DirtySize == 39*Arena.BlockSize && Stats.PurgedSize == FirstPurgeSize);
+        Check(AtomicLoadU64(&Arena.Nodes[0].NumStackBlocks) == 40);
+
+        Check(PlatformBlockArenaPurge(&Arena) == TotalPurgeSize - FirstPurgeSize);
+        Check(PlatformBlockArenaPurge(&Arena) == 0);
+        Stats = PlatformBlockArenaGetStats(&Arena);
+        Check(Stats.DirtySize == 0 && Stats.PurgedSize == TotalPurgeSize);
+
+        block* Again[8] = {};
+        PlatformBlockArenaAllocateBatch(&Arena, Again, 8);
+        Stats = PlatformBlockArenaGetStats(&Arena);
+        Check(Stats.PurgedSize == TotalPurgeSize - TestSumPurgeSize(&Arena, Again, 8));
+        Check(AtomicLoadU64(&Arena.NumPurgedBlocks) == 32);
+
+        PlatformBlockArenaFreeChain(&Arena, TestLinkChain(Again, 8));
+        PlatformBlockArenaFlushThreadCache(&Arena);
+        ArenaClear(&Arena);
+    }
+
+    return 0;
+}
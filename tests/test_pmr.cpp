@@ -0,0 +1,102 @@
+#include "memory_test.h"
+#include "memory_pmr.h"
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+int main()
+{
+    // NOTE: A fixed arena that fills up between allocate and deallocate has to send arena memory back to the arena, not upstream
+    {
+        alignas(16) static u8 Buffer[KiloBytes(4)];
+        linear_arena Arena = LinearArenaCreate(Buffer, sizeof(Buffer));
+        arena_memory_resource<linear_arena> Resource(&Arena);
+        
+        void* First = Resource.allocate(1000, 8);
+        void* Second = Resource.allocate(3000, 8);
+        Check((u8*)First >= Buffer && (u8*)Second < Buffer + sizeof(Buffer));
+        void* Upstream = Resource.allocate(500, 8);
+        Check((u8*)Upstream < Buffer || (u8*)Upstream >= Buffer + sizeof(Buffer));
+        
+        Resource.deallocate(First, 1000, 8);
+        Resource.deallocate(Upstream, 500, 8);
+        Resource.deallocate(Second, 3000, 8);
+        Check(Arena.Used == 1000);
+    }
+    
+    // NOTE: Containers inside a temp mem need no frees, EndTempMem takes everything back
+    linear_arena LinearArena = LinearArenaReserve(MegaBytes(256));
+    {
+        temp_mem TempMem = BeginTempMem(&LinearArena);
+        arena_memory_resource<linear_arena> Resource(&LinearArena);
+        std::pmr::vector<u32> Vector(&Resource);
+        for (u32 Id = 0; Id < 100000; ++Id)
+        {
+            Vector.push_back(Id);
+        }
+        Check(LinearArena.Used <= 2*Vector.capacity()*sizeof(u32));
+        
+        std::pmr::unordered_map<u32, std::pmr::string> Map(&Resource);
+        for (u32 Id = 0; Id < 10000; ++Id)
+        {
+            Map[Id] = std::pmr::string("a string that is too long for the small string buffer", &Resource);
+        }
+        Map.erase(5);
+        Check(Map.size() == 9999 && Vector[500] == 500 && Map[7].size() > 16);
+        EndTempMem(TempMem);
+    }
+    Check(LinearArena.Used == 0);
+    LinearArenaRelease(&LinearArena);
+
+    dynamic_arena DynamicArena = DynamicArenaCreate(KiloBytes(64));
+    {
+        dynamic_temp_mem TempMem = BeginTempMem(&DynamicArena);
+        arena_memory_resource<dynamic_arena> Resource(&DynamicArena);
+        std::pmr::vector<u64> Vector(&Resource);
+        for (u64 Id = 0; Id < 200000; ++Id)
+        {
+            Vector.push_back(Id);
+        }
+
+        arena_allocator<u32, dynamic_arena> Allocator(&DynamicArena);
+        std::vector<u32, arena_allocator<u32, dynamic_arena>> Values(Allocator);
+        for (u32 Id = 0; Id < 1000; ++Id)
+        {
+            Values.push_back(Id);
+        }
+        
+        using map_allocator = arena_allocator<std::pair<const u32, u32>, dynamic_arena>;
+        std::map<u32, u32, std::less<u32>, map_allocator> Map{map_allocator(&DynamicArena)};
+        for (u32 Id = 0; Id < 1000; ++Id)
+        {
+            Map[Id] = Id*2;
+        }
+        Map.erase(10);
+        Check(Vector[199999] == 199999 && Values[999] == 999 && Map[5] == 10 && Map.size() == 999);
+        EndTempMem(TempMem);
+    }
+    DynamicArenaRelease(&DynamicArena);
+
+    // NOTE: Block arenas serve up to a block, the vector outgrows that and moves upstream
+    platform_block_arena PlatformArena = PlatformBlockArenaCreate(KiloBytes(64), 16);
+    block_arena BlockArena = BlockArenaCreate(&PlatformArena);
+    {
+        arena_memory_resource<block_arena> Resource(&BlockArena);
+        std::pmr::vector<u64> Vector(&Resource);
+        for (u64 Id = 0; Id < 100000; ++Id)
+        {
+            Vector.push_back(Id);
+        }
+        std::pmr::map<u32, u32> Map(&Resource);
+        for (u32 Id = 0; Id < 1000; ++Id)
+        {
+            Map[Id] = Id;
+        }
+        Check(Vector[99999] == 99999 && Map[999] == 999);
+    }
+    ArenaClear(&BlockArena);
+    ArenaClear(&PlatformArena);
+    
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "memory_test.h"
+
+struct alignas(32) test_simd_type
+{
+    f32 Values[8];
+};
+
+struct test_constructed_type
+{
+    i32 A;
+    f64 B;
+
+    test_constructed_type() : A(42) {}
+    test_constructed_type(i32 InA, f64 InB) : A(InA), B(InB) {}
+};
+
+template<typename arena>
+static void TestPush(arena* Arena)
+{
+    // NOTE: Odd sized pushes in between so every typed push has to fix up the alignment itself
+    PushSize(Arena, 3);
+    f64* Double = PushStruct(Arena, f64);
+    Check((mm(Double) & (alignof(f64) - 1)) == 0);
+    PushSize(Arena, 1);
+    
+    test_simd_type* Simd = Push<test_simd_type>(Arena, 4, PushFlag_Zero);
+    Check((mm(Simd) & 31) == 0);
+    for (u32 ElementId = 0; ElementId < 4; ++ElementId)
+    {
+        for (u32 ValueId = 0; ValueId < 8; ++ValueId)
+        {
+            Check(Simd[ElementId].Values[ValueId] == 0);
+        }
+    }
+
+    // NOTE: Zeroed before construction, so members the constructor skips are 0
+    test_constructed_type* Constructed = Push<test_constructed_type>(Arena, 10, PushFlag_Zero | PushFlag_Construct);
+    for (u32 ElementId = 0; ElementId < 10; ++ElementId)
+    {
+        Check(Constructed[ElementId].A == 42 && Constructed[ElementId].B == 0);
+    }
+
+    test_constructed_type* New = PushNew<test_constructed_type, push_unchecked>(Arena, 7, 2.5);
+    Check(New->A == 7 && New->B == 2.5);
+    
+    PushSize(Arena, 5);
+    u8* Bytes = Push<u8, push_checked>(Arena, 100);
+    Bytes[99] = 1;
+    u64* Array = PushArray(Arena, u64, 3);
+    Check((mm(Array) & (alignof(u64) - 1)) == 0);
+    u64* Aligned = Push<u64>(Arena, 1, PushFlag_None, 128);
+    Check((mm(Aligned) & 127) == 0);
+}
+
+int main()
+{
+    // NOTE: Failed pushes hand back 0 without zeroing or constructing through it, even with the checks compiled out
+    linear_arena SmallArena = LinearArenaReserve(KiloBytes(64), KiloBytes(64));
+    mm NumPushed = 0;
+    for (;;)
+    {
+        test_constructed_type* Pushed = Push<test_constructed_type, push_unchecked>(&SmallArena, 64, PushFlag_Zero | PushFlag_Construct);
+        if (!Pushed)
+        {
+            break;
+        }
+        NumPushed += 1;
+    }
+    Check(NumPushed == KiloBytes(64) / (64*sizeof(test_constructed_type)));
+    Check((!PushNew<test_constructed_type, push_unchecked>(&SmallArena, 1, 2.0)));
+    Check((!Push<u8, push_unchecked>(&SmallArena, KiloBytes(64), PushFlag_Zero)));
+    LinearArenaRelease(&SmallArena);
+
+    linear_arena LinearArena = LinearArenaReserve(MegaBytes(1));
+    TestPush(&LinearArena);
+    LinearArenaRelease(&LinearArena);
+
+    dynamic_arena DynamicArena = DynamicArenaCreate(KiloBytes(4));
+    TestPush(&DynamicArena);
+    DynamicArenaRelease(&DynamicArena);
+
+    platform_block_arena PlatformArena = PlatformBlockArenaCreate(KiloBytes(256), 16);
+    block_arena BlockArena = BlockArenaCreate(&PlatformArena);
+    TestPush(&BlockArena);
+    ArenaClear(&BlockArena);
+    ArenaClear(&PlatformArena);
+    
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "memory_test.h"
+
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+struct test_record
+{
+    u32 Length;
+    u32 ProducerId;
+    u32 Sequence;
+};
+
+static void TestRing(u32 ArenaFlags, u32 NumProducers, u32 RecordsPerProducer)
+{
+    ring_arena Arena = RingArenaCreate(5000, ArenaFlags);
+    Check(Arena.Size >= 5000 && (Arena.Size & (Arena.Size - 1)) == 0);
+    
+    // NOTE: Both views see the same pages
+    Arena.Mem[3] = 7;
+    Check(Arena.Mem[Arena.Size + 3] == 7);
+
+    // NOTE: SPSC producers reserve more than they write and commit the short size, MPSC producers commit what they reserved
+    b32 IsMultiProducer = ArenaFlags & RingArenaFlag_MultiProducer;
+    std::vector<std::thread> Producers;
+    for (u32 ProducerId = 0; ProducerId < NumProducers; ++ProducerId)
+    {
+        Producers.emplace_back([&, ProducerId]()
+        {
+            for (u32 Sequence = 0; Sequence < RecordsPerProducer; ++Sequence)
+            {
+                u32 Length = sizeof(test_record) + ((Sequence*37) % 900 & ~7u) + 4;
+                ring_write Write = RingArenaBeginWrite(&Arena, Length + 64);
+                while (!Write.Mem)
+                {
+                    std::this_thread::yield();
+                    Write = RingArenaBeginWrite(&Arena, Length + 64);
+                }
+                
+                if (IsMultiProducer)
+                {
+                    Length += 64;
+                }
+                else
+                {
+                    Write.Size = Length;
+                }
+
+                test_record* Record = (test_record*)Write.Mem;
+                Record->Length = Length;
+                Record->ProducerId = ProducerId;
+                Record->Sequence = Sequence;
+                for (u32 ByteId = sizeof(test_record); ByteId < Length; ++ByteId)
+                {
+                    Write.Mem[ByteId] = u8(ByteId + Sequence);
+                }
+                RingArenaEndWrite(&Arena, Write);
+            }
+        });
+    }
+
+    // NOTE: Records are read in place, including the ones that run over the end of the buffer into the mirror
+    std::vector<u32> NextSequence(NumProducers, 0);
+    u32 NumRead = 0;
+    b32 Wrapped = false;
+    while (NumRead < NumProducers*RecordsPerProducer)
+    {
+        ring_read Read = RingArenaBeginRead(&Arena);
+        mm Consumed = 0;
+        while (Read.Size - Consumed >= sizeof(test_record))
+        {
+            test_record* Record = (test_record*)(Read.Mem + Consumed);
+            if (Read.Size - Consumed < Record->Length)
+            {
+                break;
+            }
+            
+            Wrapped |= ((Read.Pos + Consumed) & Arena.Mask) + Record->Length > Arena.Size;
+            Check(Record->ProducerId < NumProducers && Record->Sequence == NextSequence[Record->ProducerId]);
+            for (u32 ByteId = sizeof(test_record); ByteId < Record->Length; ++ByteId)
+            {
+                Check(((u8*)Record)[ByteId] == u8(ByteId + Record->Sequence));
+            }
+            
+            NextSequence[Record->ProducerId] += 1;
+            NumRead += 1;
+            Consumed += Record->Length;
+        }
+        
+        RingArenaEndRead(&Arena, Consumed);
+        if (!Consumed)
+        {
+            std::this_thread::yield();
+        }
+    }
+    Check(Wrapped);
+
+    for (std::thread& Producer : Producers)
+    {
+        Producer.join();
+    }
+    RingArenaRelease(&Arena);
+}
+
+int main()
+{
+    // NOTE: Each position owns a whole cache line
+    Check(alignof(ring_arena) == RING_ARENA_CACHE_LINE_SIZE);
+    Check(offsetof(ring_arena, WritePos) % RING_ARENA_CACHE_LINE_SIZE == 0);
+    Check(offsetof(ring_arena, CommitPos) - offsetof(ring_arena, WritePos) == RING_ARENA_CACHE_LINE_SIZE);
+    Check(offsetof(ring_arena, ReadPos) - offsetof(ring_arena, CommitPos) == RING_ARENA_CACHE_LINE_SIZE);
+    Check(sizeof(ring_arena) - offsetof(ring_arena, ReadPos) == RING_ARENA_CACHE_LINE_SIZE);
+    
+    TestRing(RingArenaFlag_None, 1, 10000);
+    TestRing(RingArenaFlag_MultiProducer, 4, 1000);
+    
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include "memory_test.h"
+
+#include <thread>
+
+// NOTE: Pushes its result into Out, the scratch memory it uses on the way can never be the callers arena
+static u32* TestComputeSquares(linear_arena* Out, u32 Count)
+{
+    scratch_mem Scratch = GetScratch(Out);
+    Check(Scratch.Arena != Out);
+
+    u32* Temp = PushArray(Scratch.Arena, u32, Count);
+    for (u32 Id = 0; Id < Count; ++Id)
+    {
+        Temp[Id] = Id * Id;
+    }
+
+    u32* Result = PushArray(Out, u32, Count);
+    for (u32 Id = 0; Id < Count; ++Id)
+    {
+        Result[Id] = Temp[Id];
+    }
+    return Result;
+}
+
+static scratch_mem TestReturnScratch()
+{
+    scratch_mem Result = GetScratch();
+    PushSize(Result.Arena, 100);
+    return Result;
+}
+
+static linear_arena* TestOtherThreadArena;
+
+int main()
+{
+    // NOTE: Scratch memory goes away when the scratch_mem goes out of scope
+    linear_arena* First = 0;
+    mm FirstUsed = 0;
+    {
+        scratch_mem Scratch = GetScratch();
+        First = Scratch.Arena;
+        FirstUsed = First->Used;
+        Check(PushSize(Scratch.Arena, KiloBytes(4)));
+        Check(First->Used == FirstUsed + KiloBytes(4));
+    }
+    Check(First->Used == FirstUsed);
+
+    // NOTE: One conflict, results pushed into the callers scratch arena survive the callees scratch
+    {
+        scratch_mem Outer = GetScratch();
+        Check(Outer.Arena == First);
+        u32* Squares = TestComputeSquares(Outer.Arena, 1000);
+        for (u32 Id = 0; Id < 1000; ++Id)
+        {
+            Check(Squares[Id] == Id * Id);
+        }
+
+        scratch_mem Inner = GetScratch(Outer.Arena);
+        Check(Inner.Arena != Outer.Arena);
+        Squares = TestComputeSquares(Inner.Arena, 10);
+        Check(Squares[9] == 81);
+    }
+
+    // NOTE: Two conflicts, only the ones that are scratch arenas matter
+    {
+        linear_arena Output = LinearArenaReserve(MegaBytes(1));
+        scratch_mem Outer = GetScratch(&Output);
+        Check(Outer.Arena == First);
+
+        scratch_mem Inner = GetScratch(&Output, Outer.Arena);
+        Check(Inner.Arena != Outer.Arena && Inner.Arena != &Output);
+        scratch_mem Swapped = GetScratch(Outer.Arena, &Output);
+        Check(Swapped.Arena == Inner.Arena);
+        LinearArenaRelease(&Output);
+    }
+
+    // NOTE: Array of conflicts
+    {
+        scratch_mem Outer = GetScratch();
+        linear_arena* Conflicts[] = { 0, Outer.Arena, 0 };
+        scratch_mem Inner = GetScratch(Conflicts, ArrayCount(Conflicts));
+        Check(Inner.Arena != Outer.Arena);
+
+        scratch_mem NoConflicts = GetScratch(Conflicts, 0);
+        Check(NoConflicts.Arena == First);
+    }
+
+    // NOTE: Moving a scratch_mem out of a function ends the temp mem exactly once
+    {
+        mm Used = First->Used;
+        {
+            scratch_mem Moved = TestReturnScratch();
+            Check(Moved.Arena == First);
+            Check(First->Used == Used + 100);
+        }
+        Check(First->Used == Used);
+    }
+
+    // NOTE: Steady state doesn't touch the OS
+    {
+        u64 NumReserves = MemoryOsStats.NumReserves;
+        u64 NumCommits = MemoryOsStats.NumCommits;
+        for (u32 Iteration = 0; Iteration < 100; ++Iteration)
+        {
+            scratch_mem Scratch = GetScratch();
+            PushSize(Scratch.Arena, KiloBytes(16));
+        }
+        Check(MemoryOsStats.NumReserves == NumReserves);
+        Check(MemoryOsStats.NumCommits == NumCommits);
+    }
+
+    // NOTE: Every thread has its own pool
+    {
+        std::thread Thread([]()
+        {
+            scratch_mem Scratch = GetScratch();
+            TestOtherThreadArena = Scratch.Arena;
+            PushSize(Scratch.Arena, 64);
+            ScratchArenasRelease();
+            Scratch.Arena = 0;
+        });
+        Thread.join();
+        Check(TestOtherThreadArena && TestOtherThreadArena != First);
+    }
+
+    // NOTE: Released arenas get reserved again on the next use
+    ScratchArenasRelease();
+    Check(!First->Mem);
+    {
+        scratch_mem Scratch = GetScratch();
+        Check(Scratch.Arena == First && First->Mem);
+    }
+    ScratchArenasRelease();
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "memory_test.h"
+
+#include <vector>
+
+struct test_alloc
+{
+    u32* Mem;
+    mm Size;
+    u32 Value;
+};
+
+inline u32 TestCountSlabs(slab_header* List)
+{
+    u32 Result = 0;
+    for (slab_header* Slab = List; Slab; Slab = Slab->Next)
+    {
+        Result += 1;
+    }
+    return Result;
+}
+
+inline u32 TestCountPlatformFree(platform_block_arena* PlatformArena)
+{
+    u32 Result = 0;
+    for (platform_block_header* Header = PlatformArena->Next; Header; Header = Header->Next)
+    {
+        Result += Header->NumFreeBlocks;
+    }
+    return Result;
+}
+
+int main()
+{
+    // NOTE: Classes go 16, 24, 32, 48, 64, ... and every size maps to the smallest class that holds it
+    {
+        Check(SlabArenaGetClassSize(0) == 16);
+        Check(SlabArenaGetClassSize(1) == 24);
+        Check(SlabArenaGetClassSize(2) == 32);
+        Check(SlabArenaGetClassSize(3) == 48);
+        Check(SlabArenaGetClassSize(4) == 64);
+        for (u32 ClassId = 1; ClassId < SLAB_ARENA_MAX_CLASSES; ++ClassId)
+        {
+            mm ClassSize = SlabArenaGetClassSize(ClassId);
+            mm PrevSize = SlabArenaGetClassSize(ClassId - 1);
+            Check(ClassSize > PrevSize && ClassSize <= 2*PrevSize);
+        }
+
+        for (mm Size = 0; Size <= KiloBytes(64); ++Size)
+        {
+            u32 ClassId = SlabArenaGetClassId(Size);
+            Check(SlabArenaGetClassSize(ClassId) >= Size);
+            Check(ClassId == 0 || SlabArenaGetClassSize(ClassId - 1) < Size);
+        }
+    }
+
+    platform_block_arena PlatformArena = PlatformBlockArenaCreate(KiloBytes(64), 16, 0, PlatformBlockArenaFlag_Aligned);
+    slab_arena Arena = SlabArenaCreate(&PlatformArena);
+    mm MaxSize = SlabArenaGetMaxSize(&Arena);
+    Check(Arena.NumClasses > 0);
+    Check(MaxSize * SLAB_ARENA_MIN_OBJECTS_PER_SLAB <= PlatformArena.BlockSize);
+
+    // NOTE: Pushes past the biggest class return 0 instead of indexing past the class table
+    {
+        Check(PushSize(&Arena, MaxSize));
+        Check(!PushSize(&Arena, MaxSize + 1));
+        Check(!PushSize(&Arena, MegaBytes(1)));
+        FreeSize(&Arena, 0);
+        ArenaClear(&Arena);
+    }
+
+    // NOTE: Alignment bumps the class when the natural one isn't aligned enough
+    {
+        for (mm Alignment = 4; Alignment <= SLAB_ARENA_DATA_ALIGNMENT; Alignment *= 2)
+        {
+            for (mm Size = 1; Size < 200; Size += 7)
+            {
+                void* Mem = PushSizeAligned(&Arena, Size, Alignment);
+                Check(Mem);
+                Check(GetAlignOffset(Mem, Alignment) == 0);
+            }
+        }
+        ArenaClear(&Arena);
+    }
+
+    // NOTE: Freed objects get reused first and emptied slabs are cached, then given back
+    {
+        u32 ClassId = SlabArenaGetClassId(48);
+        slab_class* Class = Arena.Classes + ClassId;
+        u32 NumObjects = Class->NumObjectsPerSlab;
+
+        std::vector<void*> Allocs;
+        for (u32 AllocId = 0; AllocId < 3*NumObjects; ++AllocId)
+        {
+            Allocs.push_back(PushSize(&Arena, 48));
+        }
+        Check(TestCountSlabs(Class->FullSlabs) == 3);
+        Check(!Class->PartialSlabs && !Class->EmptySlab);
+
+        void* Freed = Allocs[NumObjects + 5];
+        FreeSize(&Arena, Freed);
+        Check(TestCountSlabs(Class->PartialSlabs) == 1);
+        Check(PushSize(&Arena, 48) == Freed);
+        Check(TestCountSlabs(Class->FullSlabs) == 3);
+
+        // NOTE: First empty slab is kept, the second goes back to the platform arena
+        u32 NumPlatformFree = TestCountPlatformFree(&PlatformArena);
+        for (u32 AllocId = 0; AllocId < 2*NumObjects; ++AllocId)
+        {
+            FreeSize(&Arena, Allocs[AllocId]);
+        }
+        Check(Class->EmptySlab);
+        Check(TestCountSlabs(Class->FullSlabs) == 1);
+        Check(TestCountPlatformFree(&PlatformArena) == NumPlatformFree + 1);
+
+        // NOTE: The cached slab is the next one we push into
+        slab_header* EmptySlab = Class->EmptySlab;
+        void* Reused = PushSize(&Arena, 48);
+        Check(PlatformBlockArenaGetBlock(&PlatformArena, Reused) == (block*)EmptySlab - 1);
+        Check(!Class->EmptySlab);
+        ArenaClear(&Arena);
+    }
+
+    // NOTE: Random pushes and frees across classes never hand out the same memory twice
+    {
+        std::vector<test_alloc> Allocs;
+        u32 RandomState = 3;
+        for (u32 OpId = 0; OpId < 20000; ++OpId)
+        {
+            if (Allocs.empty() || TestRandom(&RandomState) % 3 != 0)
+            {
+                test_alloc Alloc = {};
+                Alloc.Size = 4 + TestRandom(&RandomState) % (MaxSize - 4);
+                Alloc.Value = TestRandom(&RandomState);
+                Alloc.Mem = (u32*)PushSize(&Arena, Alloc.Size);
+                Check(Alloc.Mem);
+                Alloc.Mem[0] = Alloc.Value;
+                Alloc.Mem[Alloc.Size / sizeof(u32) - 1] = Alloc.Value;
+                Allocs.push_back(Alloc);
+            }
+            else
+            {
+                u32 AllocId = TestRandom(&RandomState) % u32(Allocs.size());
+                test_alloc Alloc = Allocs[AllocId];
+                Check(Alloc.Mem[0] == Alloc.Value && Alloc.Mem[Alloc.Size / sizeof(u32) - 1] == Alloc.Value);
+                FreeSize(&Arena, Alloc.Mem);
+                Allocs[AllocId] = Allocs.back();
+                Allocs.pop_back();
+            }
+        }
+
+        for (test_alloc& Alloc : Allocs)
+        {
+            Check(Alloc.Mem[0] == Alloc.Value && Alloc.Mem[Alloc.Size / sizeof(u32) - 1] == Alloc.Value);
+            FreeSize(&Arena, Alloc.Mem);
+        }
+        for (u32 ClassId = 0; ClassId < Arena.NumClasses; ++ClassId)
+        {
+            Check(!Arena.Classes[ClassId].PartialSlabs && !Arena.Classes[ClassId].FullSlabs);
+        }
+        ArenaClear(&Arena);
+    }
+
+    ArenaClear(&PlatformArena);
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "memory_test.h"
+
+#include <vector>
+
+struct test_row
+{
+    f32 A;
+    u8 B;
+    u64 C;
+};
+
+int main()
+{
+    linear_arena LinearArena = LinearArenaReserve(MegaBytes(64));
+    dynamic_arena DynamicArena = DynamicArenaCreate(KiloBytes(64));
+    auto Rows = SoaCreate<f32, u8, u64>(&LinearArena);
+    auto Pairs = SoaCreate<u16, f64>(&DynamicArena, 10);
+
+    // NOTE: Random push/swap remove against a std::vector, both arrays grow well past their first block
+    std::vector<test_row> Expected;
+    u32 RandomState = 7;
+    f64 ExpectedSum = 0;
+    for (u32 Step = 0; Step < 50000; ++Step)
+    {
+        if (Expected.empty() || TestRandom(&RandomState) % 4)
+        {
+            test_row Row = { f32(Step), u8(Step), u64(Step)*3 };
+            mm Index = SoaPush(&Rows, Row.A, Row.B, Row.C);
+            Check(Index == Expected.size());
+            Expected.push_back(Row);
+            
+            SoaPush(&Pairs, u16(Step), f64(Step));
+            ExpectedSum += f64(Step);
+        }
+        else
+        {
+            mm Index = TestRandom(&RandomState) % Expected.size();
+            SoaSwapRemove(&Rows, Index);
+            Expected[Index] = Expected.back();
+            Expected.pop_back();
+        }
+    }
+    Check(Rows.NumElements == Expected.size());
+    Check(Rows.Capacity >= Rows.NumElements && Pairs.Capacity >= Pairs.NumElements && Pairs.NumElements > 10);
+
+    Check((mm(SoaColumn<0>(&Rows)) & (SOA_ARRAY_COLUMN_ALIGNMENT - 1)) == 0);
+    Check((mm(SoaColumn<1>(&Rows)) & (SOA_ARRAY_COLUMN_ALIGNMENT - 1)) == 0);
+    Check((mm(SoaColumn<2>(&Rows)) & (SOA_ARRAY_COLUMN_ALIGNMENT - 1)) == 0);
+    Check((mm(SoaColumn<1>(&Pairs)) & (SOA_ARRAY_COLUMN_ALIGNMENT - 1)) == 0);
+
+    for (mm RowId = 0; RowId < Expected.size(); ++RowId)
+    {
+        Check(SoaGet<0>(&Rows, RowId) == Expected[RowId].A);
+        Check(SoaGet<1>(&Rows, RowId) == Expected[RowId].B);
+        Check(SoaGet<2>(&Rows, RowId) == Expected[RowId].C);
+    }
+
+    f64 Sum = 0;
+    f64* Column = SoaColumn<1>(&Pairs);
+    for (mm RowId = 0; RowId < Pairs.NumElements; ++RowId)
+    {
+        Sum += Column[RowId];
+    }
+    Check(Sum == ExpectedSum);
+
+    SoaClear(&Rows);
+    Check(Rows.NumElements == 0);
+    
+    LinearArenaRelease(&LinearArena);
+    DynamicArenaRelease(&DynamicArena);
+    return 0;
+}
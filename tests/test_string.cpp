@@ -0,0 +1,59 @@
+#include "memory_test.h"
+
+#include <string.h>
+
+int main()
+{
+    // NOTE: Small commit size so formatted pushes cross commit boundaries
+    linear_arena LinearArena = LinearArenaReserve(MegaBytes(64), KiloBytes(4));
+    
+    char* Chars = PushString(&LinearArena, "hello");
+    Check(strcmp(Chars, "hello") == 0);
+    
+    memory_string String = PushString(&LinearArena, MemoryString("world!", 5));
+    Check(String.Length == 5 && strcmp(String.Chars, "world") == 0);
+    
+    char* Prefixed = PushStringPrefixed(&LinearArena, MemoryString("prefixed"));
+    Check(StringPrefixedGetLength(Prefixed) == 8 && strcmp(Prefixed, "prefixed") == 0);
+    Check(StringPrefixedGetString(Prefixed) == MemoryString("prefixed"));
+
+    for (i32 Id = 0; Id < 2000; ++Id)
+    {
+        memory_string Formatted = PushStringF(&LinearArena, "value %d and %s %0*d", Id, "text", Id % 300, 7);
+        char Expected[512];
+        i32 ExpectedLength = snprintf(Expected, sizeof(Expected), "value %d and %s %0*d", Id, "text", Id % 300, 7);
+        Check(Formatted.Length == mm(ExpectedLength) && strcmp(Formatted.Chars, Expected) == 0);
+    }
+    LinearArenaRelease(&LinearArena);
+
+    dynamic_arena DynamicArena = DynamicArenaCreate(KiloBytes(4));
+    memory_string Formatted = PushStringF(&DynamicArena, "%s-%d", "dynamic", 42);
+    Check(Formatted == MemoryString("dynamic-42"));
+
+    // NOTE: Interning hands out one id per distinct string and keeps them valid while the tables grow
+    auto Table = StringInternTableCreate(&DynamicArena);
+    u32 Ids[5000];
+    for (u32 Id = 0; Id < 5000; ++Id)
+    {
+        char Key[32];
+        snprintf(Key, sizeof(Key), "key%u", Id % 1000);
+        Ids[Id] = StringIntern(&Table, Key);
+    }
+    Check(Table.NumStrings == 1000);
+    
+    for (u32 Id = 0; Id < 5000; ++Id)
+    {
+        char Key[32];
+        snprintf(Key, sizeof(Key), "key%u", Id % 1000);
+        Check(Ids[Id] == Ids[Id % 1000]);
+        Check(StringInternGet(&Table, Ids[Id]) == MemoryString(Key));
+    }
+
+    u32 FoundId = 0;
+    Check(StringInternFind(&Table, MemoryString("key5"), &FoundId) && FoundId == Ids[5]);
+    Check(!StringInternFind(&Table, MemoryString("missing"), &FoundId));
+    Check(StringInternGet(&Table, Ids[7]).Chars == StringInternGet(&Table, StringIntern(&Table, "key7")).Chars);
+    
+    DynamicArenaRelease(&DynamicArena);
+    return 0;
+}
@@ -0,0 +1,278 @@
+#include "memory_test.h"
+
+#include <string.h>
+#include <vector>
+
+struct test_alloc
+{
+    u8* Mem;
+    mm Size;
+    u8 Value;
+};
+
+inline mm TestPoolFirstBlockOffset()
+{
+    mm Result = AlignAddress(u64(sizeof(tlsf_pool)), u64(TLSF_ALIGNMENT));
+    return Result;
+}
+
+// NOTE: Walks every pool and every free list and checks they agree, returns the number of free blocks
+static u32 TestCheckTlsf(tlsf_arena* Arena)
+{
+    u32 NumPhysicalFree = 0;
+    for (tlsf_pool* Pool = Arena->Pools; Pool; Pool = Pool->Next)
+    {
+        tlsf_block* Block = (tlsf_block*)((u8*)Pool + TestPoolFirstBlockOffset());
+        Check(!(Block->Size & TLSF_BLOCK_PREV_FREE));
+        b32 PrevFree = false;
+        tlsf_block* Prev = 0;
+        while (TlsfBlockGetSize(Block))
+        {
+            Check((u8*)Block < (u8*)Pool + Pool->Size);
+            Check(GetAlignOffset(TlsfBlockGetPayload(Block), TLSF_ALIGNMENT) == 0);
+            Check(TlsfBlockGetSize(Block) >= TLSF_MIN_BLOCK_SIZE);
+            Check(!!(Block->Size & TLSF_BLOCK_PREV_FREE) == PrevFree);
+
+            b32 IsFree = !!(Block->Size & TLSF_BLOCK_FREE);
+            if (PrevFree)
+            {
+                Check(Block->PrevPhysical == Prev);
+
+                // NOTE: Free neighbours always get merged
+                Check(!IsFree);
+            }
+            NumPhysicalFree += IsFree ? 1 : 0;
+
+            PrevFree = IsFree;
+            Prev = Block;
+            Block = TlsfBlockGetNext(Block);
+        }
+
+        // NOTE: Sentinel is always used and ends the pool
+        Check(!(Block->Size & TLSF_BLOCK_FREE));
+        Check(!!(Block->Size & TLSF_BLOCK_PREV_FREE) == PrevFree);
+        Check((u8*)Block + TLSF_BLOCK_OVERHEAD <= (u8*)Pool + Pool->Size);
+    }
+
+    u32 NumListFree = 0;
+    for (u32 Fl = 0; Fl < TLSF_FL_COUNT; ++Fl)
+    {
+        Check(!!(Arena->FlBitmap & (u64(1) << Fl)) == !!Arena->SlBitmaps[Fl]);
+        for (u32 Sl = 0; Sl < TLSF_SL_COUNT; ++Sl)
+        {
+            Check(!!(Arena->SlBitmaps[Fl] & (1u << Sl)) == !!Arena->FreeLists[Fl][Sl]);
+            tlsf_block* PrevFree = 0;
+            for (tlsf_block* Block = Arena->FreeLists[Fl][Sl]; Block; PrevFree = Block, Block = Block->NextFree)
+            {
+                Check(Block->Size & TLSF_BLOCK_FREE);
+                Check(Block->PrevFree == PrevFree);
+
+                u32 BlockFl, BlockSl;
+                TlsfMappingInsert(TlsfBlockGetSize(Block), &BlockFl, &BlockSl);
+                Check(BlockFl == Fl && BlockSl == Sl);
+                NumListFree += 1;
+            }
+        }
+    }
+
+    Check(NumListFree == NumPhysicalFree);
+    return NumListFree;
+}
+
+inline u32 TestCountPools(tlsf_arena* Arena)
+{
+    u32 Result = 0;
+    for (tlsf_pool* Pool = Arena->Pools; Pool; Pool = Pool->Next)
+    {
+        Result += 1;
+    }
+    return Result;
+}
+
+int main()
+{
+    // NOTE: Frees coalesce in any order until the pool is one free block again
+    {
+        tlsf_arena Arena = TlsfArenaCreate(KiloBytes(64));
+        u8* A = (u8*)PushSize(&Arena, 100);
+        u8* B = (u8*)PushSize(&Arena, 200);
+        u8* C = (u8*)PushSize(&Arena, 300);
+        u8* D = (u8*)PushSize(&Arena, 400);
+        Check(A && B && C && D);
+        Check(TestCountPools(&Arena) == 1);
+        Check(TestCheckTlsf(&Arena) == 1);
+
+        FreeSize(&Arena, B);
+        Check(TestCheckTlsf(&Arena) == 2);
+        FreeSize(&Arena, D);
+        Check(TestCheckTlsf(&Arena) == 2);
+        FreeSize(&Arena, A);
+        Check(TestCheckTlsf(&Arena) == 2);
+        FreeSize(&Arena, C);
+        Check(TestCheckTlsf(&Arena) == 1);
+
+        // NOTE: The whole pool fits again without mapping a new one
+        mm PoolBlockSize = TlsfBlockGetSize((tlsf_block*)((u8*)Arena.Pools + TestPoolFirstBlockOffset()));
+        u8* All = (u8*)PushSize(&Arena, PoolBlockSize / 2);
+        Check(All == A);
+        Check(TestCountPools(&Arena) == 1);
+        FreeSize(&Arena, All);
+
+        ArenaClear(&Arena);
+        Check(!Arena.Pools && !Arena.FlBitmap);
+    }
+
+    // NOTE: Realloc grows into a free neighbour in place, shrinks in place, and moves the data when it has to
+    {
+        tlsf_arena Arena = TlsfArenaCreate(KiloBytes(64));
+        u8* A = (u8*)PushSize(&Arena, 64);
+        u8* B = (u8*)PushSize(&Arena, 64);
+        u8* C = (u8*)PushSize(&Arena, 64);
+        for (u32 ByteId = 0; ByteId < 64; ++ByteId)
+        {
+            A[ByteId] = u8(ByteId);
+        }
+
+        FreeSize(&Arena, B);
+        Check(ReallocSize(&Arena, A, 128) == A);
+        TestCheckTlsf(&Arena);
+        Check(ReallocSize(&Arena, A, 32) == A);
+        TestCheckTlsf(&Arena);
+
+        u8* Moved = (u8*)ReallocSize(&Arena, A, 1000);
+        Check(Moved && Moved != A);
+        for (u32 ByteId = 0; ByteId < 32; ++ByteId)
+        {
+            Check(Moved[ByteId] == u8(ByteId));
+        }
+        TestCheckTlsf(&Arena);
+
+        FreeSize(&Arena, Moved);
+        FreeSize(&Arena, C);
+        Check(TestCheckTlsf(&Arena) == 1);
+        ArenaClear(&Arena);
+    }
+
+    // NOTE: Big alignments split the gap off as its own free block that merges back on free
+    {
+        tlsf_arena Arena = TlsfArenaCreate(KiloBytes(64));
+        void* Small = PushSize(&Arena, 24);
+        mm Alignments[] = { 32, 64, 256, 4096 };
+        void* Aligned[ArrayCount(Alignments)] = {};
+        for (u32 AlignId = 0; AlignId < ArrayCount(Alignments); ++AlignId)
+        {
+            Aligned[AlignId] = PushSizeAligned(&Arena, 40, Alignments[AlignId]);
+            Check(Aligned[AlignId]);
+            Check(GetAlignOffset(Aligned[AlignId], Alignments[AlignId]) == 0);
+            TestCheckTlsf(&Arena);
+        }
+
+        for (u32 AlignId = 0; AlignId < ArrayCount(Alignments); ++AlignId)
+        {
+            FreeSize(&Arena, Aligned[AlignId]);
+            TestCheckTlsf(&Arena);
+        }
+        FreeSize(&Arena, Small);
+        Check(TestCheckTlsf(&Arena) == 1);
+        ArenaClear(&Arena);
+    }
+
+    // NOTE: A full fixed arena returns 0 instead of asserting, and works again once things are freed
+    {
+        linear_arena Linear = LinearArenaReserve(KiloBytes(64), KiloBytes(64));
+        tlsf_arena Arena = TlsfArenaCreate(&Linear, KiloBytes(16));
+        Check(Arena.Pools && !Arena.PoolSize);
+
+        std::vector<void*> Allocs;
+        while (void* Mem = PushSize(&Arena, 1000))
+        {
+            Allocs.push_back(Mem);
+        }
+        Check(Allocs.size() > 8 && Allocs.size() < 16);
+        Check(!PushSize(&Arena, KiloBytes(32)));
+
+        void* Last = Allocs.back();
+        Check(!ReallocSize(&Arena, Last, KiloBytes(8)));
+        Check(TlsfBlockGetSize(TlsfBlockFromPayload(Last)) >= 1000);
+        TestCheckTlsf(&Arena);
+
+        for (void* Mem : Allocs)
+        {
+            FreeSize(&Arena, Mem);
+        }
+        Check(TestCheckTlsf(&Arena) == 1);
+        Check(PushSize(&Arena, KiloBytes(8)));
+
+        // NOTE: A linear arena without room gives us an arena with no pools
+        Check(PushSize(&Linear, KiloBytes(40)));
+        tlsf_arena Empty = TlsfArenaCreate(&Linear, KiloBytes(16));
+        Check(!Empty.Pools);
+        Check(!PushSize(&Empty, 16));
+
+        LinearArenaRelease(&Linear);
+    }
+
+    // NOTE: Random pushes, frees and reallocs keep the free lists and the physical blocks in sync and never clobber data
+    {
+        tlsf_arena Arena = TlsfArenaCreate(KiloBytes(64));
+        std::vector<test_alloc> Allocs;
+        u32 RandomState = 11;
+        mm Alignments[] = { 4, 16, 64, 256 };
+        for (u32 OpId = 0; OpId < 20000; ++OpId)
+        {
+            u32 Op = TestRandom(&RandomState) % 8;
+            if (Allocs.empty() || Op < 4)
+            {
+                test_alloc Alloc = {};
+                Alloc.Size = 1 + TestRandom(&RandomState) % (Op == 0 ? KiloBytes(32) : 512);
+                Alloc.Value = u8(TestRandom(&RandomState));
+                mm Alignment = Alignments[TestRandom(&RandomState) % ArrayCount(Alignments)];
+                Alloc.Mem = (u8*)PushSizeAligned(&Arena, Alloc.Size, Alignment);
+                Check(Alloc.Mem);
+                Check(GetAlignOffset(Alloc.Mem, Alignment) == 0);
+                memset(Alloc.Mem, Alloc.Value, Alloc.Size);
+                Allocs.push_back(Alloc);
+            }
+            else
+            {
+                u32 AllocId = TestRandom(&RandomState) % u32(Allocs.size());
+                test_alloc* Alloc = &Allocs[AllocId];
+                Check(Alloc->Mem[0] == Alloc->Value && Alloc->Mem[Alloc->Size - 1] == Alloc->Value);
+
+                if (Op < 7)
+                {
+                    FreeSize(&Arena, Alloc->Mem);
+                    *Alloc = Allocs.back();
+                    Allocs.pop_back();
+                }
+                else
+                {
+                    mm NewSize = 1 + TestRandom(&RandomState) % 2048;
+                    Alloc->Mem = (u8*)ReallocSize(&Arena, Alloc->Mem, NewSize);
+                    Check(Alloc->Mem);
+                    for (mm ByteId = 0; ByteId < Min(NewSize, Alloc->Size); ++ByteId)
+                    {
+                        Check(Alloc->Mem[ByteId] == Alloc->Value);
+                    }
+                    Alloc->Size = NewSize;
+                    memset(Alloc->Mem, Alloc->Value, Alloc->Size);
+                }
+            }
+
+            if (OpId % 64 == 0)
+            {
+                TestCheckTlsf(&Arena);
+            }
+        }
+
+        for (test_alloc& Alloc : Allocs)
+        {
+            Check(Alloc.Mem[0] == Alloc.Value && Alloc.Mem[Alloc.Size - 1] == Alloc.Value);
+            FreeSize(&Arena, Alloc.Mem);
+        }
+        Check(TestCheckTlsf(&Arena) == TestCountPools(&Arena));
+        ArenaClear(&Arena);
+    }
+
+    return 0;
+}